@@ -9,6 +9,7 @@ COMPONENT_SRCDIRS := ./src \
                      ./src/proto/fd \
                      ./src/proto/light \
                      ./src/proto/crc \
+                     ./src/proto/lz \
                      ./src/link \
                      ./src/interface \
 
@@ -21,5 +22,7 @@ CPPFLAGS += \
 CPPFLAGS += \
             -DCONFIG_ENABLE_FCS32 \
             -DCONFIG_ENABLE_FCS16 \
+            -DCONFIG_ENABLE_FCS32C \
             -DCONFIG_ENABLE_CHECKSUM \
-            -DCONFIG_ENABLE_STATS
+            -DCONFIG_ENABLE_STATS \
+            -DCONFIG_ENABLE_ACCM
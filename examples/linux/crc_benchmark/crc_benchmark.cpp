@@ -0,0 +1,122 @@
+/*
+    Copyright 2025 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * This is micro-benchmark for software crc kernels. The executable is built
+ * once per CONFIG_TINY_CRC_SLICING variant (crc_benchmark_nibble, crc_benchmark_byte,
+ * crc_benchmark_slice4, ...), crc_benchmark_hw uses carry-less multiply and crc32c
+ * instructions when the cpu supports them. "make crc_benchmark" runs all of them.
+ * On x86 cpus throughput is reported in bytes per TSC cycle, on other cpus in bytes per nanosecond.
+ *
+ * Usage: crc_benchmark_<variant> [-s buffer_size] [-t seconds]
+ */
+
+#include "proto/crc/tiny_crc.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CRC_BENCHMARK_TSC 1
+#endif
+
+#ifndef CRC_VARIANT_NAME
+#define CRC_VARIANT_NAME "default"
+#endif
+
+static int s_buffer_size = 4096;
+static double s_duration = 0.3;
+
+static volatile uint32_t s_sink;
+
+static uint64_t ticks()
+{
+#if defined(CRC_BENCHMARK_TSC)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+template <typename F> static void run(const char *name, const std::vector<uint8_t> &data, F crc)
+{
+    uint64_t bytes = 0;
+    uint64_t spent = 0;
+    auto start = std::chrono::steady_clock::now();
+    while ( std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < s_duration )
+    {
+        uint64_t t0 = ticks();
+        for ( int i = 0; i < 16; i++ )
+        {
+            s_sink = s_sink + crc(data.data(), (int)data.size());
+        }
+        spent += ticks() - t0;
+        bytes += 16 * data.size();
+    }
+#if defined(CRC_BENCHMARK_TSC)
+    printf("%-8s %-6s %8d bytes: %6.3f bytes/cycle\n", CRC_VARIANT_NAME, name, (int)data.size(),
+           (double)bytes / spent);
+#else
+    printf("%-8s %-6s %8d bytes: %6.3f bytes/ns\n", CRC_VARIANT_NAME, name, (int)data.size(), (double)bytes / spent);
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( !strcmp(argv[i], "-s") && i + 1 < argc )
+        {
+            s_buffer_size = atoi(argv[++i]);
+        }
+        else if ( !strcmp(argv[i], "-t") && i + 1 < argc )
+        {
+            s_duration = atof(argv[++i]);
+        }
+        else
+        {
+            printf("Usage: %s [-s buffer_size] [-t seconds]\n", argv[0]);
+            return 1;
+        }
+    }
+    std::vector<uint8_t> data(s_buffer_size);
+    for ( size_t i = 0; i < data.size(); i++ )
+    {
+        data[i] = (uint8_t)(i * 131 + 7);
+    }
+#ifdef CONFIG_ENABLE_CHECKSUM
+    run("crc8", data, [](const uint8_t *p, int len) { return (uint32_t)tiny_chksum(INITCHECKSUM, p, len); });
+#endif
+#ifdef CONFIG_ENABLE_FCS16
+    run("crc16", data, [](const uint8_t *p, int len) { return (uint32_t)tiny_crc16(PPPINITFCS16, p, len); });
+#endif
+#ifdef CONFIG_ENABLE_FCS32
+    run("crc32", data, [](const uint8_t *p, int len) { return (uint32_t)tiny_crc32(PPPINITFCS32, p, len); });
+#endif
+#ifdef CONFIG_ENABLE_FCS32C
+    run("crc32c", data, [](const uint8_t *p, int len) { return (uint32_t)tiny_crc32c(PPPINITFCS32C, p, len); });
+#endif
+    return 0;
+}
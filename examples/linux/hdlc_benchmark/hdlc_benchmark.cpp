@@ -0,0 +1,273 @@
+/*
+    Copyright 2025 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * This is throughput benchmark for low level HDLC framing. It encodes and decodes
+ * frames with different payload profiles completely in memory, so the numbers
+ * reflect only the cost of byte stuffing and crc calculation. Rows marked "C++"
+ * show the same work, done by compile-time specialized tinyproto::HdlcCodec.
+ *
+ * Usage: hdlc_benchmark [-s frame_size] [-c chunk_size] [-t seconds]
+ */
+
+#include "proto/hdlc/low_level/hdlc.h"
+#include "TinyHdlcCodec.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/** Maximum frame size for HdlcCodec rows, since codec mtu is template parameter */
+static constexpr int CODEC_MTU = 16384;
+
+static int s_frame_size = 4096;
+static int s_chunk_size = 1024;
+static double s_duration = 0.5;
+
+struct Profile
+{
+    const char *name;
+    void (*fill)(std::vector<uint8_t> &data);
+};
+
+static void fill_clean(std::vector<uint8_t> &data)
+{
+    for ( size_t i = 0; i < data.size(); i++ )
+    {
+        data[i] = (uint8_t)('A' + i % 26);
+    }
+}
+
+static void fill_random(std::vector<uint8_t> &data)
+{
+    srand(1);
+    for ( size_t i = 0; i < data.size(); i++ )
+    {
+        data[i] = (uint8_t)rand();
+    }
+}
+
+static void fill_worst(std::vector<uint8_t> &data)
+{
+    for ( size_t i = 0; i < data.size(); i++ )
+    {
+        data[i] = (i & 1) ? 0x7E : 0x7D;
+    }
+}
+
+static void on_frame_read(void *user_data, uint8_t *, int)
+{
+    *(int *)user_data += 1;
+}
+
+static double mbytes_per_sec(uint64_t bytes, std::chrono::steady_clock::duration elapsed)
+{
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0 ? (double)bytes / seconds / 1000000.0 : 0;
+}
+
+static void run_profile(const Profile &profile, hdlc_crc_t crc, const char *crc_name)
+{
+    std::vector<uint8_t> payload(s_frame_size);
+    profile.fill(payload);
+    std::vector<uint8_t> hdlc_buf(hdlc_ll_get_buf_size_ex(s_frame_size, crc, 1));
+    std::vector<uint8_t> encoded(s_frame_size * 2 + 16);
+    int frames_received = 0;
+
+    hdlc_ll_init_t init{};
+    init.on_frame_read = on_frame_read;
+    init.user_data = &frames_received;
+    init.buf = hdlc_buf.data();
+    init.buf_size = (int)hdlc_buf.size();
+    init.crc_type = crc;
+    init.mtu = s_frame_size;
+    hdlc_ll_handle_t handle = nullptr;
+    if ( hdlc_ll_init(&handle, &init) != TINY_SUCCESS )
+    {
+        fprintf(stderr, "Failed to initialize hdlc\n");
+        exit(1);
+    }
+
+    // Encoding
+    uint64_t payload_bytes = 0;
+    int encoded_len = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = start - start;
+    do
+    {
+        for ( int i = 0; i < 16; i++ )
+        {
+            hdlc_ll_put_frame(handle, payload.data(), (int)payload.size());
+            encoded_len = 0;
+            for ( ;; )
+            {
+                int chunk = std::min(s_chunk_size, (int)encoded.size() - encoded_len);
+                int len = hdlc_ll_run_tx(handle, encoded.data() + encoded_len, chunk);
+                if ( len <= 0 )
+                {
+                    break;
+                }
+                encoded_len += len;
+            }
+            payload_bytes += payload.size();
+        }
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while ( std::chrono::duration<double>(elapsed).count() < s_duration );
+    double tx_speed = mbytes_per_sec(payload_bytes, elapsed);
+
+    // Decoding
+    payload_bytes = 0;
+    frames_received = 0;
+    start = std::chrono::steady_clock::now();
+    do
+    {
+        for ( int i = 0; i < 16; i++ )
+        {
+            int pos = 0;
+            while ( pos < encoded_len )
+            {
+                int len = std::min(s_chunk_size, encoded_len - pos);
+                pos += hdlc_ll_run_rx(handle, encoded.data() + pos, len, nullptr);
+            }
+            payload_bytes += payload.size();
+        }
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while ( std::chrono::duration<double>(elapsed).count() < s_duration );
+    double rx_speed = mbytes_per_sec(payload_bytes, elapsed);
+
+    if ( frames_received == 0 )
+    {
+        fprintf(stderr, "Decoder failed to receive frames for %s profile\n", profile.name);
+    }
+    printf("%-8s %-6s %-4s %8d %10.1f %10.1f\n", profile.name, crc_name, "C", encoded_len, tx_speed, rx_speed);
+    hdlc_ll_close(handle);
+}
+
+template <hdlc_crc_t Crc> static void run_codec_profile(const Profile &profile, const char *crc_name)
+{
+    typedef tinyproto::HdlcCodec<Crc, CODEC_MTU> Codec;
+    if ( s_frame_size > CODEC_MTU )
+    {
+        return;
+    }
+    std::vector<uint8_t> payload(s_frame_size);
+    profile.fill(payload);
+    std::vector<uint8_t> encoded(s_frame_size * 2 + 16);
+    std::unique_ptr<Codec> codec(new Codec());
+    int frames_received = 0;
+
+    // Encoding
+    uint64_t payload_bytes = 0;
+    int encoded_len = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = start - start;
+    do
+    {
+        for ( int i = 0; i < 16; i++ )
+        {
+            encoded_len = Codec::encode(payload.data(), (int)payload.size(), encoded.data(), (int)encoded.size());
+            payload_bytes += payload.size();
+        }
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while ( std::chrono::duration<double>(elapsed).count() < s_duration );
+    double tx_speed = mbytes_per_sec(payload_bytes, elapsed);
+
+    // Decoding
+    payload_bytes = 0;
+    start = std::chrono::steady_clock::now();
+    do
+    {
+        for ( int i = 0; i < 16; i++ )
+        {
+            for ( int pos = 0; pos < encoded_len; pos += s_chunk_size )
+            {
+                int len = std::min(s_chunk_size, encoded_len - pos);
+                frames_received += codec->decode(encoded.data() + pos, len, [](uint8_t *, int) {});
+            }
+            payload_bytes += payload.size();
+        }
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while ( std::chrono::duration<double>(elapsed).count() < s_duration );
+    double rx_speed = mbytes_per_sec(payload_bytes, elapsed);
+
+    if ( frames_received == 0 )
+    {
+        fprintf(stderr, "Codec failed to receive frames for %s profile\n", profile.name);
+    }
+    printf("%-8s %-6s %-4s %8d %10.1f %10.1f\n", profile.name, crc_name, "C++", encoded_len, tx_speed, rx_speed);
+}
+
+static int parse_args(int argc, char *argv[])
+{
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( i + 1 >= argc )
+        {
+            return -1;
+        }
+        if ( !strcmp(argv[i], "-s") )
+        {
+            s_frame_size = atoi(argv[++i]);
+        }
+        else if ( !strcmp(argv[i], "-c") )
+        {
+            s_chunk_size = atoi(argv[++i]);
+        }
+        else if ( !strcmp(argv[i], "-t") )
+        {
+            s_duration = atof(argv[++i]);
+        }
+        else
+        {
+            return -1;
+        }
+    }
+    return s_frame_size > 0 && s_chunk_size > 0 ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    if ( parse_args(argc, argv) < 0 )
+    {
+        fprintf(stderr, "Usage: %s [-s frame_size] [-c chunk_size] [-t seconds]\n", argv[0]);
+        return 1;
+    }
+    const Profile profiles[] = {
+        {"clean", fill_clean},
+        {"random", fill_random},
+        {"worst", fill_worst},
+    };
+    printf("frame size %d bytes, tx/rx chunk %d bytes\n", s_frame_size, s_chunk_size);
+    printf("%-8s %-6s %-4s %8s %10s %10s\n", "payload", "crc", "impl", "encoded", "TX MB/s", "RX MB/s");
+    for ( const Profile &profile : profiles )
+    {
+        run_profile(profile, HDLC_CRC_OFF, "none");
+        run_codec_profile<HDLC_CRC_OFF>(profile, "none");
+        run_profile(profile, HDLC_CRC_16, "fcs16");
+        run_codec_profile<HDLC_CRC_16>(profile, "fcs16");
+        run_profile(profile, HDLC_CRC_32, "fcs32");
+        run_codec_profile<HDLC_CRC_32>(profile, "fcs32");
+        run_profile(profile, HDLC_CRC_32C, "fcs32c");
+        run_codec_profile<HDLC_CRC_32C>(profile, "fcs32c");
+    }
+    return 0;
+}
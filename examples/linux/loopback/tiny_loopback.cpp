@@ -58,7 +58,7 @@ static void print_help()
     fprintf(stderr, "    -c <crc>, --crc <crc>      crc type: 0, 8, 16, 32\n");
     fprintf(stderr, "    -g, --generator            turn on packet generating\n");
     fprintf(stderr, "    -s, --size                 packet size: 32 (by default)\n");
-    fprintf(stderr, "    -w, --window               window size: 7 (by default)\n");
+    fprintf(stderr, "    -w, --window               window size: 7 (by default), sizes above 7 use extended mode\n");
     fprintf(stderr, "    -r, --run-test             run 15 seconds speed test\n");
     fprintf(stderr, "    -a, --arduino-tty          delay test start by 2 seconds for Arduino ttyUSB interfaces\n");
 }
@@ -113,9 +113,9 @@ static int parse_args(int argc, char *argv[])
             if ( ++i >= argc )
                 return -1;
             s_windowSize = strtoul(argv[i], nullptr, 10);
-            if ( s_windowSize < 1 || s_windowSize > 7 )
+            if ( s_windowSize < 1 || s_windowSize > 127 )
             {
-                fprintf(stderr, "Allowable window size is between 1 and 7 inclusively\n");
+                fprintf(stderr, "Allowable window size is between 1 and 127 inclusively\n");
                 return -1;
                 return -1;
             }
@@ -437,7 +437,7 @@ static int Fd_set_crc(Fd *self, PyObject *value)
     if ( value && PyLong_Check(value) )
     {
         int temp = PyLong_AsLong(value);
-        if ( temp == HDLC_CRC_16 || temp == HDLC_CRC_32 ||
+        if ( temp == HDLC_CRC_16 || temp == HDLC_CRC_32 || temp == HDLC_CRC_32C ||
              temp == HDLC_CRC_8 || temp == HDLC_CRC_OFF ||
              temp == HDLC_CRC_DEFAULT )
         {
@@ -447,7 +447,7 @@ static int Fd_set_crc(Fd *self, PyObject *value)
     }
     if ( result < 0 )
     {
-        PyErr_Format(PyExc_RuntimeError, "Allowable CRC values are: 0 (AUTO), 8, 16, 32, 255 (OFF)");
+        PyErr_Format(PyExc_RuntimeError, "Allowable CRC values are: 0 (AUTO), 8, 16, 32, 33 (32C), 255 (OFF)");
     }
     return result/* 0 on success, -1 on failure with error set. */;
 }
@@ -0,0 +1,396 @@
+/*
+    Copyright 2025 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/**
+ This is header-only HDLC framing codec for C++ users
+
+ @file
+ @brief Compile-time specialized HDLC codec
+
+*/
+#pragma once
+
+#include "hal/tiny_types.h"
+#include "proto/crc/tiny_crc.h"
+#include "proto/hdlc/low_level/hdlc_scan_int.h"
+
+#include <stdint.h>
+#include <string.h>
+
+namespace tinyproto
+{
+
+/**
+ * @ingroup HDLC_LOW_LEVEL_API
+ * @{
+ */
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+/**
+ * Frame check sequence, selected at compile time.
+ * field() returns value of the crc field for the payload, check() checks the frame
+ * together with its crc field, using the same residue constants as hdlc_ll.
+ */
+template <hdlc_crc_t Crc> struct HdlcCodecCrc
+{
+    static_assert(Crc == HDLC_CRC_OFF, "crc type is not supported or not enabled in library configuration");
+    static constexpr int size = 0;
+
+    static uint32_t field(const uint8_t *, int)
+    {
+        return 0;
+    }
+
+    static bool check(const uint8_t *, int)
+    {
+        return true;
+    }
+};
+
+#ifdef CONFIG_ENABLE_CHECKSUM
+template <> struct HdlcCodecCrc<HDLC_CRC_8>
+{
+    static constexpr int size = 1;
+
+    static uint32_t field(const uint8_t *data, int len)
+    {
+        return (uint16_t)(0xFFFF - tiny_chksum_update(INITCHECKSUM, data, len));
+    }
+
+    static bool check(const uint8_t *data, int len)
+    {
+        return (tiny_chksum_update(INITCHECKSUM, data, len) & 0xFF) == 0xFF;
+    }
+};
+#endif
+
+#ifdef CONFIG_ENABLE_FCS16
+template <> struct HdlcCodecCrc<HDLC_CRC_16>
+{
+    static constexpr int size = 2;
+
+    static uint32_t field(const uint8_t *data, int len)
+    {
+        return (uint16_t)(tiny_crc16_update(PPPINITFCS16, data, len) ^ 0xFFFF);
+    }
+
+    static bool check(const uint8_t *data, int len)
+    {
+        return tiny_crc16_update(PPPINITFCS16, data, len) == PPPGOODFCS16;
+    }
+};
+#endif
+
+#ifdef CONFIG_ENABLE_FCS32
+template <> struct HdlcCodecCrc<HDLC_CRC_32>
+{
+    static constexpr int size = 4;
+
+    static uint32_t field(const uint8_t *data, int len)
+    {
+        return tiny_crc32_update(PPPINITFCS32, data, len) ^ 0xFFFFFFFF;
+    }
+
+    static bool check(const uint8_t *data, int len)
+    {
+        return tiny_crc32_update(PPPINITFCS32, data, len) == PPPGOODFCS32;
+    }
+};
+#endif
+
+#ifdef CONFIG_ENABLE_FCS32C
+template <> struct HdlcCodecCrc<HDLC_CRC_32C>
+{
+    static constexpr int size = 4;
+
+    static uint32_t field(const uint8_t *data, int len)
+    {
+        return tiny_crc32c_update(PPPINITFCS32C, data, len) ^ 0xFFFFFFFF;
+    }
+
+    static bool check(const uint8_t *data, int len)
+    {
+        return tiny_crc32c_update(PPPINITFCS32C, data, len) == PPPGOODFCS32C;
+    }
+};
+#endif
+
+#endif
+
+/**
+ * HdlcCodec implements the same framing as hdlc_ll functions (RFC 1662), and is
+ * wire-compatible with them, but crc type, mtu and rx window are template
+ * parameters. There are no state callbacks and no runtime crc type checks, so
+ * the compiler can inline the complete encode and decode loops.
+ *
+ * @tparam Crc crc type, HDLC_CRC_DEFAULT is not accepted
+ * @tparam Mtu maximum payload size in bytes
+ * @tparam RxWindow number of frames, which can be kept by decoder: received frame
+ *         remains valid until RxWindow - 1 next frames are received.
+ */
+template <hdlc_crc_t Crc, int Mtu, int RxWindow = 1> class HdlcCodec
+{
+    static_assert(Crc != HDLC_CRC_DEFAULT, "crc type must be specified explicitly");
+    static_assert(Mtu > 0, "mtu must be positive");
+    static_assert(RxWindow > 0 && RxWindow <= 255, "rx window must be in range 1 - 255");
+
+    using CrcField = HdlcCodecCrc<Crc>;
+
+public:
+    /** Size of crc field in bytes */
+    static constexpr int CrcSize = CrcField::size;
+
+    /** Size of the buffer, enough to encode any frame up to Mtu bytes */
+    static constexpr int MaxEncodedSize = 2 + 2 * (Mtu + CrcSize);
+
+    /**
+     * Encodes frame to the buffer: opening flag, escaped payload and crc field, closing flag.
+     *
+     * @param data pointer to payload
+     * @param len size of payload in bytes, up to Mtu
+     * @param out buffer for encoded frame
+     * @param out_size size of the buffer. MaxEncodedSize is always enough.
+     * @return number of bytes written to out buffer
+     *         TINY_ERR_INVALID_DATA if len is zero or exceeds Mtu
+     *         TINY_ERR_DATA_TOO_LARGE if encoded frame doesn't fit the buffer
+     */
+    static int encode(const void *data, int len, void *out, int out_size)
+    {
+        if ( len <= 0 || len > Mtu || !data )
+        {
+            return TINY_ERR_INVALID_DATA;
+        }
+        const uint8_t *src = static_cast<const uint8_t *>(data);
+        uint8_t *dst = static_cast<uint8_t *>(out);
+        uint8_t *end = dst + out_size;
+        if ( out_size < 2 )
+        {
+            return TINY_ERR_DATA_TOO_LARGE;
+        }
+        *dst++ = Flag;
+        dst = stuff(src, len, dst, end);
+        uint8_t crc[CrcSize > 0 ? CrcSize : 1];
+        uint32_t crc_value = CrcField::field(src, len);
+        for ( int i = 0; i < CrcSize; i++ )
+        {
+            crc[i] = (uint8_t)(crc_value >> (i * 8));
+        }
+        dst = dst ? stuff(crc, CrcSize, dst, end) : nullptr;
+        if ( !dst || dst == end )
+        {
+            return TINY_ERR_DATA_TOO_LARGE;
+        }
+        *dst++ = Flag;
+        return (int)(dst - static_cast<uint8_t *>(out));
+    }
+
+    /**
+     * Decodes incoming bytes. on_frame callable is invoked for each received frame with
+     * valid crc: on_frame(uint8_t *data, int len). Frames with wrong crc and too long frames
+     * are dropped and counted, see getRxErrors().
+     *
+     * @param data pointer to received bytes
+     * @param len number of received bytes
+     * @param on_frame callable to pass received frames to
+     * @return number of received frames
+     */
+    template <typename F> int decode(const void *data, int len, F &&on_frame)
+    {
+        const uint8_t *ptr = static_cast<const uint8_t *>(data);
+        const uint8_t *end = ptr + len;
+        int frames = 0;
+        while ( ptr < end )
+        {
+            if ( m_state != State::Data )
+            {
+                uint8_t byte = *ptr;
+                // Before the first flag everything is skipped, after the frame only fill bytes are skipped,
+                // since the closing flag can be also the opening flag of the next frame.
+                if ( m_state == State::Hunt ? byte != Flag : byte == Fill )
+                {
+                    ptr++;
+                    continue;
+                }
+                m_state = State::Data;
+                m_len = 0;
+                m_escape = false;
+                m_overflow = false;
+                if ( byte == Flag )
+                {
+                    ptr++;
+                    continue;
+                }
+            }
+            uint8_t *frame = m_frames[m_slot];
+            uint8_t byte = *ptr;
+            if ( byte == Flag )
+            {
+                ptr++;
+                // Flags without data between them are not frames
+                if ( m_len == 0 && !m_overflow )
+                {
+                    m_escape = false;
+                    continue;
+                }
+                frames += endFrame(frame, on_frame);
+                continue;
+            }
+            if ( byte == Escape )
+            {
+                // Escape pairs are decoded at once if possible, without scanning
+                if ( ptr + 1 < end && ptr[1] != Flag && ptr[1] != Escape )
+                {
+                    store(frame, ptr[1] ^ EscapeBit);
+                    m_escape = false;
+                    ptr += 2;
+                }
+                else
+                {
+                    m_escape = true;
+                    ptr++;
+                }
+                continue;
+            }
+            if ( m_escape )
+            {
+                store(frame, *ptr++ ^ EscapeBit);
+                m_escape = false;
+                continue;
+            }
+            // All clean bytes up to the next special character are copied at once
+            int run = hdlc_scan_special(ptr, (int)(end - ptr));
+            int size = run < FrameSize - m_len ? run : FrameSize - m_len;
+            memcpy(frame + m_len, ptr, size);
+            m_len += size;
+            m_overflow = m_overflow || size < run;
+            ptr += run;
+        }
+        return frames;
+    }
+
+    /**
+     * Resets decoder state. Decoder skips all bytes until next flag.
+     */
+    void reset()
+    {
+        m_state = State::Hunt;
+    }
+
+    /**
+     * Returns number of frames, dropped by decoder because of wrong crc or size, and
+     * clears the counter.
+     */
+    int getRxErrors()
+    {
+        int errors = m_errors;
+        m_errors = 0;
+        return errors;
+    }
+
+private:
+    static constexpr uint8_t Flag = 0x7E;
+    static constexpr uint8_t Escape = 0x7D;
+    static constexpr uint8_t EscapeBit = 0x20;
+    static constexpr uint8_t Fill = 0xFF;
+    static constexpr int FrameSize = Mtu + CrcSize;
+
+    enum class State : uint8_t
+    {
+        Hunt,
+        Idle,
+        Data,
+    };
+
+    uint8_t m_frames[RxWindow][FrameSize];
+    int m_len = 0;
+    int m_errors = 0;
+    uint8_t m_slot = 0;
+    State m_state = State::Hunt;
+    bool m_escape = false;
+    bool m_overflow = false;
+
+    static uint8_t *stuff(const uint8_t *src, int len, uint8_t *dst, uint8_t *end)
+    {
+        while ( len > 0 )
+        {
+            if ( *src == Flag || *src == Escape )
+            {
+                if ( end - dst < 2 )
+                {
+                    return nullptr;
+                }
+                *dst++ = Escape;
+                *dst++ = *src++ ^ EscapeBit;
+                len--;
+                continue;
+            }
+            int run = hdlc_scan_special(src, len);
+            if ( run > end - dst )
+            {
+                return nullptr;
+            }
+            memcpy(dst, src, run);
+            dst += run;
+            src += run;
+            len -= run;
+        }
+        return dst;
+    }
+
+    void store(uint8_t *frame, uint8_t byte)
+    {
+        if ( m_len < FrameSize )
+        {
+            frame[m_len++] = byte;
+        }
+        else
+        {
+            m_overflow = true;
+        }
+    }
+
+    template <typename F> int endFrame(uint8_t *frame, F &on_frame)
+    {
+        m_state = State::Idle;
+        if ( m_overflow || m_len < CrcSize || !CrcField::check(frame, m_len) )
+        {
+            m_errors++;
+            return 0;
+        }
+        on_frame(frame, m_len - CrcSize);
+        m_slot = m_slot + 1 < RxWindow ? m_slot + 1 : 0;
+        return 1;
+    }
+};
+
+/**
+ * @}
+ */
+
+} // namespace tinyproto
@@ -44,6 +44,7 @@ namespace tinyproto
 void Light::begin(write_block_cb_t writecb, read_block_cb_t readcb)
 {
     m_data.crc_type = m_crc;
+    m_data.framing = m_framing;
     tiny_light_init(&m_data, writecb, readcb, this);
 }
 
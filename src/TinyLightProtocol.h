@@ -212,10 +212,22 @@ public:
      */
     bool enableCrc32();
 
+    /**
+     * Sets framing of the protocol: HDLC_FRAMING_HDLC (default) or HDLC_FRAMING_COBS.
+     * Both sides must use the same framing.
+     * @param framing framing type
+     */
+    void setFraming(hdlc_framing_t framing)
+    {
+        m_framing = framing;
+    }
+
 private:
     STinyLightData m_data{};
 
     hdlc_crc_t m_crc = HDLC_CRC_DEFAULT;
+
+    hdlc_framing_t m_framing = HDLC_FRAMING_HDLC;
 };
 
 /**
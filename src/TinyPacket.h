@@ -299,6 +299,7 @@ private:
     int m_size = 0; // maximum space available for payload data
     int m_len = 0;  // length of payload data
     int m_p = 0;    // current pointer
+    bool m_loaned = false; // m_buf points to the frame, loaned from the link layer
 };
 
 /**
@@ -115,7 +115,7 @@ bool Proto::send(const IPacket &packet, uint32_t timeout)
         if ( !m_multithread )
         {
             m_link->runTx();
-            m_link->runRx();
+            runLinkRx();
         }
     }
     return result;
@@ -165,7 +165,7 @@ IPacket *Proto::read(uint32_t timeout)
         if ( !m_multithread )
         {
             m_link->runTx();
-            m_link->runRx();
+            runLinkRx();
         }
         if ( static_cast<uint32_t>(tiny_millis() - startTs) >= timeout )
         {
@@ -194,6 +194,7 @@ void Proto::end()
         m_readThread = nullptr;
     }
 #endif
+    releaseLoanedFrames();
     m_link->end();
     return;
 }
@@ -241,6 +242,8 @@ void Proto::onRead(uint8_t addr, uint8_t *buf, int len)
         // Copy data if needed
         if ( p->m_size == 0 )
         {
+            // Keep the frame in link layer buffer until the packet is released
+            p->m_loaned = m_link->loanFrame(buf);
             p->m_buf = buf;
             p->m_len = len;
         }
@@ -253,6 +256,11 @@ void Proto::onRead(uint8_t addr, uint8_t *buf, int len)
         p->m_p = 0;
         tiny_events_set( &m_events, PROTO_RX_MESSAGE );
     }
+    if ( m_pool == nullptr )
+    {
+        // Ask remote side to pause until the application releases some packets
+        m_link->setRxReady( false );
+    }
     //printCount( "new Pool", m_pool );
     //printCount( "new Queue", m_queue );
     tiny_mutex_unlock( &m_mutex );
@@ -302,7 +310,7 @@ void Proto::runRx()
     {
         while ( !m_terminate )
         {
-            getLink().runRx();
+            runLinkRx();
         }
     }
 }
@@ -322,12 +330,47 @@ int Proto::getLostRxFrames()
 
 void Proto::release(IPacket *message)
 {
+    if ( message->m_loaned )
+    {
+        // Link layer accepts loaned frames back only in RX thread, so just remember the packet
+        tiny_mutex_lock( &m_mutex );
+        message->m_next = m_released;
+        m_released = message;
+        tiny_mutex_unlock( &m_mutex );
+        return;
+    }
     addRxPool(*message);
 }
 
+void Proto::releaseLoanedFrames()
+{
+    tiny_mutex_lock( &m_mutex );
+    IPacket *p = m_released;
+    m_released = nullptr;
+    tiny_mutex_unlock( &m_mutex );
+    while ( p != nullptr )
+    {
+        IPacket *next = p->m_next;
+        m_link->releaseFrame(p->m_buf);
+        p->m_loaned = false;
+        addRxPool(*p);
+        p = next;
+    }
+}
+
+void Proto::runLinkRx()
+{
+    releaseLoanedFrames();
+    m_link->runRx();
+}
+
 void Proto::addRxPool(IPacket &message)
 {
     tiny_mutex_lock( &m_mutex );
+    if ( m_pool == nullptr && m_link != nullptr )
+    {
+        m_link->setRxReady( true );
+    }
     message.m_next = m_pool;
     message.m_prev = nullptr;
     if ( m_pool != nullptr )
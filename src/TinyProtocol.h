@@ -100,6 +100,7 @@ private:
     IPacket *m_pool = nullptr;
     IPacket *m_queue = nullptr;
     IPacket *m_last = nullptr;
+    IPacket *m_released = nullptr;
 #if CONFIG_TINYHAL_THREAD_SUPPORT == 1
     std::thread *m_sendThread = nullptr;
     std::thread *m_readThread = nullptr;
@@ -119,6 +120,10 @@ private:
 
     static void onSendCb(void *udata, uint8_t addr, const uint8_t *buf, int len);
 
+    void releaseLoanedFrames();
+
+    void runLinkRx();
+
 #if CONFIG_TINYHAL_THREAD_SUPPORT == 1
     void runTx();
 
@@ -70,6 +70,10 @@ void IFd::begin()
     init.retry_timeout = 200;
     init.retries = 2;
     init.crc_type = m_crc;
+    init.framing = m_framing;
+    init.compression = m_compression;
+    init.extended = m_extended;
+    init.srej = m_srej;
     init.mode = TINY_FD_MODE_ABM;
 
     tiny_fd_init(&m_handle, &init);
@@ -80,6 +84,8 @@ void IFd::end()
     if ( m_bufferSize == 0 )
         return;
     tiny_fd_close(m_handle);
+    m_handle = nullptr;
+    m_session++;
 }
 
 int IFd::write(const char *buf, int size)
@@ -97,6 +103,16 @@ int IFd::run_rx(const void *data, int len)
     return tiny_fd_on_rx_data(m_handle, data, len);
 }
 
+int IFd::run_tx_block(void *block, int block_size)
+{
+    return tiny_fd_get_tx_block(m_handle, block, block_size);
+}
+
+int IFd::run_rx_ring(const void *base, int size, int head, int tail)
+{
+    return tiny_fd_on_rx_ring(m_handle, base, size, head, tail);
+}
+
 int IFd::run_rx(read_block_cb_t read_func)
 {
     uint8_t buf[4];
@@ -163,6 +179,12 @@ bool IFd::enableCrc32()
     return true;
 }
 
+bool IFd::enableCrc32c()
+{
+    m_crc = HDLC_CRC_32C;
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 
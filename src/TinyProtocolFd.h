@@ -77,6 +77,88 @@ public:
 
     virtual ~IFd() = default;
 
+    /**
+     * Reserved I-frame slot in outgoing queue. The application writes the frame directly
+     * to data(), and sends it by commit(). If the frame is not committed, the slot is
+     * returned to the queue, when the object is destroyed. The reservation becomes invalid
+     * after IFd::end(), since the slot is freed together with the protocol state.
+     */
+    class Reservation
+    {
+    public:
+        Reservation(IFd &fd, void *data)
+            : m_fd(fd)
+            , m_session(fd.m_session)
+            , m_data(data)
+        {
+        }
+
+        Reservation(Reservation &&other)
+            : m_fd(other.m_fd)
+            , m_session(other.m_session)
+            , m_data(other.m_data)
+        {
+            other.m_data = nullptr;
+        }
+
+        Reservation(const Reservation &) = delete;
+        Reservation &operator=(const Reservation &) = delete;
+
+        ~Reservation()
+        {
+            if ( isValid() )
+            {
+                tiny_fd_cancel(m_fd.m_handle, m_data);
+            }
+        }
+
+        /**
+         * Returns pointer to the buffer for the frame, or nullptr if reservation failed
+         */
+        uint8_t *data()
+        {
+            return isValid() ? static_cast<uint8_t *>(m_data) : nullptr;
+        }
+
+        /**
+         * Returns true if the slot is reserved
+         */
+        explicit operator bool() const
+        {
+            return isValid();
+        }
+
+        /**
+         * Sends reserved frame.
+         * @param len length of the data, written to data()
+         * @return the same codes as tiny_fd_commit(), or TINY_ERR_FAILED if the slot is not reserved
+         */
+        int commit(int len)
+        {
+            if ( !isValid() )
+            {
+                return TINY_ERR_FAILED;
+            }
+            int result = tiny_fd_commit(m_fd.m_handle, m_data, len);
+            // Other errors leave the slot reserved, and it is returned to the queue by destructor
+            if ( result == TINY_SUCCESS || result == TINY_ERR_FAILED )
+            {
+                m_data = nullptr;
+            }
+            return result;
+        }
+
+    private:
+        IFd &m_fd;
+        uint32_t m_session;
+        void *m_data;
+
+        bool isValid() const
+        {
+            return m_data != nullptr && m_fd.m_handle != nullptr && m_session == m_fd.m_session;
+        }
+    };
+
     /**
      * Initializes protocol internal variables.
      * If you need to switch communication with other destination
@@ -111,6 +193,17 @@ public:
      */
     int write(const IPacket &pkt);
 
+    /**
+     * Reserves slot in outgoing queue to build the frame in place, without copying.
+     * The call waits for free slot up to send timeout.
+     * @param maxLen maximum length of the frame
+     * @return reservation object, which is false in case of error
+     */
+    Reservation reserve(int maxLen)
+    {
+        return Reservation(*this, tiny_fd_reserve(m_handle, TINY_FD_PRIMARY_ADDR, maxLen, m_sendTimeout));
+    }
+
     /**
      * Processes incoming rx data, specified by a user.
      * @param data pointer to the buffer with incoming data
@@ -121,6 +214,25 @@ public:
      */
     int run_rx(const void *data, int len);
 
+    /**
+     * Processes incoming rx data in the circular buffer, for example, DMA buffer.
+     * @param base pointer to the circular buffer
+     * @param size size of the circular buffer in bytes
+     * @param head producer index: offset of the byte, which will be written next
+     * @param tail consumer index: offset of the first not processed byte
+     * @return new tail value or TINY_ERR_INVALID_DATA
+     */
+    int run_rx_ring(const void *base, int size, int head, int tail);
+
+    /**
+     * Fills fixed-size block for block transport, padding the rest of the block with fill bytes.
+     * Received blocks are processed by run_rx().
+     * @param block pointer to the block to fill
+     * @param block_size size of the block in bytes
+     * @return block_size or negative error code
+     */
+    int run_tx_block(void *block, int block_size);
+
     /**
      * Read data from communication channel using read_func and
      * parses bytes to find hdlc messages.
@@ -187,6 +299,68 @@ public:
      */
     bool enableCrc32();
 
+    /**
+     * Enables CRC-32C (Castagnoli) 32-bit field in the protocol.
+     * On x86 and ARMv8 cpus it is calculated by hardware crc32 instruction,
+     * so it is the cheapest option for links between such hosts.
+     * @return true if successful
+     *         false in case of error.
+     */
+    bool enableCrc32c();
+
+    /**
+     * Sets framing of the protocol: HDLC_FRAMING_HDLC (default) or HDLC_FRAMING_COBS.
+     * COBS framing adds at most 1 byte per 254 bytes of the frame regardless of data,
+     * while byte stuffing can double the frame. Both sides must use the same framing.
+     * @param framing framing type
+     */
+    void setFraming(hdlc_framing_t framing)
+    {
+        m_framing = framing;
+    }
+
+    /**
+     * Enables compression of outgoing frames. Frames are compressed only if the remote side
+     * supports compression too. Compression needs additional space in the protocol buffer,
+     * so mtu, selected for the same buffer, is smaller.
+     * @param enable true to enable compression
+     */
+    void enableCompression(bool enable = true)
+    {
+        m_compression = enable;
+    }
+
+    /**
+     * Enables extended mode with modulo-128 sequence numbers, which allows window size up to 127.
+     * Both sides must use the same mode. Use this function only before begin() call.
+     * @param enable true to enable extended mode
+     */
+    void enableExtendedMode(bool enable = true)
+    {
+        m_extended = enable;
+    }
+
+    /**
+     * Enables selective reject: only lost frames are resent instead of all frames after the lost one.
+     * It is used only if the remote side supports it too. Selective reject needs additional space
+     * in the protocol buffer, and uses not more than half of sequence numbers for unconfirmed frames.
+     * @param enable true to enable selective reject
+     */
+    void enableSelectiveReject(bool enable = true)
+    {
+        m_srej = enable;
+    }
+
+    /**
+     * Sets state of the receiver. While the receiver is not ready, remote side
+     * doesn't send new messages.
+     * @param ready false if the application cannot process incoming messages
+     */
+    void setRxReady(bool ready)
+    {
+        tiny_fd_set_rx_ready(m_handle, ready);
+    }
+
     /**
      * Sets receive callback for incoming messages
      * @param on_receive user callback to process incoming messages. The processing must be non-blocking
@@ -217,7 +391,7 @@ public:
     /**
      * Sets desired window size. Use this function only before begin() call.
      * window size is number of frames, which confirmation may be deferred for.
-     * @param window window size, valid between 1 - 7 inclusively
+     * @param window window size, valid between 2 - 7 inclusively, or up to 127 in extended mode
      * @warning if you use smallest window size, this can reduce throughput of the channel.
      */
     void setWindowSize(uint8_t window)
@@ -306,11 +480,22 @@ private:
     /** The variable contain protocol state */
     tiny_fd_handle_t m_handle = nullptr;
 
+    /** Incremented by end() to invalidate outstanding reservations */
+    uint32_t m_session = 0;
+
     /** buffer to receive data to */
     uint8_t *m_buffer = nullptr;
 
     hdlc_crc_t m_crc = HDLC_CRC_DEFAULT;
 
+    hdlc_framing_t m_framing = HDLC_FRAMING_HDLC;
+
+    bool m_compression = false;
+
+    bool m_extended = false;
+
+    bool m_srej = false;
+
     /** max buffer size */
     int m_bufferSize = 0;
 
@@ -176,6 +176,15 @@ public:
      */
     bool enableCrc32();
 
+    /**
+     * Enables CRC-32C (Castagnoli) 32-bit field in the protocol.
+     * On x86 and ARMv8 cpus it is calculated by hardware crc32 instruction,
+     * so it is the cheapest option for links between such hosts.
+     * @return true if successful
+     *         false in case of error.
+     */
+    bool enableCrc32c();
+
     /**
      * Sets receive callback for incoming messages
      * @param on_receive user callback to process incoming messages. The processing must be non-blocking
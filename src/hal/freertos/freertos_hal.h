@@ -45,6 +45,10 @@
 #define CONFIG_ENABLE_FCS32
 #endif
 
+#ifndef CONFIG_ENABLE_FCS32C
+#define CONFIG_ENABLE_FCS32C
+#endif
+
 #define CONFIG_TINYHAL_THREAD_SUPPORT 1
 
 /**
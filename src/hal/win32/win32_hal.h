@@ -46,6 +46,18 @@
 #define CONFIG_ENABLE_FCS32
 #endif
 
+#ifndef CONFIG_ENABLE_FCS32C
+#define CONFIG_ENABLE_FCS32C
+#endif
+
+#ifndef CONFIG_TINY_CRC_SLICING
+#define CONFIG_TINY_CRC_SLICING 8
+#endif
+
+#ifndef CONFIG_TINY_LZ_HASH_BITS
+#define CONFIG_TINY_LZ_HASH_BITS 12
+#endif
+
 #define CONFIG_TINYHAL_THREAD_SUPPORT 1
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -51,6 +51,8 @@ bool IFdLinkLayer::begin(on_frame_read_cb_t onReadCb, on_frame_send_cb_t onSendC
     init.buffer = m_buffer;
     init.buffer_size = m_bufferSize;
     init.window_frames = m_txWindow;
+    // Windows above 7 frames need modulo-128 sequence numbers
+    init.extended = m_txWindow > 7;
     init.send_timeout = getTimeout();
     init.retry_timeout = getTimeout() ? (getTimeout() / 4) : 100;
     init.retries = 2;
@@ -76,6 +78,27 @@ void IFdLinkLayer::flushTx()
 {
 }
 
+bool IFdLinkLayer::loanFrame(const uint8_t *buf)
+{
+    return tiny_fd_loan_frame(m_handle, buf) == TINY_SUCCESS;
+}
+
+void IFdLinkLayer::releaseFrame(const uint8_t *buf)
+{
+    if ( m_handle )
+    {
+        tiny_fd_release_frame(m_handle, buf);
+    }
+}
+
+void IFdLinkLayer::setRxReady(bool ready)
+{
+    if ( m_handle )
+    {
+        tiny_fd_set_rx_ready(m_handle, ready);
+    }
+}
+
 int IFdLinkLayer::parseData(const uint8_t *data, int size)
 {
     int code = tiny_fd_on_rx_data(m_handle, data, size);
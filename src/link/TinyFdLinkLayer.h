@@ -52,6 +52,12 @@ public:
 
     void flushTx() override;
 
+    bool loanFrame(const uint8_t *buf) override;
+
+    void releaseFrame(const uint8_t *buf) override;
+
+    void setRxReady(bool ready) override;
+
     int getWindow()
     {
         return m_txWindow;
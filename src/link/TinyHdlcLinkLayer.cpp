@@ -115,6 +115,19 @@ void IHdlcLinkLayer::flushTx()
     tiny_mutex_unlock( &m_sendMutex );
 }
 
+bool IHdlcLinkLayer::loanFrame(const uint8_t *buf)
+{
+    return hdlc_ll_loan_frame(m_handle, buf) == TINY_SUCCESS;
+}
+
+void IHdlcLinkLayer::releaseFrame(const uint8_t *buf)
+{
+    if ( m_handle )
+    {
+        hdlc_ll_release_frame(m_handle, buf);
+    }
+}
+
 int IHdlcLinkLayer::parseData(const uint8_t *data, int size)
 {
     return hdlc_ll_run_rx(m_handle, data, size, nullptr);
@@ -53,6 +53,10 @@ public:
 
     void flushTx() override;
 
+    bool loanFrame(const uint8_t *buf) override;
+
+    void releaseFrame(const uint8_t *buf) override;
+
     hdlc_crc_t getCrc()
     {
         return m_crc;
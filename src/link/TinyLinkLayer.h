@@ -89,6 +89,41 @@ public:
      */
     virtual void flushTx() = 0;
 
+    /**
+     * Keeps received frame valid after onReadCb callback returns. Can be called only from
+     * onReadCb callback. The frame must be returned to the link layer via releaseFrame().
+     *
+     * @param buf pointer to the frame data, passed to onReadCb callback
+     * @return true if the frame is loaned, false if the link layer cannot loan the frame
+     */
+    virtual bool loanFrame(const uint8_t *buf)
+    {
+        (void)buf;
+        return false;
+    }
+
+    /**
+     * Returns the frame, loaned by loanFrame(), back to the link layer. Must be called from
+     * the thread, running runRx().
+     *
+     * @param buf pointer to the frame data, passed to loanFrame()
+     */
+    virtual void releaseFrame(const uint8_t *buf)
+    {
+        (void)buf;
+    }
+
+    /**
+     * Informs the link layer if the application can accept new frames. Link layers with flow control
+     * ask remote side to pause sending, while the application is not ready.
+     *
+     * @param ready false if the application cannot accept frames
+     */
+    virtual void setRxReady(bool ready)
+    {
+        (void)ready;
+    }
+
     /**
      * Sets timeout of Rx/Tx operations in milliseconds for the link layer protocol.
      * This is not the same timeout, as timeout used by put() method.
@@ -31,6 +31,17 @@
 #include <stdint.h>
 #include "hal/tiny_types.h"
 
+/**
+ * Software CRC implementation to build:
+ *   0 - 16-entry nibble tables, smallest flash footprint, slowest
+ *   1 - classic 256-entry table, one byte per step
+ *   4, 8, 16 - slicing-by-N, N tables of 256 entries, N bytes per step
+ * Hosted platforms default to 8.
+ */
+#ifndef CONFIG_TINY_CRC_SLICING
+#define CONFIG_TINY_CRC_SLICING 1
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -41,6 +52,8 @@ extern "C"
 #define GOODCHECKSUM 0x0000
     uint16_t chksum_byte(uint16_t sum, uint8_t data);
     uint16_t tiny_chksum(uint16_t sum, const uint8_t* data, int data_length);
+    /** Adds data to the running sum without final inversion, can be called incrementally */
+    uint16_t tiny_chksum_update(uint16_t sum, const uint8_t* data, int data_length);
 #endif
 
 #ifdef CONFIG_ENABLE_FCS16
@@ -48,6 +61,8 @@ extern "C"
 #define PPPGOODFCS16 0xf0b8 /* Good final FCS value */
     uint16_t crc16_byte(uint16_t crc, uint8_t data);
     uint16_t tiny_crc16(uint16_t crc, const uint8_t* data, int data_length);
+    /** Updates running FCS-16 value without final inversion, can be called incrementally */
+    uint16_t tiny_crc16_update(uint16_t crc, const uint8_t* data, int data_length);
 #endif
 
 #ifdef CONFIG_ENABLE_FCS32
@@ -55,10 +70,21 @@ extern "C"
 #define PPPGOODFCS32 0xdebb20e3 /* Good final FCS value */
     uint32_t crc32_byte(uint32_t crc, uint8_t data);
     uint32_t tiny_crc32(uint32_t crc, const uint8_t *buf, int size);
+    /** Updates running FCS-32 value without final inversion, can be called incrementally */
+    uint32_t tiny_crc32_update(uint32_t crc, const uint8_t *buf, int size);
+#endif
+
+#ifdef CONFIG_ENABLE_FCS32C
+#define PPPINITFCS32C 0xffffffff /* Initial FCS value */
+#define PPPGOODFCS32C 0xb798b438 /* Good final FCS value */
+    uint32_t crc32c_byte(uint32_t crc, uint8_t data);
+    uint32_t tiny_crc32c(uint32_t crc, const uint8_t *buf, int size);
+    /** Updates running CRC-32C value without final inversion, can be called incrementally */
+    uint32_t tiny_crc32c_update(uint32_t crc, const uint8_t *buf, int size);
 #endif
 
 /// \cond
-#ifdef CONFIG_ENABLE_FCS32
+#if defined(CONFIG_ENABLE_FCS32) || defined(CONFIG_ENABLE_FCS32C)
     typedef uint32_t crc_t;
 #else
 typedef uint16_t crc_t;
@@ -74,6 +100,7 @@ typedef uint16_t crc_t;
         HDLC_CRC_8 = 8,       ///< Simple sum of all bytes in user payload
         HDLC_CRC_16 = 16,     ///< CCITT-16
         HDLC_CRC_32 = 32,     ///< CCITT-32
+        HDLC_CRC_32C = 33,    ///< CRC-32C (Castagnoli), uses hardware crc32 instruction if available
         HDLC_CRC_OFF = 0xFF,  ///< Disable CRC field
     } hdlc_crc_t;
 
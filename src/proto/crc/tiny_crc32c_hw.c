@@ -0,0 +1,114 @@
+/*
+    Copyright 2025 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/*
+ * CRC-32C kernels using crc32 instruction of SSE4.2 (x86) or CRC extension (ARMv8).
+ * Both instructions operate on the bit-reflected crc value, the same way as table code does.
+ */
+
+#include "tiny_crc_int.h"
+
+#ifdef TINY_CRC_CRC32C_HW
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#define CRC32C_U8(crc, data) _mm_crc32_u8(crc, data)
+#define CRC32C_U32(crc, data) _mm_crc32_u32(crc, data)
+#if defined(__x86_64__)
+#define CRC32C_U64(crc, data) ((uint32_t)_mm_crc32_u64(crc, data))
+#endif
+
+static int crc32c_detect(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+
+#else
+
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+
+#define CRC32C_TARGET
+#define CRC32C_U8(crc, data) __crc32cb(crc, data)
+#define CRC32C_U32(crc, data) __crc32cw(crc, data)
+#define CRC32C_U64(crc, data) __crc32cd(crc, data)
+
+static int crc32c_detect(void)
+{
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+
+#endif
+
+// -1 until the first call, cpu features do not change, so concurrent detection is harmless
+static int s_crc32c_supported = -1;
+
+int tiny_crc32c_hw_supported(void)
+{
+    if ( s_crc32c_supported < 0 )
+    {
+        s_crc32c_supported = crc32c_detect();
+    }
+    return s_crc32c_supported;
+}
+
+CRC32C_TARGET uint32_t tiny_crc32c_hw_update(uint32_t crc, const uint8_t *buf, int size)
+{
+#if defined(CRC32C_U64)
+    while ( size >= 8 )
+    {
+        uint64_t word;
+        memcpy(&word, buf, sizeof(word));
+        crc = CRC32C_U64(crc, word);
+        buf += 8;
+        size -= 8;
+    }
+#endif
+    while ( size >= 4 )
+    {
+        uint32_t word;
+        memcpy(&word, buf, sizeof(word));
+        crc = CRC32C_U32(crc, word);
+        buf += 4;
+        size -= 4;
+    }
+    while ( size-- > 0 )
+    {
+        crc = CRC32C_U8(crc, *buf++);
+    }
+    return crc;
+}
+
+#endif
@@ -0,0 +1,190 @@
+/*
+    Copyright 2025 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/*
+ * Carry-less multiply crc folding, see "Fast CRC Computation for Generic Polynomials
+ * Using PCLMULQDQ Instruction" by Intel. The code works in bit-reflected domain
+ * and is shared by FCS-16, FCS-32 and CRC-32C, only folding constants differ.
+ */
+
+#include "tiny_crc_int.h"
+
+#ifdef TINY_CRC_CLMUL
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define CLMUL_TARGET __attribute__((target("pclmul,sse2")))
+
+static int clmul_detect(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse2");
+}
+
+typedef __m128i clmul_block_t;
+
+CLMUL_TARGET static inline clmul_block_t clmul_load(const uint8_t *p)
+{
+    return _mm_loadu_si128((const __m128i *)p);
+}
+
+CLMUL_TARGET static inline clmul_block_t clmul_constants(uint64_t lo, uint64_t hi)
+{
+    return _mm_set_epi64x((long long)hi, (long long)lo);
+}
+
+CLMUL_TARGET static inline clmul_block_t clmul_xor(clmul_block_t a, clmul_block_t b)
+{
+    return _mm_xor_si128(a, b);
+}
+
+CLMUL_TARGET static inline clmul_block_t clmul_xor_crc(clmul_block_t a, uint32_t crc)
+{
+    return _mm_xor_si128(a, _mm_cvtsi32_si128((int)crc));
+}
+
+// Moves the block forward: low half is multiplied by k.lo, high half by k.hi
+CLMUL_TARGET static inline clmul_block_t clmul_fold(clmul_block_t x, clmul_block_t k)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11));
+}
+
+CLMUL_TARGET static inline void clmul_store(uint8_t *p, clmul_block_t x)
+{
+    _mm_storeu_si128((__m128i *)p, x);
+}
+
+#else
+
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+
+#define CLMUL_TARGET
+
+static int clmul_detect(void)
+{
+    return (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+}
+
+typedef uint64x2_t clmul_block_t;
+
+static inline clmul_block_t clmul_load(const uint8_t *p)
+{
+    return vreinterpretq_u64_u8(vld1q_u8(p));
+}
+
+static inline clmul_block_t clmul_constants(uint64_t lo, uint64_t hi)
+{
+    return vcombine_u64(vcreate_u64(lo), vcreate_u64(hi));
+}
+
+static inline clmul_block_t clmul_xor(clmul_block_t a, clmul_block_t b)
+{
+    return veorq_u64(a, b);
+}
+
+static inline clmul_block_t clmul_xor_crc(clmul_block_t a, uint32_t crc)
+{
+    return veorq_u64(a, vcombine_u64(vcreate_u64(crc), vcreate_u64(0)));
+}
+
+// Moves the block forward: low half is multiplied by k.lo, high half by k.hi
+static inline clmul_block_t clmul_fold(clmul_block_t x, clmul_block_t k)
+{
+    poly128_t lo = vmull_p64((poly64_t)vgetq_lane_u64(x, 0), (poly64_t)vgetq_lane_u64(k, 0));
+    poly128_t hi = vmull_high_p64(vreinterpretq_p64_u64(x), vreinterpretq_p64_u64(k));
+    return veorq_u64(vreinterpretq_u64_p128(lo), vreinterpretq_u64_p128(hi));
+}
+
+static inline void clmul_store(uint8_t *p, clmul_block_t x)
+{
+    vst1q_u8(p, vreinterpretq_u8_u64(x));
+}
+
+#endif
+
+// -1 until the first call, cpu features do not change, so concurrent detection is harmless
+static int s_clmul_supported = -1;
+
+CLMUL_TARGET static int clmul_fold_blocks(const uint64_t k[4], uint32_t crc, const uint8_t *buf, int len,
+                                          uint8_t folded[16])
+{
+    const uint8_t *start = buf;
+    clmul_block_t k1 = clmul_constants(k[2], k[3]);
+    clmul_block_t x1 = clmul_xor_crc(clmul_load(buf), crc);
+    buf += 16;
+    len -= 16;
+    if ( len >= 48 )
+    {
+        // 4 independent lanes hide multiplication latency
+        clmul_block_t k4 = clmul_constants(k[0], k[1]);
+        clmul_block_t x2 = clmul_load(buf);
+        clmul_block_t x3 = clmul_load(buf + 16);
+        clmul_block_t x4 = clmul_load(buf + 32);
+        buf += 48;
+        len -= 48;
+        while ( len >= 64 )
+        {
+            x1 = clmul_xor(clmul_fold(x1, k4), clmul_load(buf));
+            x2 = clmul_xor(clmul_fold(x2, k4), clmul_load(buf + 16));
+            x3 = clmul_xor(clmul_fold(x3, k4), clmul_load(buf + 32));
+            x4 = clmul_xor(clmul_fold(x4, k4), clmul_load(buf + 48));
+            buf += 64;
+            len -= 64;
+        }
+        x1 = clmul_xor(clmul_fold(x1, k1), x2);
+        x1 = clmul_xor(clmul_fold(x1, k1), x3);
+        x1 = clmul_xor(clmul_fold(x1, k1), x4);
+    }
+    while ( len >= 16 )
+    {
+        x1 = clmul_xor(clmul_fold(x1, k1), clmul_load(buf));
+        buf += 16;
+        len -= 16;
+    }
+    clmul_store(folded, x1);
+    return (int)(buf - start);
+}
+
+int tiny_crc_clmul_fold(const uint64_t k[4], uint32_t crc, const uint8_t *buf, int len, uint8_t folded[16])
+{
+    if ( s_clmul_supported < 0 )
+    {
+        s_clmul_supported = clmul_detect();
+    }
+    if ( !s_clmul_supported || len < 16 )
+    {
+        return 0;
+    }
+    return clmul_fold_blocks(k, crc, buf, len, folded);
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+    Copyright 2025 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#pragma once
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <stdint.h>
+
+/*
+ * TINY_CRC_HW can be set to 0 to disable hardware accelerated crc kernels,
+ * which are selected at runtime depending on cpu features.
+ */
+#ifndef TINY_CRC_HW
+#define TINY_CRC_HW 1
+#endif
+
+#if TINY_CRC_HW && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TINY_CRC_CLMUL 1
+#elif TINY_CRC_HW && defined(__GNUC__) && defined(__aarch64__) && defined(__linux__) &&                              \
+    (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+#define TINY_CRC_CLMUL 1
+#endif
+
+#if TINY_CRC_HW && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TINY_CRC_CRC32C_HW 1
+#elif TINY_CRC_HW && defined(__GNUC__) && defined(__aarch64__) && defined(__linux__) && defined(__ARM_FEATURE_CRC32)
+#define TINY_CRC_CRC32C_HW 1
+#endif
+
+/* Shorter blocks are faster to process with lookup tables */
+#define TINY_CRC_CLMUL_MIN_SIZE 64
+
+#ifdef TINY_CRC_CLMUL
+
+/**
+ * Folds len bytes (rounded down to 16) of reflected crc using carry-less multiplication.
+ * The result is 16-byte block, which has the same crc as processed bytes, so the caller
+ * completes crc by passing the block to the table code with zero initial value.
+ * Returns number of bytes folded, or 0 if the cpu doesn't support carry-less multiply
+ * or len is less than 16.
+ */
+int tiny_crc_clmul_fold(const uint64_t k[4], uint32_t crc, const uint8_t *buf, int len, uint8_t folded[16]);
+
+#endif
+
+#ifdef TINY_CRC_CRC32C_HW
+
+/** Returns non-zero if the cpu has crc32c instruction */
+int tiny_crc32c_hw_supported(void);
+
+/**
+ * Updates running CRC-32C value using crc32c instruction.
+ * Must be called only if tiny_crc32c_hw_supported() returns non-zero.
+ */
+uint32_t tiny_crc32c_hw_update(uint32_t crc, const uint8_t *buf, int size);
+
+#endif
+
+#endif
@@ -33,8 +33,10 @@
 #include "tiny_fd_service_queue_int.h"
 #include "tiny_fd_data_queue_int.h"
 #include "tiny_fd_on_rx_int.h"
+#include "tiny_fd_control_int.h"
 #include "hal/tiny_types.h"
 #include "hal/tiny_debug.h"
+#include "proto/lz/tiny_lz.h"
 
 #include <string.h>
 
@@ -49,7 +51,7 @@ static void on_frame_send(void *user_data, const uint8_t *data, int len);
 #if 0
 static inline uint8_t __number_of_awaiting_tx_i_frames(tiny_fd_handle_t handle, uint8_t peer)
 {
-    return ((uint8_t)(handle->peers[peer].last_ns - handle->peers[peer].confirm_ns) & seq_bits_mask);
+    return ((uint8_t)(handle->peers[peer].last_ns - handle->peers[peer].confirm_ns) & handle->seq_bits_mask);
 }
 #endif
 
@@ -76,23 +78,137 @@ static inline uint32_t __time_passed_since_last_marker_seen(tiny_fd_handle_t han
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Passes async control character map, requested by local and remote stations, to hdlc level.
+ */
+static int __apply_accm(tiny_fd_handle_t handle)
+{
+    uint32_t accm = handle->accm | handle->peer_accm;
+    uint8_t map[HDLC_ACCM_SIZE] = {0};
+    for ( uint8_t byte = 0; byte < 32; byte++ )
+    {
+        if ( accm & ((uint32_t)1 << byte) )
+        {
+            HDLC_ACCM_ADD(map, byte);
+        }
+    }
+    // Received control characters can be discarded only if the remote station escapes them.
+    // Several secondary stations may request different maps, so they are only escaped for them.
+    uint8_t flags = HDLC_ACCM_TX | (handle->accm_confirmed && handle->peers_count == 1 ? HDLC_ACCM_RX : 0);
+    return hdlc_ll_set_accm(handle->_hdlc, map, flags);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns true if local station needs to send its capabilities to the remote station.
+ */
+static inline bool __needs_caps(tiny_fd_handle_t handle)
+{
+    return handle->accm || handle->compression || handle->srej;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Puts SABM, SNRM or UA frame to tx queue. If caps is true, the frame carries capabilities of the local station.
+ */
+static tiny_fd_frame_info_t *__put_u_frame_with_caps(tiny_fd_handle_t handle, int type, uint8_t address,
+                                                     uint8_t control, bool caps)
+{
+    tiny_fd_u_caps_frame_t frame = {
+        .header = {.address = address, .control = control},
+        .caps = TINY_FD_LOCAL_CAP_ACCM | (handle->compression ? TINY_FD_CAP_LZ : 0) | (handle->srej ? TINY_FD_CAP_SREJ : 0),
+        .accm = {(uint8_t)handle->accm, (uint8_t)(handle->accm >> 8), (uint8_t)(handle->accm >> 16),
+                 (uint8_t)(handle->accm >> 24)},
+    };
+    return __put_u_s_frame_to_tx_queue(handle, type, &frame, caps ? (int)sizeof(frame) : (int)sizeof(frame.header));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Reads capabilities of the remote station from SABM, SNRM or UA frame.
+ * confirmed must be true if the remote station already knows local capabilities.
+ * Returns true if the remote station supports capabilities.
+ */
+static bool __on_peer_caps(tiny_fd_handle_t handle, uint8_t peer, const uint8_t *data, int len, bool confirmed)
+{
+    const tiny_fd_u_caps_frame_t *frame = (const tiny_fd_u_caps_frame_t *)data;
+    bool caps = len >= (int)sizeof(tiny_fd_u_caps_frame_t);
+    // I-frames are compressed only if both stations support it
+    handle->peers[peer].compression = caps && handle->compression && (frame->caps & TINY_FD_CAP_LZ);
+    // Old stations request missing frames with REJ, and do not expect SREJ
+    handle->peers[peer].srej = caps && handle->srej && (frame->caps & TINY_FD_CAP_SREJ);
+    if ( !caps || !(frame->caps & TINY_FD_CAP_ACCM) || !TINY_FD_LOCAL_CAP_ACCM )
+    {
+        return caps;
+    }
+    handle->peer_accm |= (uint32_t)frame->accm[0] | ((uint32_t)frame->accm[1] << 8) |
+                         ((uint32_t)frame->accm[2] << 16) | ((uint32_t)frame->accm[3] << 24);
+    handle->accm_negotiated = 1;
+    handle->accm_confirmed = confirmed;
+    LOG(TINY_LOG_INFO, "[%p] Remote accm %08" PRIX32 ", using %08" PRIX32 "\n", handle, handle->peer_accm,
+        handle->accm | handle->peer_accm);
+    __apply_accm(handle);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Remote station sends I- and S- frames only after it receives the answer to the connection request.
+ * So it already escapes the negotiated map.
+ */
+static inline void __confirm_accm(tiny_fd_handle_t handle)
+{
+    if ( handle->accm_negotiated && !handle->accm_confirmed )
+    {
+        handle->accm_confirmed = 1;
+        __apply_accm(handle);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Drops sequence numbers and frames of the previous connection with the peer.
+ */
+static void __reset_peer_sequence(tiny_fd_handle_t handle, uint8_t peer)
+{
+    handle->peers[peer].confirm_ns = 0;
+    handle->peers[peer].last_ns = 0;
+    handle->peers[peer].next_ns = 0;
+    handle->peers[peer].unsent_ns = 0;
+    handle->peers[peer].urgent_count = 0;
+    handle->peers[peer].next_nr = 0;
+    handle->peers[peer].sent_nr = 0;
+    handle->peers[peer].sent_reject = 0;
+    handle->peers[peer].srej_pending = 0;
+    handle->peers[peer].remote_busy = 0;
+    // Dropped frames belong to previous connection, but the application is still busy
+    handle->peers[peer].local_busy = handle->peers[peer].local_busy ? 1 : 0;
+    __reset_rx_slots(handle, peer);
+    tiny_fd_queue_reset_for( &handle->frames.i_queue, peer );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static void __switch_to_connected_state(tiny_fd_handle_t handle, uint8_t peer)
 {
     if ( handle->peers[peer].state != TINY_FD_STATE_CONNECTED )
     {
         handle->peers[peer].state = TINY_FD_STATE_CONNECTED;
-        handle->peers[peer].confirm_ns = 0;
-        handle->peers[peer].last_ns = 0;
-        handle->peers[peer].next_ns = 0;
-        handle->peers[peer].next_nr = 0;
-        handle->peers[peer].sent_nr = 0;
-        handle->peers[peer].sent_reject = 0;
-        tiny_fd_queue_reset_for( &handle->frames.i_queue, __peer_to_address_field( handle, peer ) );
+        __reset_peer_sequence(handle, peer);
         // Reset last arrived frame timestamp on connection.
         // This is required to avoid disconnection on keep alive timeout at the beginning of connection
         handle->peers[peer].last_received_frame_ts = tiny_millis();
         handle->peers[peer].last_sent_frame_ts = tiny_millis();
-        tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+        if ( __can_accept_i_frames( handle, peer ) )
+        {
+            // Frames, reserved by the application, are still in the window
+            tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+        }
         tiny_events_set(
             &handle->events,
             FD_EVENT_TX_DATA_AVAILABLE |
@@ -116,14 +232,16 @@ static void __switch_to_disconnected_state(tiny_fd_handle_t handle, uint8_t peer
     if ( handle->peers[peer].state != TINY_FD_STATE_DISCONNECTED )
     {
         handle->peers[peer].state = TINY_FD_STATE_DISCONNECTED;
-        handle->peers[peer].confirm_ns = 0;
-        handle->peers[peer].last_ns = 0;
-        handle->peers[peer].next_ns = 0;
-        handle->peers[peer].next_nr = 0;
-        handle->peers[peer].sent_nr = 0;
-        handle->peers[peer].sent_reject = 0;
-        tiny_fd_queue_reset_for( &handle->frames.i_queue, __peer_to_address_field( handle, peer ) );
+        __reset_peer_sequence(handle, peer);
         tiny_events_clear(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+        if ( handle->peers_count == 1 )
+        {
+            // The map will be negotiated again on next connection
+            handle->peer_accm = 0;
+            handle->accm_negotiated = 0;
+            handle->accm_confirmed = 0;
+            __apply_accm(handle);
+        }
         LOG(TINY_LOG_CRIT, "[%p] Disconnected\n", handle);
         if ( handle->on_connect_event_cb )
         {
@@ -137,6 +255,15 @@ static void __switch_to_disconnected_state(tiny_fd_handle_t handle, uint8_t peer
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+
+static bool on_address_filter(void *user_data, uint8_t address)
+{
+    tiny_fd_handle_t handle = (tiny_fd_handle_t)user_data;
+    // Frame logger wants to see all frames on the bus
+    return handle->log_frame_cb || __address_field_to_peer( handle, address ) != HDLC_INVALID_PEER_INDEX;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static void on_frame_read(void *user_data, uint8_t *data, int len)
@@ -154,10 +281,17 @@ static void on_frame_read(void *user_data, uint8_t *data, int len)
         // it seems that the frame is not for us. Just exit
         return;
     }
+    uint8_t control = ((uint8_t *)data)[1];
+    if ( len < __header_len(handle, control) )
+    {
+        LOG(TINY_LOG_WRN, "[%p] Received frame without extended control field\n", handle);
+        return;
+    }
+    // U-frames have no extended control field, and may have no info field either
+    uint8_t control_ext = __header_len(handle, control) > 2 ? ((uint8_t *)data)[2] : 0;
     tiny_mutex_lock(&handle->frames.mutex);
     handle->peers[peer].last_received_frame_ts = tiny_millis();
     handle->peers[peer].ka_confirmed = 1;
-    uint8_t control = ((uint8_t *)data)[1];
     if ( (control & HDLC_U_FRAME_MASK) == HDLC_U_FRAME_MASK )
     {
         __on_u_frame_read(handle, peer, data, len);
@@ -169,19 +303,18 @@ static void on_frame_read(void *user_data, uint8_t *data, int len)
         // Should send DM in case we receive here S- or I-frames.
         // If connection is not established, we should ignore all frames except U-frames
         LOG(TINY_LOG_CRIT, "[%p] Connection is not established, connecting\n", handle);
-        tiny_frame_header_t frame = {
-            .address = __peer_to_address_field( handle, peer ) | HDLC_CR_BIT,
-            .control = (handle->mode == TINY_FD_MODE_NRM ? HDLC_U_FRAME_TYPE_SNRM : HDLC_U_FRAME_TYPE_SABM) | HDLC_U_FRAME_BITS,
-        };
-        __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_U_FRAME, &frame, 2);
+        __put_u_frame_with_caps(handle, TINY_FD_QUEUE_U_FRAME, __peer_to_address_field( handle, peer ) | HDLC_CR_BIT,
+                                __mode_setting_command(handle), __needs_caps(handle));
         handle->peers[peer].state = TINY_FD_STATE_CONNECTING;
     }
     else if ( (control & HDLC_I_FRAME_MASK) == HDLC_I_FRAME_BITS )
     {
+        __confirm_accm(handle);
         __on_i_frame_read(handle, peer, data, len);
     }
     else if ( (control & HDLC_S_FRAME_MASK) == HDLC_S_FRAME_BITS )
     {
+        __confirm_accm(handle);
         __on_s_frame_read(handle, peer, data, len);
     }
     else
@@ -191,7 +324,7 @@ static void on_frame_read(void *user_data, uint8_t *data, int len)
     // Check that if we are in NRM mode then we have something to send
     if ( handle->mode == TINY_FD_MODE_NRM )
     {
-        if ( control & ( HDLC_P_BIT | HDLC_F_BIT ) )
+        if ( __frame_pf(handle, control, control_ext) )
         {
             LOG(TINY_LOG_INFO, "[%p] [CAPTURED MARKER]\n", handle);
             // Cool! Now we have marker again, and we can send
@@ -221,6 +354,8 @@ static void on_frame_send(void *user_data, const uint8_t *data, int len)
         return;
     }
     tiny_mutex_lock(&handle->frames.mutex);
+    // hdlc level reports the first segment of the frame, which is the header of the queued frame
+    bool pf = __frame_pf(handle, control, __header_to_frame(data)->control_ext);
     if ( (control & HDLC_I_FRAME_MASK) == HDLC_I_FRAME_BITS )
     {
         (void)(peer);
@@ -236,7 +371,9 @@ static void on_frame_send(void *user_data, const uint8_t *data, int len)
         tiny_fd_queue_free_by_header( &handle->frames.s_queue, data );
     }
     // Clear send flag and clear marker if final was transferred. For ABM mode the marker is never cleared
-    uint8_t flags_to_clear = FD_EVENT_TX_SENDING;
+    // If the frame is urgent one, hdlc level continues with preempted frame
+    uint8_t flags_to_clear = handle->preempted ? 0 : FD_EVENT_TX_SENDING;
+    handle->preempted = 0;
     if ( handle->mode == TINY_FD_MODE_NRM )
     {
         // Let's talk to the next station if we are primary
@@ -244,13 +381,13 @@ static void on_frame_send(void *user_data, const uint8_t *data, int len)
         // from the peer we provided the marker to... But what? What if
         // remote peer never responds to us. So, having switch procedure
         // in this callback simplifies things
-        if ( __is_primary_station( handle ) && (control & HDLC_P_BIT) )
+        if ( __is_primary_station( handle ) && pf )
         {
             __switch_to_next_peer( handle );
             LOG(TINY_LOG_INFO, "[%p] [RELEASED MARKER]\n", handle);
             flags_to_clear |= FD_EVENT_HAS_MARKER;
         }
-        else if ( !__is_primary_station( handle ) && (control & HDLC_F_BIT) )
+        else if ( !__is_primary_station( handle ) && pf )
         {
             LOG(TINY_LOG_INFO, "[%p] [RELEASED MARKER]\n", handle);
             flags_to_clear |= FD_EVENT_HAS_MARKER;
@@ -272,18 +409,24 @@ static int __tiny_fd_init_validate(tiny_fd_handle_t *handle, tiny_fd_init_t *ini
     }
     if ( init->mtu == 0 )
     {
-        int size = tiny_fd_buffer_size_by_mtu_ex(peers_count, 0, init->window_frames, init->crc_type, 1);
-        init->mtu = (init->buffer_size - size) / (init->window_frames + 1);
+        int size = tiny_fd_buffer_size_by_mtu_ex(peers_count, 0, init->window_frames, init->crc_type, 1) +
+                   (init->compression ? tiny_fd_compression_buffer_size(0, init->window_frames) : 0) +
+                   (init->srej ? tiny_fd_srej_buffer_size(peers_count, 0, init->window_frames) : 0);
+        // Decompressed frames need one more mtu-size buffer, out-of-order frames need a buffer for each of them
+        init->mtu = (init->buffer_size - size) / (init->window_frames + 1 + (init->compression ? 1 : 0) +
+                                                  (init->srej ? peers_count * (init->window_frames - 1) : 0));
         if ( init->mtu < 2 )
         {
             LOG(TINY_LOG_CRIT, "Calculated mtu size is zero, no payload transfer is available%s", "\n");
             return TINY_ERR_OUT_OF_MEMORY;
         }
     }
-    if ( init->buffer_size < tiny_fd_buffer_size_by_mtu_ex(peers_count, init->mtu, init->window_frames, init->crc_type, 1) )
+    int required_size = tiny_fd_buffer_size_by_mtu_ex(peers_count, init->mtu, init->window_frames, init->crc_type, 1) +
+                        (init->compression ? tiny_fd_compression_buffer_size(init->mtu, init->window_frames) : 0) +
+                        (init->srej ? tiny_fd_srej_buffer_size(peers_count, init->mtu, init->window_frames) : 0);
+    if ( init->buffer_size < required_size )
     {
-        LOG(TINY_LOG_CRIT, "Too small buffer for FD protocol %i < %i\n", init->buffer_size,
-            tiny_fd_buffer_size_by_mtu_ex(peers_count, init->mtu, init->window_frames, init->crc_type, 1));
+        LOG(TINY_LOG_CRIT, "Too small buffer for FD protocol %i < %i\n", init->buffer_size, required_size);
         return TINY_ERR_OUT_OF_MEMORY;
     }
     if ( init->window_frames < 2 )
@@ -291,6 +434,11 @@ static int __tiny_fd_init_validate(tiny_fd_handle_t *handle, tiny_fd_init_t *ini
         LOG(TINY_LOG_CRIT, "HDLC doesn't support less than 2-frames queue%s", "\n");
         return TINY_ERR_INVALID_DATA;
     }
+    if ( init->window_frames > (init->extended ? TINY_FD_EXT_SEQ_BITS_MASK : TINY_FD_SEQ_BITS_MASK) )
+    {
+        LOG(TINY_LOG_CRIT, "Window of %i frames needs extended mode, or is too large\n", init->window_frames);
+        return TINY_ERR_INVALID_DATA;
+    }
     if ( !init->retry_timeout && !init->send_timeout )
     {
         LOG(TINY_LOG_CRIT, "HDLC uses timeouts for ACK, at least retry_timeout, or send_timeout must be specified%s", "\n");
@@ -312,6 +460,10 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
         }
     }
     memset(init->buffer, 0, init->buffer_size);
+    /* Compressed I-frames carry compression flag before user payload */
+    const int frame_mtu = init->mtu + (init->compression ? 1 : 0);
+    const int lz_size = init->compression ? (int)TINY_LZ_TABLE_SIZE + init->mtu + TINY_ALIGN_STRUCT_VALUE - 1 : 0;
+    const int srej_size = init->srej ? tiny_fd_srej_buffer_size(peers_count, init->mtu, init->window_frames) : 0;
 
     /* Lets locate main FD protocol data at the beginning of specified buffer.
      * The buffer must be properly aligned for ARM processors to get correct alignment for tiny_fd_data_t structure.
@@ -325,19 +477,19 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
     uint8_t *hdlc_ll_ptr = ptr;
     // TODO: Hack: remove - 4
     int hdlc_ll_size = (int)((uint8_t *)init->buffer + init->buffer_size - ptr - 4 - // Remaining size
-                             init->window_frames *                               // Number of frames multiply by frame size (headers + payload + pointers)
-                                 ( sizeof(tiny_fd_frame_info_t *) + init->mtu + sizeof(tiny_fd_frame_info_t) - sizeof(((tiny_fd_frame_info_t *)0)->payload) ) -
-                             TINY_FD_U_QUEUE_MAX_SIZE *
-                                 (sizeof(tiny_fd_frame_info_t *) + sizeof(tiny_fd_frame_info_t)) -
-                             peers_count * sizeof(tiny_fd_peer_info_t));
+                             init->window_frames *                               // Number of frames multiply by frame size (headers + payload)
+                                 ( frame_mtu + sizeof(tiny_fd_frame_info_t) - sizeof(((tiny_fd_frame_info_t *)0)->payload) ) -
+                             peers_count * tiny_fd_queue_get_ring_size(init->window_frames) - // N(S) index of I-frames
+                             TINY_FD_U_QUEUE_MAX_SIZE * TINY_FD_U_FRAME_SLOT_SIZE -
+                             peers_count * sizeof(tiny_fd_peer_info_t) - lz_size - srej_size);
     /* All FD protocol structures must be aligned. */
     hdlc_ll_size &= ~(TINY_ALIGN_STRUCT_VALUE - 1);
     ptr += hdlc_ll_size;
     ptr = TINY_ALIGN_BUFFER(ptr);
 
-    /* Next we need some space to hold pointers to tiny_i_frame_info_t records (window_frames pointers) */
+    /* Next we need some space to hold I-frames (window_frames records) and their N(S) index for each peer */
     int queue_size = tiny_fd_queue_init( &protocol->frames.i_queue, ptr, (int)((uint8_t *)init->buffer + init->buffer_size - ptr),
-                                         init->window_frames, init->mtu );
+                                         init->window_frames, frame_mtu, peers_count );
     if ( queue_size < 0 )
     {
         return queue_size;
@@ -345,7 +497,7 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
     ptr += queue_size;
     ptr = TINY_ALIGN_BUFFER(ptr);
     queue_size = tiny_fd_queue_init( &protocol->frames.s_queue, ptr, (int)((uint8_t *)init->buffer + init->buffer_size - ptr),
-                                     TINY_FD_U_QUEUE_MAX_SIZE, 2 );
+                                     TINY_FD_U_QUEUE_MAX_SIZE, TINY_FD_U_FRAME_MAX_INFO, 0 );
     if ( queue_size < 0 )
     {
         return queue_size;
@@ -359,6 +511,28 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
     protocol->next_peer = 0;
     ptr += sizeof(tiny_fd_peer_info_t) * peers_count;
 
+    /* Selective reject keeps out-of-order frames for each peer right after peers data. The frame,
+     * which is waited for, is never kept, and not more than half of sequence numbers can be in use. */
+    if ( init->srej )
+    {
+        uint8_t half_window = ((init->extended ? TINY_FD_EXT_SEQ_BITS_MASK : TINY_FD_SEQ_BITS_MASK) + 1) / 2;
+        ptr = TINY_ALIGN_BUFFER(ptr);
+        protocol->rx_slots = (init->window_frames < half_window ? init->window_frames : half_window) - 1;
+        protocol->rx_slot_size = (uint16_t)(offsetof(tiny_fd_rx_slot_t, payload) + frame_mtu + TINY_ALIGN_STRUCT_VALUE - 1) &
+                                 ~(TINY_ALIGN_STRUCT_VALUE - 1);
+        ptr += protocol->rx_slot_size * protocol->rx_slots * peers_count;
+    }
+
+    /* And the last is compressor match table and the buffer for decompressed frames */
+    if ( init->compression )
+    {
+        ptr = TINY_ALIGN_BUFFER(ptr);
+        protocol->lz_table = (uint16_t *)ptr;
+        ptr += TINY_LZ_TABLE_SIZE;
+        protocol->lz_buf = ptr;
+        ptr += init->mtu;
+    }
+
     if ( ptr > (uint8_t *)init->buffer + init->buffer_size )
     {
         LOG(TINY_LOG_CRIT, "Out of provided memory: provided %i bytes, used %i bytes\n", init->buffer_size,
@@ -373,7 +547,9 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
     _init.crc_type = init->crc_type;
     _init.buf_size = hdlc_ll_size;
     _init.buf = hdlc_ll_ptr;
-    _init.mtu = init->mtu + sizeof(tiny_frame_header_t);
+    _init.mtu = frame_mtu + (init->extended ? TINY_FD_MAX_HEADER_SIZE : sizeof(tiny_frame_header_t));
+    _init.framing = init->framing;
+    _init.address_filter = on_address_filter;
 
     int result = hdlc_ll_init(&protocol->_hdlc, &_init);
     if ( result != TINY_SUCCESS )
@@ -391,6 +567,17 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
     // By default assign primary address
     protocol->addr = (init->addr ? (init->addr << 2) : HDLC_PRIMARY_ADDR ) | HDLC_E_BIT;
     protocol->mode = init->mode;
+    protocol->extended = init->extended ? 1 : 0;
+    protocol->seq_bits_mask = init->extended ? TINY_FD_EXT_SEQ_BITS_MASK : TINY_FD_SEQ_BITS_MASK;
+    protocol->frames.i_queue.ns_mask = protocol->seq_bits_mask;
+    protocol->accm = init->accm;
+    protocol->compression = init->compression ? 1 : 0;
+    protocol->srej = init->srej ? 1 : 0;
+    if ( __apply_accm(protocol) != TINY_SUCCESS )
+    {
+        LOG(TINY_LOG_CRIT, "Async control character map is not supported%s", "\n");
+        return TINY_ERR_INVALID_DATA;
+    }
     // Primary devices always have markers
     protocol->ka_timeout = 5000;
     protocol->retry_timeout = init->retry_timeout ? init->retry_timeout : (protocol->send_timeout / (init->retries + 1));
@@ -457,6 +644,26 @@ int tiny_fd_on_rx_data(tiny_fd_handle_t handle, const void *data, int len)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+int tiny_fd_on_rx_ring(tiny_fd_handle_t handle, const void *base, int size, int head, int tail)
+{
+    if ( !base || size <= 0 || head < 0 || head >= size || tail < 0 || tail >= size )
+    {
+        return TINY_ERR_INVALID_DATA;
+    }
+    while ( tail != head )
+    {
+        int error;
+        tail = hdlc_ll_run_rx_ring(handle->_hdlc, base, size, head, tail, &error);
+        if ( error == TINY_ERR_WRONG_CRC )
+        {
+            LOG(TINY_LOG_WRN, "[%p] HDLC CRC sum mismatch\n", handle);
+        }
+    }
+    return tail;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int tiny_fd_run_rx(tiny_fd_handle_t handle, read_block_cb_t read_func)
 {
     uint8_t buf[4];
@@ -470,44 +677,69 @@ int tiny_fd_run_rx(tiny_fd_handle_t handle, read_block_cb_t read_func)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static uint8_t *tiny_fd_get_next_i_frame(tiny_fd_handle_t handle, int *len, uint8_t peer, uint8_t address)
+static tiny_fd_frame_info_t *tiny_fd_get_next_i_frame(tiny_fd_handle_t handle, uint8_t peer)
 {
-    uint8_t *data = NULL;
     tiny_fd_frame_info_t *ptr = NULL;
     if ( handle->peers[peer].state == TINY_FD_STATE_DISCONNECTED || handle->peers[peer].state == TINY_FD_STATE_CONNECTING )
     {
         // If sending of I-frames is not allowed then just exit
         return NULL;
     }
-    ptr = tiny_fd_queue_get_next( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, address, handle->peers[peer].next_ns );
+    if ( handle->peers[peer].remote_busy )
+    {
+        // Remote station drops I-frames until it reports ready state
+        return NULL;
+    }
+    if ( handle->peers[peer].srej_pending )
+    {
+        // Frame, requested by SREJ, is sent before new frames. It can be confirmed already by the time.
+        handle->peers[peer].srej_pending = 0;
+        ptr = tiny_fd_queue_get_i_frame( &handle->frames.i_queue, peer, handle->peers[peer].srej_ns );
+        if ( ptr != NULL && __is_sent_unconfirmed_frame(handle, peer, handle->peers[peer].srej_ns) )
+        {
+            LOG(TINY_LOG_INFO, "[%p] Resending I-Frame N(R-awaiting)=%02X,N(S-seq sent)=%02X with address [%02X]\n", handle,
+                handle->peers[peer].next_nr, handle->peers[peer].srej_ns, ptr->header.address);
+            __set_frame_nr(handle, ptr, handle->peers[peer].next_nr);
+            handle->peers[peer].sent_nr = handle->peers[peer].next_nr;
+            handle->peers[peer].last_sent_i_ts = tiny_millis();
+            return ptr;
+        }
+    }
+    ptr = tiny_fd_queue_get_i_frame( &handle->frames.i_queue, peer, handle->peers[peer].next_ns );
     if ( ptr != NULL )
     {
-        data = (uint8_t *)&ptr->header;
-        *len = ptr->len + sizeof(tiny_frame_header_t);
         LOG(TINY_LOG_INFO, "[%p] Sending I-Frame N(R-awaiting)=%02X,N(S-seq sent)=%02X with address [%02X] to %s\n", handle, handle->peers[peer].next_nr,
-            handle->peers[peer].next_ns, data[0], __is_primary_station( handle ) ? "secondary" : "primary" );
-        ptr->header.control &= 0x0F;
-        ptr->header.control |= (handle->peers[peer].next_nr << 5);
+            handle->peers[peer].next_ns, ptr->header.address, __is_primary_station( handle ) ? "secondary" : "primary" );
+        __set_frame_nr(handle, ptr, handle->peers[peer].next_nr);
+        if ( handle->peers[peer].next_ns == handle->peers[peer].unsent_ns )
+        {
+            handle->peers[peer].unsent_ns = (handle->peers[peer].unsent_ns + 1) & handle->seq_bits_mask;
+            handle->tx_new_i_frame = 1;
+            if ( handle->peers[peer].urgent_count )
+            {
+                handle->peers[peer].urgent_count--;
+            }
+        }
         handle->peers[peer].next_ns++;
-        handle->peers[peer].next_ns &= seq_bits_mask;
+        handle->peers[peer].next_ns &= handle->seq_bits_mask;
         // Move to different place
         handle->peers[peer].sent_nr = handle->peers[peer].next_nr;
         handle->peers[peer].last_sent_i_ts = tiny_millis();
     }
-    return data;
+    return ptr;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static uint8_t *tiny_fd_get_next_frame_to_send(tiny_fd_handle_t handle, int *len, uint8_t peer)
+static tiny_fd_frame_info_t *tiny_fd_get_next_frame_to_send(tiny_fd_handle_t handle, uint8_t peer)
 {
-    uint8_t *data = NULL;
+    tiny_fd_frame_info_t *data = NULL;
     tiny_mutex_lock(&handle->frames.mutex);
     const uint8_t address = __peer_to_address_field( handle, peer );
-    data = tiny_fd_get_next_s_u_frame_to_send(handle, len, peer, address);
+    data = tiny_fd_get_next_s_u_frame_to_send(handle, peer, address);
     if ( data == NULL )
     {
-        data = tiny_fd_get_next_i_frame(handle, len, peer, address);
+        data = tiny_fd_get_next_i_frame(handle, peer);
     }
     if ( data == NULL && handle->mode == TINY_FD_MODE_NRM )
     {
@@ -516,29 +748,21 @@ static uint8_t *tiny_fd_get_next_frame_to_send(tiny_fd_handle_t handle, int *len
         if ( __is_primary_station( handle ) &&
             ( handle->peers[peer].state == TINY_FD_STATE_DISCONNECTED || handle->peers[peer].state == TINY_FD_STATE_CONNECTING))
         {
-            tiny_frame_header_t frame = {
-                .address = address,
-                .control = HDLC_U_FRAME_TYPE_SNRM | HDLC_U_FRAME_BITS,
-            };
-            __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, &frame, 2);
+            __put_u_frame_with_caps(handle, TINY_FD_QUEUE_S_FRAME, address, __mode_setting_command(handle),
+                                    __needs_caps(handle));
         }
         else
         {
-            tiny_frame_header_t frame = {
-                .address = address,
-                .control = HDLC_S_FRAME_BITS | HDLC_S_FRAME_TYPE_RR | (handle->peers[peer].next_nr << 5),
-            };
-            __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, &frame, 2);
+            __put_s_frame_to_tx_queue(handle, address, __rx_state_frame_type(handle, peer), handle->peers[peer].next_nr);
         }
-        data = tiny_fd_get_next_s_u_frame_to_send(handle, len, peer, address);
+        data = tiny_fd_get_next_s_u_frame_to_send(handle, peer, address);
     }
     if ( data != NULL )
     {
-        tiny_frame_header_t *header = (tiny_frame_header_t *)data;
-        header->control |= HDLC_P_BIT;
+        __set_frame_pf(handle, data);
         handle->last_marker_ts = tiny_millis();
         handle->peers[peer].last_sent_frame_ts = tiny_millis();
-        __tiny_fd_log_frame(handle, TINY_FD_FRAME_DIRECTION_OUT, data, *len);
+        __tiny_fd_log_out_frame(handle, data);
     }
     tiny_mutex_unlock(&handle->frames.mutex);
     return data;
@@ -549,8 +773,28 @@ static uint8_t *tiny_fd_get_next_frame_to_send(tiny_fd_handle_t handle, int *len
 static void tiny_fd_connected_check_idle_timeout(tiny_fd_handle_t handle, uint8_t peer)
 {
     tiny_mutex_lock(&handle->frames.mutex);
+    if ( handle->peers[peer].remote_busy && __has_unconfirmed_frames(handle, peer) )
+    {
+        // I-frames are not resent to busy station, it is polled to check if the state is changed
+        if ( __time_passed_since_last_sent_i_frame(handle, peer) >= handle->retry_timeout )
+        {
+            if ( handle->peers[peer].retries > 0 )
+            {
+                LOG(TINY_LOG_WRN, "[%p] Timeout, polling busy remote receiver\n", handle);
+                handle->peers[peer].retries--;
+                __put_s_frame_to_tx_queue(handle, __peer_to_address_field( handle, peer ) | HDLC_CR_BIT,
+                                          __rx_state_frame_type(handle, peer), handle->peers[peer].next_nr);
+                handle->peers[peer].last_sent_i_ts = tiny_millis();
+            }
+            else
+            {
+                LOG(TINY_LOG_ERR, "[%p] Remote side not responding, flushing I-frames\n", handle);
+                __switch_to_disconnected_state(handle, peer);
+            }
+        }
+    }
     // If all I-frames are sent and no respond from the remote side
-    if ( __has_unconfirmed_frames(handle, peer) && __all_frames_are_sent(handle, peer) &&
+    else if ( __has_unconfirmed_frames(handle, peer) && __all_frames_are_sent(handle, peer) &&
          __time_passed_since_last_sent_i_frame(handle, peer) >= handle->retry_timeout )
     {
         // if sent frame was not confirmed due to noisy line
@@ -562,7 +806,15 @@ static void tiny_fd_connected_check_idle_timeout(tiny_fd_handle_t handle, uint8_
                 handle, handle->peers[peer].last_sent_i_ts, tiny_millis(), handle->retry_timeout);
             handle->peers[peer].retries--;
             // Do not use mutex for confirm_ns value as it is byte-value
-            __resend_all_unconfirmed_frames(handle, peer, 0, handle->peers[peer].confirm_ns);
+            if ( handle->peers[peer].srej )
+            {
+                // Only the oldest frame is resent, remote station answers with RR or SREJ for the rest
+                __resend_unconfirmed_frame(handle, peer, 0, handle->peers[peer].confirm_ns);
+            }
+            else
+            {
+                __resend_all_unconfirmed_frames(handle, peer, 0, handle->peers[peer].confirm_ns);
+            }
         }
         else
         {
@@ -581,12 +833,9 @@ static void tiny_fd_connected_check_idle_timeout(tiny_fd_handle_t handle, uint8_
     else if ( __time_passed_since_last_frame_sent(handle, peer) >= handle->ka_timeout )
     {
         // Nothing to send, all frames are confirmed, just send keep alive
-        tiny_frame_header_t frame = {
-            .address = __peer_to_address_field( handle, peer ),
-            .control = HDLC_S_FRAME_BITS | HDLC_S_FRAME_TYPE_RR | (handle->peers[peer].next_nr << 5),
-        };
         handle->peers[peer].ka_confirmed = 0;
-        __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, &frame, 2);
+        __put_s_frame_to_tx_queue(handle, __peer_to_address_field( handle, peer ), __rx_state_frame_type(handle, peer),
+                                  handle->peers[peer].next_nr);
         handle->peers[peer].last_sent_frame_ts = tiny_millis();
     }
     tiny_mutex_unlock(&handle->frames.mutex);
@@ -604,11 +853,9 @@ static void tiny_fd_disconnected_check_idle_timeout(tiny_fd_handle_t handle, uin
             LOG(TINY_LOG_WRN, "[%p] Connection is not established, connecting to peer %02X [addr:%02X]\n", handle,
                    handle->next_peer, __peer_to_address_field( handle, peer ));
             // Try to establish Connection
-            tiny_frame_header_t frame = {
-                .address = __peer_to_address_field( handle, peer ) | HDLC_CR_BIT,
-                .control = (handle->mode == TINY_FD_MODE_NRM ? HDLC_U_FRAME_TYPE_SNRM : HDLC_U_FRAME_TYPE_SABM) | HDLC_U_FRAME_BITS,
-            };
-            if ( __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_U_FRAME, &frame, 2) == NULL )
+            uint8_t control = __mode_setting_command(handle);
+            if ( __put_u_frame_with_caps(handle, TINY_FD_QUEUE_U_FRAME, __peer_to_address_field( handle, peer ) | HDLC_CR_BIT,
+                                         control, __needs_caps(handle)) == NULL )
             {
                 LOG(TINY_LOG_CRIT, "[%p] Failed to queue SNRM/SABM message for peer %02X [addr:%02X]\n", handle,
                        handle->next_peer, __peer_to_address_field( handle, peer ));
@@ -622,14 +869,69 @@ static void tiny_fd_disconnected_check_idle_timeout(tiny_fd_handle_t handle, uin
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Aborts I-frame, being sent by hdlc level, if urgent frame waits in the queue.
+ * Only the frame, which is sent for the first time, can be aborted: its N(S) is given
+ * to urgent frame, and the aborted frame gets the next N(S) and is sent again from the start.
+ * S- and U-frames are short, and are never aborted. In NRM mode stations send frames only
+ * in their turn, marked with poll/final bit, so the frames are never aborted there either.
+ */
+static void tiny_fd_preempt_i_frame(tiny_fd_handle_t handle, uint8_t peer)
+{
+    if ( handle->mode != TINY_FD_MODE_ABM || !handle->tx_new_i_frame || handle->preempted ||
+         !handle->peers[peer].urgent_count )
+    {
+        return;
+    }
+    tiny_mutex_lock(&handle->frames.mutex);
+    const uint8_t ns = (handle->peers[peer].next_ns - 1) & handle->seq_bits_mask;
+    tiny_fd_frame_info_t *urgent = NULL;
+    // Frame being sent must be the last sent one, and it must be still in the queue
+    if ( handle->peers[peer].urgent_count && handle->peers[peer].unsent_ns == handle->peers[peer].next_ns &&
+         tiny_fd_queue_get_i_frame( &handle->frames.i_queue, peer, ns ) )
+    {
+        urgent = tiny_fd_queue_get_i_frame( &handle->frames.i_queue, peer, handle->peers[peer].next_ns );
+    }
+    if ( urgent != NULL )
+    {
+        tiny_fd_frame_info_t *bulk = tiny_fd_queue_get_i_frame( &handle->frames.i_queue, peer, ns );
+        __set_frame_ns(handle, urgent, ns);
+        __set_frame_nr(handle, urgent, handle->peers[peer].next_nr);
+        __set_frame_pf(handle, urgent);
+        hdlc_ll_segment_t segments[TINY_HDLC_MAX_SEGMENTS];
+        int count = __frame_to_segments(handle, urgent, segments);
+        if ( hdlc_ll_preempt(handle->_hdlc, segments, count) == TINY_SUCCESS )
+        {
+            LOG(TINY_LOG_INFO, "[%p] Urgent I-Frame preempts N(S)=%02X\n", handle, ns);
+            // Preempted frame is sent after urgent one, so N(R) must not go back
+            __set_frame_ns(handle, bulk, handle->peers[peer].next_ns);
+            __set_frame_nr(handle, bulk, handle->peers[peer].next_nr);
+            __set_frame_pf(handle, bulk);
+            tiny_fd_queue_set_i_frame( &handle->frames.i_queue, peer, ns, urgent );
+            tiny_fd_queue_set_i_frame( &handle->frames.i_queue, peer, handle->peers[peer].next_ns, bulk );
+            handle->peers[peer].next_ns = (handle->peers[peer].next_ns + 1) & handle->seq_bits_mask;
+            handle->peers[peer].unsent_ns = handle->peers[peer].next_ns;
+            handle->peers[peer].urgent_count--;
+            handle->peers[peer].sent_nr = handle->peers[peer].next_nr;
+            handle->peers[peer].last_sent_i_ts = tiny_millis();
+            handle->preempted = 1;
+            __tiny_fd_log_out_frame(handle, urgent);
+        }
+        else
+        {
+            __set_frame_ns(handle, urgent, handle->peers[peer].next_ns);
+        }
+    }
+    tiny_mutex_unlock(&handle->frames.mutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t timeout)
 {
-    // TODO: !!!!!
-    // We cannot generate data forever, and we should return result as soon as possible
-    // Now this is not true for NRM mode, as we can generate data forever until 
-    // passed buffer is filled up.
     bool repeat = true;
-    bool wait_point_passed = false;
+    // Only the first frame is waited for, all next frames are taken if they are ready
+    uint32_t wait_timeout = timeout;
     int result = 0;
     // TODO: Check for correct mutex usage here. Some fields are not protected
     const uint8_t peer = handle->next_peer;
@@ -639,7 +941,15 @@ int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t t
         // Check if send on hdlc level operation is in progress and do some work
         if ( tiny_events_wait(&handle->events, FD_EVENT_TX_SENDING, EVENT_BITS_LEAVE, 0) )
         {
+            tiny_fd_preempt_i_frame(handle, peer);
             generated_data = hdlc_ll_run_tx(handle->_hdlc, ((uint8_t *)data) + result, len - result);
+            // Primary station switches to the next peer, when the poll is sent. The next peer
+            // is served by the next call, even if the marker comes back in this one.
+            if ( handle->mode == TINY_FD_MODE_NRM && __is_primary_station( handle ) && handle->next_peer != peer )
+            {
+                result += generated_data;
+                break;
+            }
         }
         else
         {
@@ -656,20 +966,19 @@ int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t t
             {
                 tiny_fd_disconnected_check_idle_timeout(handle, peer);
             }
-            // TODO: This point cannot be reached twice!!!!
-            if (wait_point_passed) {
-                break;
-            }
-            wait_point_passed = true;
             // Since no send operation is in progress, check if we have something to send
-            // Check if the station has marker to send FIRST (That means, we are allowed to send anything still)
-            if ( tiny_events_wait(&handle->events, FD_EVENT_HAS_MARKER, EVENT_BITS_LEAVE, timeout ) )
+            // Check if the station has marker to send FIRST (That means, we are allowed to send anything still).
+            // In NRM mode the marker is released with each sent frame, so the next frame is sent in the same call
+            // only after the marker comes back.
+            if ( tiny_events_wait(&handle->events, FD_EVENT_HAS_MARKER, EVENT_BITS_LEAVE, wait_timeout) )
             {
-                if ( tiny_events_wait(&handle->events, FD_EVENT_TX_DATA_AVAILABLE, EVENT_BITS_CLEAR, timeout) || handle->mode == TINY_FD_MODE_NRM )
+                bool has_data = tiny_events_wait(&handle->events, FD_EVENT_TX_DATA_AVAILABLE, EVENT_BITS_CLEAR, wait_timeout) != 0;
+                wait_timeout = 0;
+                if ( has_data || handle->mode == TINY_FD_MODE_NRM )
                 {
-                    int frame_len = 0;
-                    uint8_t *frame_data = tiny_fd_get_next_frame_to_send(handle, &frame_len, peer);
-                    if ( frame_data != NULL )
+                    handle->tx_new_i_frame = 0;
+                    tiny_fd_frame_info_t *frame = tiny_fd_get_next_frame_to_send(handle, peer);
+                    if ( frame != NULL )
                     {
                         // Force to check for new frame once again
                         tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
@@ -677,7 +986,11 @@ int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t t
                         // Do not use timeout for hdlc_send(), as hdlc level is ready to accept next frame
                         // (FD_EVENT_TX_SENDING is not set). And at this step we do not need hdlc_send() to
                         // send data.
-                        hdlc_ll_put_frame(handle->_hdlc, frame_data, frame_len);
+                        // Header and payload are passed as separate segments, so hdlc level doesn't
+                        // depend on their placement in the frame slot.
+                        hdlc_ll_segment_t segments[TINY_HDLC_MAX_SEGMENTS];
+                        int count = __frame_to_segments(handle, frame, segments);
+                        hdlc_ll_put_frame_v(handle->_hdlc, segments, count);
                         continue;
                     }
                     else if ( handle->mode == TINY_FD_MODE_ABM || __is_secondary_station( handle ) )
@@ -692,6 +1005,7 @@ int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t t
             }
             else if ( __is_primary_station( handle ) )
             {
+                wait_timeout = 0;
                 if ( __time_passed_since_last_marker_seen(handle) >= handle->retry_timeout )
                 {
                     // Return marker back to primary station as remote station not responding
@@ -703,6 +1017,10 @@ int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t t
                     break;
                 }
             }
+            else
+            {
+                break;
+            }
         }
         if (result >= 0) {
             result += generated_data;
@@ -725,6 +1043,28 @@ int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t t
 
 ///////////////////////////////////////////////////////////////////////////////
 
+int tiny_fd_get_tx_block(tiny_fd_handle_t handle, void *block, int block_size)
+{
+    // Block transaction happens anyway, so there is no sense to wait for the data
+    int len = tiny_fd_get_tx_data(handle, block, block_size, 0);
+    if ( len < 0 )
+    {
+        return len;
+    }
+    memset((uint8_t *)block + len, hdlc_ll_get_fill_byte(handle->_hdlc), block_size - len);
+    return block_size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_on_rx_block(tiny_fd_handle_t handle, const void *block, int block_size)
+{
+    // Fill bytes between the frames are skipped by hdlc level in bulk
+    return tiny_fd_on_rx_data(handle, block, block_size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int tiny_fd_run_tx(tiny_fd_handle_t handle, write_block_cb_t write_func)
 {
     uint8_t buf[4];
@@ -749,7 +1089,8 @@ int tiny_fd_run_tx(tiny_fd_handle_t handle, write_block_cb_t write_func)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-int tiny_fd_send_packet_to(tiny_fd_handle_t handle, uint8_t address, const void *data, int len, uint32_t timeout)
+int tiny_fd_send_packet_ex(tiny_fd_handle_t handle, uint8_t address, const void *data, int len, uint32_t timeout,
+                           uint8_t flags)
 {
     int result = TINY_SUCCESS;
     uint8_t peer;
@@ -768,9 +1109,9 @@ int tiny_fd_send_packet_to(tiny_fd_handle_t handle, uint8_t address, const void
     // Check frame size againts mtu
     // MTU doesn't include header and crc fields, only user payload
     uint32_t start_ms = tiny_millis();
-    if ( len > tiny_fd_queue_get_mtu( &handle->frames.i_queue ) )
+    if ( len > tiny_fd_get_mtu( handle ) )
     {
-        LOG(TINY_LOG_ERR, "[%p] PUT frame error: data len %i is greater MTU %i\n", handle, len, handle->frames.i_queue.mtu);
+        LOG(TINY_LOG_ERR, "[%p] PUT frame error: data len %i is greater MTU %i\n", handle, len, tiny_fd_get_mtu( handle ));
         result = TINY_ERR_DATA_TOO_LARGE;
     }
     // Wait until there is room for new frame
@@ -782,7 +1123,7 @@ int tiny_fd_send_packet_to(tiny_fd_handle_t handle, uint8_t address, const void
         {
             tiny_mutex_lock(&handle->frames.mutex);
             // Check if space is actually available
-            if ( __put_i_frame_to_tx_queue(handle, peer, data, len) )
+            if ( __put_i_frame_to_tx_queue(handle, peer, data, len, (flags & TINY_FD_SEND_URGENT) != 0) )
             {
                 if ( tiny_fd_queue_has_free_slots( &handle->frames.i_queue ) )
                 {
@@ -828,6 +1169,13 @@ int tiny_fd_send_packet_to(tiny_fd_handle_t handle, uint8_t address, const void
 
 ///////////////////////////////////////////////////////////////////////////////
 
+int tiny_fd_send_packet_to(tiny_fd_handle_t handle, uint8_t address, const void *data, int len, uint32_t timeout)
+{
+    return tiny_fd_send_packet_ex(handle, address, data, len, timeout, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int tiny_fd_send_packet(tiny_fd_handle_t handle, const void *data, int len, uint32_t timeout)
 {
     return tiny_fd_send_packet_to(handle, TINY_FD_PRIMARY_ADDR, data, len, timeout);
@@ -835,6 +1183,152 @@ int tiny_fd_send_packet(tiny_fd_handle_t handle, const void *data, int len, uint
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void *tiny_fd_reserve(tiny_fd_handle_t handle, uint8_t address, int max_len, uint32_t timeout)
+{
+    void *data = NULL;
+    uint8_t peer;
+    LOG(TINY_LOG_DEB, "[%p] RESERVE frame\n", handle);
+    if ( __is_secondary_station( handle ) && address == TINY_FD_PRIMARY_ADDR )
+    {
+        // For secondary stations the address is actually from field
+        address = handle->addr;
+    }
+    peer = __address_field_to_peer( handle, (address << 2) | HDLC_E_BIT );
+    if ( peer == HDLC_INVALID_PEER_INDEX )
+    {
+        LOG(TINY_LOG_ERR, "[%p] RESERVE frame error: Unknown peer\n", handle);
+        return NULL;
+    }
+    if ( max_len > tiny_fd_get_mtu( handle ) )
+    {
+        LOG(TINY_LOG_ERR, "[%p] RESERVE frame error: data len %i is greater MTU %i\n", handle, max_len, tiny_fd_get_mtu( handle ));
+        return NULL;
+    }
+    uint32_t start_ms = tiny_millis();
+    // Reserved slot takes place in the window, so wait until there is room for new frame
+    if ( !tiny_events_wait(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES, EVENT_BITS_CLEAR, timeout) )
+    {
+        LOG(TINY_LOG_WRN, "[%p] RESERVE frame timeout\n", handle);
+        return NULL;
+    }
+    uint32_t delta_ms = (uint32_t)(tiny_millis() - start_ms);
+    if ( tiny_events_wait(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS, EVENT_BITS_CLEAR,
+                           timeout > delta_ms ? (timeout - delta_ms) : 0) )
+    {
+        tiny_mutex_lock(&handle->frames.mutex);
+        tiny_fd_frame_info_t *slot = tiny_fd_queue_allocate( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, NULL, 0 );
+        if ( slot != NULL )
+        {
+            // Slot is not in the index until commit, only the address is needed to find the peer
+            slot->header.address = __peer_to_address_field( handle, peer );
+            handle->peers[peer].reserved++;
+            // Keep the first byte for compression flag, it is filled on commit
+            data = &slot->payload[handle->compression];
+        }
+        else
+        {
+            // !!!! If this log appears, then in the code of the protocol something is definitely wrong !!!!
+            LOG(TINY_LOG_ERR, "[%p] Wrong flag FD_EVENT_QUEUE_HAS_FREE_SLOTS\n", handle);
+        }
+        if ( tiny_fd_queue_has_free_slots( &handle->frames.i_queue ) )
+        {
+            tiny_events_set(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS);
+        }
+        if ( __can_accept_i_frames( handle, peer ) )
+        {
+            tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+        }
+        tiny_mutex_unlock(&handle->frames.mutex);
+    }
+    else
+    {
+        // Put flag back, since the window is not used by this call
+        tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+        LOG(TINY_LOG_WRN, "[%p] RESERVE frame timeout\n", handle);
+    }
+    return data;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static tiny_fd_frame_info_t *__reserved_data_to_slot(tiny_fd_handle_t handle, void *data)
+{
+    return (tiny_fd_frame_info_t *)((uint8_t *)data - handle->compression - offsetof(tiny_fd_frame_info_t, payload));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void __release_reserved_slot(tiny_fd_handle_t handle, uint8_t peer, tiny_fd_frame_info_t *slot)
+{
+    handle->peers[peer].reserved--;
+    tiny_fd_queue_free( &handle->frames.i_queue, slot );
+    tiny_events_set(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS);
+    if ( __can_accept_i_frames( handle, peer ) && handle->peers[peer].state != TINY_FD_STATE_DISCONNECTED )
+    {
+        tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_commit(tiny_fd_handle_t handle, void *data, int len)
+{
+    if ( data == NULL || len < 0 )
+    {
+        return TINY_ERR_INVALID_DATA;
+    }
+    tiny_fd_frame_info_t *slot = __reserved_data_to_slot( handle, data );
+    if ( len > tiny_fd_get_mtu( handle ) )
+    {
+        LOG(TINY_LOG_ERR, "[%p] COMMIT frame error: data len %i is greater MTU %i\n", handle, len, tiny_fd_get_mtu( handle ));
+        return TINY_ERR_DATA_TOO_LARGE;
+    }
+    tiny_mutex_lock(&handle->frames.mutex);
+    uint8_t peer = __address_field_to_peer( handle, slot->header.address );
+    if ( handle->peers[peer].state != TINY_FD_STATE_CONNECTED )
+    {
+        LOG(TINY_LOG_ERR, "[%p] COMMIT frame error: connection is lost\n", handle);
+        __release_reserved_slot( handle, peer, slot );
+        tiny_mutex_unlock(&handle->frames.mutex);
+        return TINY_ERR_FAILED;
+    }
+    handle->peers[peer].reserved--;
+    if ( handle->peers[peer].compression )
+    {
+        slot->payload[0] = TINY_FD_I_FRAME_RAW;
+        len++;
+    }
+    else if ( handle->compression )
+    {
+        // Remote side doesn't support compression, so the flag byte is not sent
+        memmove(&slot->payload[0], &slot->payload[1], len);
+    }
+    slot->len = len;
+    __queue_i_frame( handle, peer, slot, false );
+    if ( __can_accept_i_frames( handle, peer ) )
+    {
+        tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+    }
+    tiny_mutex_unlock(&handle->frames.mutex);
+    return TINY_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void tiny_fd_cancel(tiny_fd_handle_t handle, void *data)
+{
+    if ( data == NULL )
+    {
+        return;
+    }
+    tiny_fd_frame_info_t *slot = __reserved_data_to_slot( handle, data );
+    tiny_mutex_lock(&handle->frames.mutex);
+    __release_reserved_slot( handle, __address_field_to_peer( handle, slot->header.address ), slot );
+    tiny_mutex_unlock(&handle->frames.mutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int tiny_fd_buffer_size_by_mtu(int mtu, int window)
 {
     return tiny_fd_buffer_size_by_mtu_ex(0, mtu, window, HDLC_CRC_16, 1);
@@ -853,22 +1347,43 @@ int tiny_fd_buffer_size_by_mtu_ex(uint8_t peers_count, int mtu, int tx_window, h
     int header_size = sizeof(tiny_fd_data_t) + TINY_ALIGN_STRUCT_VALUE - 1 +
                       peers_count * sizeof(tiny_fd_peer_info_t);
     // Buffer size to hold HDLC low level protocol RX data
-    int hdlc_level_rx_size = hdlc_ll_get_buf_size_ex(mtu + sizeof(tiny_frame_header_t), crc_type, rx_window);
+    // Extended mode uses 2-byte control field
+    int hdlc_level_rx_size = hdlc_ll_get_buf_size_ex(mtu + TINY_FD_MAX_HEADER_SIZE, crc_type, rx_window);
     // minimum size of i-frame including header and payload
-    int i_frame_tx_size = (sizeof(tiny_fd_frame_info_t *) + sizeof(tiny_fd_frame_info_t) + mtu -
-            sizeof(((tiny_fd_frame_info_t *)0)->payload));
-    // minimum size of s-frame/u-frame including header and 2-bytes payload
-    // this size includes internal library overhead, introduced by the pointer to the frame info
-    int u_s_frame_tx_size = (sizeof(tiny_fd_frame_info_t *) + sizeof(tiny_fd_frame_info_t));
+    int i_frame_tx_size = (sizeof(tiny_fd_frame_info_t) + mtu - sizeof(((tiny_fd_frame_info_t *)0)->payload));
+    // minimum size of s-frame/u-frame including header and information field
+    int u_s_frame_tx_size = TINY_FD_U_FRAME_SLOT_SIZE;
     return header_size +
            hdlc_level_rx_size +
-           // TX side
-           i_frame_tx_size * tx_window +
+           // TX side: frames and N(S) index of I-frames for each peer
+           i_frame_tx_size * tx_window + peers_count * tiny_fd_queue_get_ring_size(tx_window) +
            u_s_frame_tx_size * TINY_FD_U_QUEUE_MAX_SIZE;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
+int tiny_fd_compression_buffer_size(int mtu, int tx_window)
+{
+    // Match table and decompressed frame buffer, compression flag in each tx frame and in rx frame
+    return (int)TINY_LZ_TABLE_SIZE + mtu + TINY_ALIGN_STRUCT_VALUE - 1 + tx_window + 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_srej_buffer_size(uint8_t peers_count, int mtu, int window)
+{
+    if ( !peers_count )
+    {
+        peers_count = 1;
+    }
+    // Slots for out-of-order frames with compression flag, each slot is aligned
+    return peers_count * (window - 1) *
+               (int)(offsetof(tiny_fd_rx_slot_t, payload) + mtu + 1 + TINY_ALIGN_STRUCT_VALUE - 1) +
+           TINY_ALIGN_STRUCT_VALUE - 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void tiny_fd_set_ka_timeout(tiny_fd_handle_t handle, uint32_t keep_alive)
 {
     handle->ka_timeout = keep_alive;
@@ -878,7 +1393,50 @@ void tiny_fd_set_ka_timeout(tiny_fd_handle_t handle, uint32_t keep_alive)
 
 int tiny_fd_get_mtu(tiny_fd_handle_t handle)
 {
-    return tiny_fd_queue_get_mtu( &handle->frames.i_queue );
+    // One byte of I-frame slots is reserved for compression flag
+    return tiny_fd_queue_get_mtu( &handle->frames.i_queue ) - handle->compression;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_loan_frame(tiny_fd_handle_t handle, const void *data)
+{
+    return hdlc_ll_loan_frame(handle->_hdlc, data);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_release_frame(tiny_fd_handle_t handle, const void *data)
+{
+    return hdlc_ll_release_frame(handle->_hdlc, data);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void tiny_fd_set_rx_ready(tiny_fd_handle_t handle, bool ready)
+{
+    tiny_mutex_lock(&handle->frames.mutex);
+    for ( uint8_t peer = 0; peer < handle->peers_count; peer++ )
+    {
+        if ( (handle->peers[peer].local_busy == 0) == ready )
+        {
+            // State of the receiver is not changed
+            continue;
+        }
+        // Dropped frames are requested with REJ, which also reports ready state
+        uint8_t type = !ready ? HDLC_S_FRAME_TYPE_RNR
+                              : (handle->peers[peer].local_busy > 1 ? HDLC_S_FRAME_TYPE_REJ : HDLC_S_FRAME_TYPE_RR);
+        handle->peers[peer].local_busy = !ready;
+        if ( handle->peers[peer].state == TINY_FD_STATE_CONNECTED )
+        {
+            LOG(TINY_LOG_INFO, "[%p] Receiver is %s\n", handle, ready ? "ready" : "busy");
+            __put_s_frame_to_tx_queue(handle, __peer_to_address_field( handle, peer ) |
+                                          (type == HDLC_S_FRAME_TYPE_REJ ? HDLC_CR_BIT : 0),
+                                      type, handle->peers[peer].next_nr);
+            handle->peers[peer].sent_reject = type == HDLC_S_FRAME_TYPE_REJ;
+        }
+    }
+    tiny_mutex_unlock(&handle->frames.mutex);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -889,8 +1447,7 @@ int tiny_fd_send_to(tiny_fd_handle_t handle, uint8_t address, const void *data,
     int left_bytes = len;
     while ( left_bytes > 0 )
     {
-        int size = left_bytes < tiny_fd_queue_get_mtu( &handle->frames.i_queue ) ?
-                        left_bytes : tiny_fd_queue_get_mtu( &handle->frames.i_queue );
+        int size = left_bytes < tiny_fd_get_mtu( handle ) ? left_bytes : tiny_fd_get_mtu( handle );
         int result = tiny_fd_send_packet_to(handle, address, ptr, size, timeout);
         if ( result != TINY_SUCCESS )
         {
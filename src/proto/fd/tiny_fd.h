@@ -44,6 +44,7 @@ extern "C"
 
 #include <stdint.h>
 #include "proto/crc/tiny_crc.h"
+#include "proto/hdlc/low_level/hdlc.h"
 #include "hal/tiny_types.h"
 
     /**
@@ -56,6 +57,13 @@ extern "C"
      */
     #define TINY_FD_PRIMARY_ADDR (0)
 
+    /**
+     * Flag for tiny_fd_send_packet_ex(). Urgent frame is sent before all frames, which were
+     * not sent yet. In ABM mode urgent frame also aborts I-frame, being sent for the first time,
+     * and that frame is sent again after urgent one.
+     */
+    #define TINY_FD_SEND_URGENT (0x01)
+
     enum
     {
         /**
@@ -107,7 +115,9 @@ extern "C"
     typedef enum
     {
         TINY_FD_FRAME_SUBTYPE_RR = 0x00, ///< S-frame subtype RR
+        TINY_FD_FRAME_SUBTYPE_RNR = 0x04, ///< S-frame subtype RNR
         TINY_FD_FRAME_SUBTYPE_REJ = 0x08, ///< S-frame subtype REJ
+        TINY_FD_FRAME_SUBTYPE_SREJ = 0x0C, ///< S-frame subtype SREJ
 
         TINY_FD_FRAME_SUBTYPE_UA = 0x60, ///< U-frame subtype UA
         TINY_FD_FRAME_SUBTYPE_FRMR = 0x84, ///< U-frame subtype FRMR
@@ -138,8 +148,8 @@ extern "C"
      * @param handle handle of Tiny.
      * @param direction direction of the frame, can be TINY_FD_FRAME_DIRECTION_IN or TINY_FD_FRAME_DIRECTION_OUT.
      * @param frame_type type of the frame, can be TINY_FD_FRAME_TYPE_I, TINY_FD_FRAME_TYPE_S or TINY_FD_FRAME_TYPE_U.
-     * @param frame_subtype subtype of the frame, can be TINY_FD_FRAME_SUBTYPE_RR, TINY_FD_FRAME_SUBTYPE_REJ,
-     *                     TINY_FD_FRAME_SUBTYPE_UA, TINY_FD_FRAME_SUBTYPE_FRMR, TINY_FD_FRAME_SUBTYPE_RSET,
+     * @param frame_subtype subtype of the frame, can be TINY_FD_FRAME_SUBTYPE_RR, TINY_FD_FRAME_SUBTYPE_RNR, TINY_FD_FRAME_SUBTYPE_REJ,
+     *                     TINY_FD_FRAME_SUBTYPE_SREJ, TINY_FD_FRAME_SUBTYPE_UA, TINY_FD_FRAME_SUBTYPE_FRMR, TINY_FD_FRAME_SUBTYPE_RSET,
      *                     TINY_FD_FRAME_SUBTYPE_SABM, TINY_FD_FRAME_SUBTYPE_SNRM or TINY_FD_FRAME_SUBTYPE_DISC.
      * @param ns N(S) sequence number of the frame.
      * @param nr N(R) sequence number of the frame.
@@ -204,8 +214,8 @@ extern "C"
         hdlc_crc_t crc_type;
 
         /**
-         * Number of frames in window, which confirmation may be deferred for. Must be at least 1. Maximum allowable
-         * value is 7. Extended HDLC format (with 127 window size) is not yet supported.
+         * Number of frames in window, which confirmation may be deferred for. Must be at least 2. Maximum allowable
+         * value is 7, or 127 if extended mode is enabled.
          * Smaller values reduce channel throughput, while higher values require more RAM.
          * It is not mandatory to have the same window_frames value on both endpoints.
          */
@@ -253,6 +263,49 @@ extern "C"
          */
         uint8_t mode;
 
+        /**
+         * Async control character map (RFC 1662): bit N set means that control character N (0x00 - 0x1F)
+         * must not appear on the line as is, for example, 0x000A0000 for links with XON/XOFF flow control.
+         * Local station always escapes such characters, and sends the map to the remote station in
+         * SABM, SNRM and UA frames, so the remote station escapes them too. When both stations
+         * support the map, characters received without escaping are discarded as line noise.
+         * 0 means that only 0x7E and 0x7D are escaped, and the map is not sent.
+         * Non-zero map requires the library to be built with CONFIG_ENABLE_ACCM.
+         */
+        uint32_t accm;
+
+        /**
+         * Framing to use on hdlc level: HDLC_FRAMING_HDLC (default) or HDLC_FRAMING_COBS.
+         * Both stations must use the same framing. Async control character map is not used with
+         * COBS framing.
+         */
+        hdlc_framing_t framing;
+
+        /**
+         * Set to 1 to compress payload of I-frames (LZ4 block format). Compression is used only
+         * if the remote station supports it, this is negotiated on connection. Each frame falls
+         * back to raw payload if compression doesn't make it shorter. The protocol needs additional
+         * space in the buffer, see tiny_fd_compression_buffer_size().
+         */
+        uint8_t compression;
+
+        /**
+         * Set to 1 to use extended mode: connection is established with SABME or SNRME, I- and S-frames
+         * have 2-byte control field with 7-bit sequence numbers, and window_frames can be up to 127.
+         * Large window keeps high-latency links busy. Both stations must use the same mode.
+         */
+        uint8_t extended;
+
+        /**
+         * Set to 1 to use selective reject: out-of-order I-frames are kept in the receive buffer,
+         * and only the missing frame is requested with SREJ frame instead of resending whole window.
+         * Selective reject is used only if the remote station supports it, this is negotiated on
+         * connection. Not more than half of sequence numbers can be used by unconfirmed frames,
+         * i.e. 4 frames in basic mode and 64 frames in extended mode. The protocol needs additional
+         * space in the buffer, see tiny_fd_srej_buffer_size().
+         */
+        uint8_t srej;
+
     } tiny_fd_init_t;
 
     /**
@@ -314,6 +367,32 @@ extern "C"
      */
     extern int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t timeout);
 
+    /**
+     * @brief fills fixed-size block for block transports (SPI, USB bulk, etc.)
+     *
+     * Runs tx processing without waiting, and pads the rest of the block with fill bytes, so
+     * the block always contains exactly block_size bytes. The remote side passes received
+     * blocks to tiny_fd_on_rx_block(), which skips the padding in bulk.
+     *
+     * @param handle handle of full-duplex protocol
+     * @param block pointer to the block to fill
+     * @param block_size size of the block in bytes
+     * @return block_size or negative error code, returned by tiny_fd_get_tx_data()
+     */
+    extern int tiny_fd_get_tx_block(tiny_fd_handle_t handle, void *block, int block_size);
+
+    /**
+     * @brief processes fixed-size block, received from block transport
+     *
+     * Processes the block, filled by tiny_fd_get_tx_block() on the remote side.
+     *
+     * @param handle handle of full-duplex protocol
+     * @param block pointer to the received block
+     * @param block_size size of the block in bytes
+     * @return TINY_SUCCESS
+     */
+    extern int tiny_fd_on_rx_block(tiny_fd_handle_t handle, const void *block, int block_size);
+
     /**
      * @brief sends tx data to the communication channel via user callback `write_func()`.
      *
@@ -344,6 +423,22 @@ extern "C"
      */
     extern int tiny_fd_on_rx_data(tiny_fd_handle_t handle, const void *data, int len);
 
+    /**
+     * @brief runs rx bytes processing for data in the circular buffer.
+     *
+     * Processes all bytes from tail up to head of the circular buffer (for example, DMA buffer
+     * in circular mode) in place, without copying wrapped data to a linear buffer.
+     *
+     * @param handle handle of full-duplex protocol
+     * @param base pointer to the circular buffer
+     * @param size size of the circular buffer in bytes
+     * @param head producer index: offset of the byte, which will be written next by the producer
+     * @param tail consumer index: offset of the first not processed byte
+     * @return new tail value, which is equal to head,
+     *         TINY_ERR_INVALID_DATA if ring parameters are invalid
+     */
+    extern int tiny_fd_on_rx_ring(tiny_fd_handle_t handle, const void *base, int size, int head, int tail);
+
     /**
      * @brief reads rx data from the communication channel via user callback `read_func()`
      *
@@ -390,6 +485,70 @@ extern "C"
      */
     extern int tiny_fd_send_packet_to(tiny_fd_handle_t handle, uint8_t address, const void *buf, int len, uint32_t timeout);
 
+    /**
+     * @brief Sends userdata over full-duplex protocol with extra flags.
+     *
+     * Works the same way as tiny_fd_send_packet_to(), but accepts flags. If TINY_FD_SEND_URGENT
+     * flag is set, the frame bypasses frames, waiting in the queue, and can preempt the frame,
+     * currently being transmitted. Order of urgent frames is kept.
+     *
+     * @note Only I-frame, sent for the first time, can be preempted, and only in ABM mode.
+     *       Resent I-frames, S- and U-frames are always completed, and in NRM mode the urgent
+     *       frame only bypasses the queue. Preemption also requires hdlc TX queue of 2 or more
+     *       frames (TINY_HDLC_TX_QUEUE_SIZE), otherwise the urgent frame follows the current one.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param address  address of remote peer. For primary device, please use TINY_FD_PRIMARY_ADDR
+     * @param buf      data to send
+     * @param len      length of data to send
+     * @param timeout  timeout in milliseconds to wait until data are placed to outgoing queue
+     * @param flags    0 or TINY_FD_SEND_URGENT
+     *
+     * @return the same codes as tiny_fd_send_packet_to()
+     */
+    extern int tiny_fd_send_packet_ex(tiny_fd_handle_t handle, uint8_t address, const void *buf, int len,
+                                      uint32_t timeout, uint8_t flags);
+
+    /**
+     * @brief Reserves I-frame slot in outgoing queue to build the frame in place.
+     *
+     * Returns pointer to the payload of free I-frame slot, so the application writes the data
+     * directly to the queue, without copying. The slot takes place in the window, but the frame
+     * is not sent until tiny_fd_commit() is called. Unused slot must be returned with tiny_fd_cancel().
+     * Reserved frames are not compressed.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param address  address of remote peer. For primary device, please use TINY_FD_PRIMARY_ADDR
+     * @param max_len  maximum length of data, which will be written to the slot, up to mtu
+     * @param timeout  timeout in milliseconds to wait until the slot is available
+     *
+     * @return pointer to the buffer of max_len bytes, or NULL if peer is unknown, max_len is greater
+     *         than mtu, or there is no free slot after timeout
+     */
+    extern void *tiny_fd_reserve(tiny_fd_handle_t handle, uint8_t address, int max_len, uint32_t timeout);
+
+    /**
+     * @brief Puts reserved I-frame to outgoing queue.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param data     pointer, returned by tiny_fd_reserve()
+     * @param len      length of data, written to the slot
+     *
+     * @return TINY_SUCCESS if the frame is queued, or error code
+     *         * TINY_ERR_INVALID_DATA if data is NULL or len is negative, the slot is still reserved.
+     *         * TINY_ERR_DATA_TOO_LARGE if len is greater than mtu, the slot is still reserved.
+     *         * TINY_ERR_FAILED if the peer is not connected, the slot is freed.
+     */
+    extern int tiny_fd_commit(tiny_fd_handle_t handle, void *data, int len);
+
+    /**
+     * @brief Returns reserved I-frame slot to the queue without sending.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param data     pointer, returned by tiny_fd_reserve(). NULL is ignored.
+     */
+    extern void tiny_fd_cancel(tiny_fd_handle_t handle, void *data);
+
     /**
      * Returns minimum required buffer size for specified parameters.
      *
@@ -411,6 +570,25 @@ extern "C"
      */
     extern int tiny_fd_buffer_size_by_mtu_ex(uint8_t peers_count, int mtu, int tx_window, hdlc_crc_t crc_type, int rx_window);
 
+    /**
+     * Returns number of bytes to add to the buffer size, returned by tiny_fd_buffer_size_by_mtu_ex(),
+     * if compression of I-frames is enabled.
+     *
+     * @param mtu size of desired user payload in bytes.
+     * @param tx_window maximum tx queue size of I-frames.
+     */
+    extern int tiny_fd_compression_buffer_size(int mtu, int tx_window);
+
+    /**
+     * Returns number of bytes to add to the buffer size, returned by tiny_fd_buffer_size_by_mtu_ex(),
+     * if selective reject is enabled.
+     *
+     * @param peers_count maximum number of peers supported by the primary. Use 0 or 1 for secondary devices
+     * @param mtu size of desired user payload in bytes.
+     * @param window maximum number of I-frames in the window.
+     */
+    extern int tiny_fd_srej_buffer_size(uint8_t peers_count, int mtu, int window);
+
     /**
      * @brief returns max packet size in bytes.
      *
@@ -422,6 +600,49 @@ extern "C"
      */
     extern int tiny_fd_get_mtu(tiny_fd_handle_t handle);
 
+    /**
+     * @brief Keeps received frame valid after on_read_cb callback returns.
+     *
+     * Data, passed to on_read_cb callback, point to the protocol RX buffer and are valid only
+     * until the callback returns. Call this function from on_read_cb callback to keep the data
+     * without copying them. The protocol doesn't use the buffer of the loaned frame for incoming
+     * frames until tiny_fd_release_frame() is called. The number of loaned frames is limited by
+     * RX window size minus one. Decompressed frames are not in RX buffer, and can not be loaned.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param data     pointer to the data, passed to on_read_cb callback
+     * @return TINY_SUCCESS if the frame is loaned, or error code
+     *         TINY_ERR_OUT_OF_MEMORY if no free RX buffers remain for receiving new frames
+     *         TINY_ERR_INVALID_DATA if data do not point to RX buffer
+     */
+    extern int tiny_fd_loan_frame(tiny_fd_handle_t handle, const void *data);
+
+    /**
+     * @brief Returns the frame, loaned by tiny_fd_loan_frame(), back to the protocol.
+     *
+     * The function must be called from the thread, which passes RX data to the protocol
+     * (tiny_fd_on_rx_data(), tiny_fd_run_rx()), or the caller must serialize these calls.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param data     pointer to the data, passed to tiny_fd_loan_frame()
+     * @return TINY_SUCCESS if the frame is released, or error code
+     */
+    extern int tiny_fd_release_frame(tiny_fd_handle_t handle, const void *data);
+
+    /**
+     * @brief Sets state of the local receiver.
+     *
+     * If the application cannot process incoming frames, for example, all its receive buffers are
+     * in use, it marks the receiver as not ready. The protocol sends RNR to remote stations, and they
+     * stop sending I-frames instead of sending frames, which would be lost. I-frames, which are already
+     * on the way, are dropped and requested again, when the application marks the receiver as ready.
+     * The function can be called from on_read_cb callback.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param ready    false if the application cannot accept I-frames, true otherwise
+     */
+    extern void tiny_fd_set_rx_ready(tiny_fd_handle_t handle, bool ready);
+
     /**
      * @brief Sends userdata over full-duplex protocol.
      *
@@ -0,0 +1,170 @@
+/*
+    Copyright 2019-2025 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#pragma once
+
+#include "tiny_fd.h"
+#include "tiny_fd_int.h"
+#include "tiny_fd_defines_int.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Control field of I- and S-frames in extended mode is 2 bytes long:
+//   I-frame: N(S) << 1 | 0,  N(R) << 1 | P/F
+//   S-frame: SS << 2 | 01,   N(R) << 1 | P/F
+// U-frames always have 1-byte control field.
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline bool __is_u_frame(uint8_t control)
+{
+    return (control & HDLC_U_FRAME_MASK) == HDLC_U_FRAME_BITS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns size of address and control fields of the frame
+ */
+static inline int __header_len(tiny_fd_handle_t handle, uint8_t control)
+{
+    return (handle->extended && !__is_u_frame(control)) ? 3 : 2;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline uint8_t __frame_ns(tiny_fd_handle_t handle, uint8_t control)
+{
+    return (control >> 1) & handle->seq_bits_mask;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline uint8_t __frame_nr(tiny_fd_handle_t handle, uint8_t control, uint8_t control_ext)
+{
+    return handle->extended ? (control_ext >> 1) : (control >> 5);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline bool __frame_pf(tiny_fd_handle_t handle, uint8_t control, uint8_t control_ext)
+{
+    return (handle->extended && !__is_u_frame(control)) ? (control_ext & HDLC_EXT_P_BIT) : (control & HDLC_P_BIT);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns name of S-frame type for logging
+ */
+static inline const char *__s_frame_type_str(uint8_t control)
+{
+    static const char *const names[] = {"RR", "RNR", "REJ", "SREJ"};
+    return names[(control >> 2) & 0x03];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline tiny_fd_frame_info_t *__header_to_frame(const void *header)
+{
+    return (tiny_fd_frame_info_t *)((uint8_t *)header - offsetof(tiny_fd_frame_info_t, header));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline void __set_frame_ns(tiny_fd_handle_t handle, tiny_fd_frame_info_t *slot, uint8_t ns)
+{
+    slot->header.control = (uint8_t)((slot->header.control & ~(handle->seq_bits_mask << 1)) | (ns << 1));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sets N(R) of I- or S-frame, and clears P/F bit
+ */
+static inline void __set_frame_nr(tiny_fd_handle_t handle, tiny_fd_frame_info_t *slot, uint8_t nr)
+{
+    if ( handle->extended )
+    {
+        slot->control_ext = (uint8_t)(nr << 1);
+    }
+    else
+    {
+        slot->header.control = (uint8_t)((slot->header.control & 0x0F) | (nr << 5));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline void __set_frame_pf(tiny_fd_handle_t handle, tiny_fd_frame_info_t *slot)
+{
+    if ( handle->extended && !__is_u_frame(slot->header.control) )
+    {
+        slot->control_ext |= HDLC_EXT_P_BIT;
+    }
+    else
+    {
+        slot->header.control |= HDLC_P_BIT;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns segments of the frame to pass to hdlc level: address and control fields, second byte of
+ * extended control field, and information field
+ */
+static inline int __frame_to_segments(tiny_fd_handle_t handle, tiny_fd_frame_info_t *slot, hdlc_ll_segment_t *segments)
+{
+    int count = 0;
+    segments[count].data = (const uint8_t *)&slot->header;
+    segments[count++].len = sizeof(tiny_frame_header_t);
+    if ( __header_len(handle, slot->header.control) > (int)sizeof(tiny_frame_header_t) )
+    {
+        segments[count].data = &slot->control_ext;
+        segments[count++].len = 1;
+    }
+    segments[count].data = slot->payload;
+    segments[count++].len = slot->len;
+    return count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns control field of the command, which establishes connection in the mode of the link
+ */
+static inline uint8_t __mode_setting_command(tiny_fd_handle_t handle)
+{
+    if ( handle->mode == TINY_FD_MODE_NRM )
+    {
+        return (handle->extended ? HDLC_U_FRAME_TYPE_SNRME : HDLC_U_FRAME_TYPE_SNRM) | HDLC_U_FRAME_BITS;
+    }
+    return (handle->extended ? HDLC_U_FRAME_TYPE_SABME : HDLC_U_FRAME_TYPE_SABM) | HDLC_U_FRAME_BITS;
+}
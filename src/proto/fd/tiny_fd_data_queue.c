@@ -32,32 +32,126 @@
 #include "tiny_fd_int.h"
 #include "tiny_fd_defines_int.h"
 #include "tiny_fd_peers_int.h"
+#include "tiny_fd_control_int.h"
+#include "proto/lz/tiny_lz.h"
+
+#include <string.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 
 bool __can_accept_i_frames(tiny_fd_handle_t handle, uint8_t peer)
 {
-    uint8_t next_last_ns = (handle->peers[peer].last_ns + 1) & seq_bits_mask;
-    bool can_accept = next_last_ns != handle->peers[peer].confirm_ns;
+    // Reserved frames get N(S) values later, when they are committed
+    int queued = ((handle->peers[peer].last_ns - handle->peers[peer].confirm_ns) & handle->seq_bits_mask) +
+                 handle->peers[peer].reserved;
+    bool can_accept = queued < handle->seq_bits_mask;
+    if ( handle->peers[peer].srej )
+    {
+        // Receiver cannot distinguish resent frames from new ones, if more than half of N(S) values are used
+        can_accept = queued < (handle->seq_bits_mask + 1) / 2;
+    }
     return can_accept;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-bool __put_i_frame_to_tx_queue(tiny_fd_handle_t handle, uint8_t peer, const void *data, int len)
+/**
+ * Puts compression flag and user payload to I-frame slot. Compressed payload is used only if it is shorter.
+ */
+static void __compress_i_frame(tiny_fd_handle_t handle, tiny_fd_frame_info_t *slot, const void *data, int len)
+{
+    // Short frames are not compressed at all
+    int size = len >= TINY_LZ_MIN_LENGTH
+                   ? tiny_lz_compress((const uint8_t *)data, len, &slot->payload[1], len - 1, handle->lz_table)
+                   : 0;
+    if ( size > 0 )
+    {
+        slot->payload[0] = TINY_FD_I_FRAME_LZ;
+        slot->len = size + 1;
+    }
+    else
+    {
+        slot->payload[0] = TINY_FD_I_FRAME_RAW;
+        memcpy(&slot->payload[1], data, len);
+    }
+    LOG(TINY_LOG_DEB, "[%p] QUEUE I-PUT: payload %i bytes, frame %i bytes\n", handle, len, slot->len);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int __decompress_i_frame(tiny_fd_handle_t handle, uint8_t **payload, int len)
+{
+    if ( len < 1 )
+    {
+        return TINY_ERR_INVALID_DATA;
+    }
+    uint8_t flag = (*payload)[0];
+    (*payload)++;
+    len--;
+    if ( flag == TINY_FD_I_FRAME_RAW )
+    {
+        return len;
+    }
+    if ( flag != TINY_FD_I_FRAME_LZ )
+    {
+        return TINY_ERR_INVALID_DATA;
+    }
+    len = tiny_lz_decompress(*payload, len, handle->lz_buf, tiny_fd_get_mtu(handle));
+    *payload = handle->lz_buf;
+    return len;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool __put_i_frame_to_tx_queue(tiny_fd_handle_t handle, uint8_t peer, const void *data, int len, bool urgent)
 {
-    tiny_fd_frame_info_t *slot = tiny_fd_queue_allocate( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, (const uint8_t *)data, len );
+    tiny_fd_frame_info_t *slot;
+    if ( handle->peers[peer].compression )
+    {
+        slot = tiny_fd_queue_allocate( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, NULL, len + 1 );
+        if ( slot != NULL )
+        {
+            __compress_i_frame(handle, slot, data, len);
+        }
+    }
+    else
+    {
+        slot = tiny_fd_queue_allocate( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, (const uint8_t *)data, len );
+    }
     // Check if space is actually available
     if ( slot != NULL )
     {
-        LOG(TINY_LOG_DEB, "[%p] QUEUE I-PUT: [%02X] [%02X]\n", handle, slot->header.address, slot->header.control);
-        slot->header.address = __peer_to_address_field( handle, peer );
-        slot->header.control = handle->peers[peer].last_ns << 1;
-        handle->peers[peer].last_ns = (handle->peers[peer].last_ns + 1) & seq_bits_mask;
-        tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
+        __queue_i_frame(handle, peer, slot, urgent);
         return true;
     }
     return false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
+
+void __queue_i_frame(tiny_fd_handle_t handle, uint8_t peer, tiny_fd_frame_info_t *slot, bool urgent)
+{
+    slot->header.address = __peer_to_address_field( handle, peer );
+    slot->header.control = handle->peers[peer].last_ns << 1;
+    LOG(TINY_LOG_DEB, "[%p] QUEUE I-PUT: [%02X] [%02X]\n", handle, slot->header.address, slot->header.control);
+    tiny_fd_queue_set_i_frame( &handle->frames.i_queue, peer, handle->peers[peer].last_ns, slot );
+    if ( urgent )
+    {
+        // Move the frame back step by step, so N(S) of every queued frame remains unique
+        uint8_t first = (handle->peers[peer].unsent_ns + handle->peers[peer].urgent_count) & handle->seq_bits_mask;
+        for ( uint8_t ns = handle->peers[peer].last_ns; ns != first; )
+        {
+            ns = (ns - 1) & handle->seq_bits_mask;
+            tiny_fd_frame_info_t *prev = tiny_fd_queue_get_i_frame( &handle->frames.i_queue, peer, ns );
+            __set_frame_ns(handle, prev, (ns + 1) & handle->seq_bits_mask);
+            tiny_fd_queue_set_i_frame( &handle->frames.i_queue, peer, (ns + 1) & handle->seq_bits_mask, prev );
+            __set_frame_ns(handle, slot, ns);
+            tiny_fd_queue_set_i_frame( &handle->frames.i_queue, peer, ns, slot );
+        }
+        handle->peers[peer].urgent_count++;
+    }
+    handle->peers[peer].last_ns = (handle->peers[peer].last_ns + 1) & handle->seq_bits_mask;
+    tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -49,6 +49,14 @@ static inline bool __all_frames_are_sent(tiny_fd_handle_t handle, uint8_t peer)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static inline bool __is_sent_unconfirmed_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t ns)
+{
+    return ((uint8_t)(ns - handle->peers[peer].confirm_ns) & handle->seq_bits_mask) <
+           ((uint8_t)(handle->peers[peer].next_ns - handle->peers[peer].confirm_ns) & handle->seq_bits_mask);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static inline uint32_t __time_passed_since_last_sent_i_frame(tiny_fd_handle_t handle, uint8_t peer)
 {
     return (uint32_t)(tiny_millis() - handle->peers[peer].last_sent_i_ts);
@@ -60,6 +68,26 @@ bool __can_accept_i_frames(tiny_fd_handle_t handle, uint8_t peer);
 
 ///////////////////////////////////////////////////////////////////////////////
 
-bool __put_i_frame_to_tx_queue(tiny_fd_handle_t handle, uint8_t peer, const void *data, int len);
+/**
+ * Puts I-frame to tx queue. Urgent frame is put before all frames, which were never sent,
+ * except other urgent frames. Such frames are not known to the remote side yet, so they
+ * are just renumbered.
+ */
+bool __put_i_frame_to_tx_queue(tiny_fd_handle_t handle, uint8_t peer, const void *data, int len, bool urgent);
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Assigns N(S) to I-frame slot, allocated in the queue, and makes it available for sending.
+ */
+void __queue_i_frame(tiny_fd_handle_t handle, uint8_t peer, tiny_fd_frame_info_t *slot, bool urgent);
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Removes compression flag from I-frame payload, and decompresses the payload to lz_buf if needed.
+ * Returns size of user payload, or error code if the payload is broken. Used in rx context only.
+ */
+int __decompress_i_frame(tiny_fd_handle_t handle, uint8_t **payload, int len);
 
 ///////////////////////////////////////////////////////////////////////////////
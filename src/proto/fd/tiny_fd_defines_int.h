@@ -89,6 +89,8 @@ enum
 #define HDLC_S_FRAME_MASK 0x03
 #define HDLC_S_FRAME_TYPE_REJ 0x08
 #define HDLC_S_FRAME_TYPE_RR 0x00
+#define HDLC_S_FRAME_TYPE_RNR 0x04
+#define HDLC_S_FRAME_TYPE_SREJ 0x0C
 #define HDLC_S_FRAME_TYPE_MASK 0x0C
 
 #define HDLC_U_FRAME_BITS 0x03
@@ -99,11 +101,15 @@ enum
 #define HDLC_U_FRAME_TYPE_RSET 0x8C
 #define HDLC_U_FRAME_TYPE_SABM 0x2C
 #define HDLC_U_FRAME_TYPE_SNRM 0x80
+#define HDLC_U_FRAME_TYPE_SABME 0x6C
+#define HDLC_U_FRAME_TYPE_SNRME 0xCC
 #define HDLC_U_FRAME_TYPE_DISC 0x40
 #define HDLC_U_FRAME_TYPE_MASK 0xEC
 
 #define HDLC_P_BIT 0x10
 #define HDLC_F_BIT 0x10
+// P/F bit in the second byte of extended control field
+#define HDLC_EXT_P_BIT 0x01
 
 // C/R bit is command / response bit 
 // When this bit is set, it means that the frame is a command frame
@@ -116,4 +122,25 @@ enum
 #define HDLC_PRIMARY_ADDR (TINY_FD_PRIMARY_ADDR << 2)
 #define HDLC_INVALID_PEER_INDEX 0xFF
 
-static const uint8_t seq_bits_mask = 0x07;
\ No newline at end of file
+// Capabilities bits, sent in information field of SABM, SNRM and UA frames.
+// Stations, which do not support capabilities, ignore information field of these frames.
+#define TINY_FD_CAP_ACCM 0x01
+#define TINY_FD_CAP_LZ 0x02
+#define TINY_FD_CAP_SREJ 0x04
+
+// Local station advertises async control character map only if hdlc level supports it
+#ifdef CONFIG_ENABLE_ACCM
+#define TINY_FD_LOCAL_CAP_ACCM TINY_FD_CAP_ACCM
+#else
+#define TINY_FD_LOCAL_CAP_ACCM 0
+#endif
+
+// First byte of I-frame information field, if compression is negotiated for the link
+#define TINY_FD_I_FRAME_RAW 0x00
+#define TINY_FD_I_FRAME_LZ 0x01
+
+// Sequence numbers are modulo 8 in basic mode, and modulo 128 in extended mode
+#define TINY_FD_SEQ_BITS_MASK 0x07
+#define TINY_FD_EXT_SEQ_BITS_MASK 0x7F
+// Address field and 2-byte control field of extended mode
+#define TINY_FD_MAX_HEADER_SIZE 3
\ No newline at end of file
@@ -56,6 +56,9 @@ extern "C"
     typedef struct
     {
         uint8_t type; ///< tiny_fd_queue_type_t value
+        uint8_t control_ext; ///< second byte of control field of I- and S-frames in extended mode
+        uint8_t next; ///< next slot in the list of free slots or in S- and U- frames FIFO
+        uint8_t ring; ///< N(S) ring of I-frame in the queue index
         int len;      ///< payload of the frame
         /* Aligning header to 1 byte, since header and user_payload together are the byte-stream */
         TINY_ALIGNED(1) tiny_frame_header_t header; ///< header, fill every time, when user payload is sending
@@ -30,6 +30,7 @@
 #include "hal/tiny_debug.h"
 
 #include <string.h>
+#include <stddef.h>
 
 #ifndef TINY_FD_DEBUG
 #define TINY_FD_DEBUG 0
@@ -43,29 +44,54 @@
 #endif
 #endif
 
+static inline tiny_fd_frame_info_t *__queue_slot(tiny_fd_queue_t *queue, uint8_t number)
+{
+    return (tiny_fd_frame_info_t *)(queue->slots + number * queue->slot_size);
+}
+
+static inline uint8_t __queue_slot_number(tiny_fd_queue_t *queue, const tiny_fd_frame_info_t *frame)
+{
+    return (uint8_t)(((const uint8_t *)frame - queue->slots) / queue->slot_size);
+}
+
+static inline uint8_t *__queue_index(tiny_fd_queue_t *queue, uint8_t ring, uint8_t ns)
+{
+    return queue->slots + queue->size * queue->slot_size + ring * (queue->ring_mask + 1) + (ns & queue->ring_mask);
+}
+
+int tiny_fd_queue_get_ring_size(int max_frames)
+{
+    int ring_size = 1;
+    while ( ring_size < max_frames )
+    {
+        ring_size <<= 1;
+    }
+    return ring_size;
+}
+
 int tiny_fd_queue_init(tiny_fd_queue_t *queue, uint8_t *buffer,
-                       int max_size, int max_frames, int mtu)
+                       int max_size, int max_frames, int mtu, uint8_t rings)
 {
-    uint8_t *ptr = buffer;
-    queue->frames = (tiny_fd_frame_info_t **)(ptr);
-    ptr += sizeof(tiny_fd_frame_info_t *) * max_frames;
-    /* At this point we still have correct alignment in the buffer if init->window_frames is even.
-     * pointer is 4 bytes on ARM 32-bit, and if window_frames is even, that gives us multiply of 8.
-     */
-    queue->size = max_frames;
-    /* Lets allocate memory for TX frames, we have <window_frames> TX frames */
-    for ( int i = 0; i < queue->size; i++ )
+    if ( max_frames >= TINY_FD_QUEUE_NONE )
     {
-        queue->frames[i] = (tiny_fd_frame_info_t *)ptr;
-        /* mtu must be correctly aligned also, so the developer must use only mtu multiple of 8 on 32-bit ARM systems */
-        ptr += mtu + sizeof(tiny_fd_frame_info_t) - sizeof(((tiny_fd_frame_info_t *)0)->payload);
+        LOG(TINY_LOG_CRIT, "Queue cannot hold %i frames\n", max_frames);
+        return TINY_ERR_INVALID_DATA;
     }
+    /* Frame slots are located at the beginning of the buffer to keep alignment.
+     * mtu must be correctly aligned also, so the developer must use only mtu multiple of 8 on 32-bit ARM systems */
+    queue->slots = buffer;
+    queue->slot_size = mtu + sizeof(tiny_fd_frame_info_t) - sizeof(((tiny_fd_frame_info_t *)0)->payload);
+    queue->size = max_frames;
+    queue->rings = rings;
+    queue->ring_mask = (uint8_t)(tiny_fd_queue_get_ring_size(max_frames) - 1);
+    uint8_t *ptr = __queue_index(queue, rings, 0);
     if ( ptr > buffer + max_size )
     {
         LOG(TINY_LOG_CRIT, "Queue out of provided memory: provided %i bytes, used %i bytes\n", max_size, (int)(ptr - buffer));
         return TINY_ERR_INVALID_DATA;
     }
     queue->mtu = mtu;
+    queue->ns_mask = 0x07;
     tiny_fd_queue_reset( queue );
     return (int)(ptr - buffer);
 }
@@ -74,94 +100,151 @@ void tiny_fd_queue_reset(tiny_fd_queue_t *queue)
 {
     for (int i=0; i < queue->size; i++)
     {
-        queue->frames[i]->type = TINY_FD_QUEUE_FREE;
+        tiny_fd_frame_info_t *frame = __queue_slot(queue, (uint8_t)i);
+        frame->type = TINY_FD_QUEUE_FREE;
+        frame->next = (i + 1 < queue->size) ? (uint8_t)(i + 1) : TINY_FD_QUEUE_NONE;
     }
-    queue->lookup_index = 0;
+    queue->free_head = queue->size ? 0 : TINY_FD_QUEUE_NONE;
+    queue->fifo_head = TINY_FD_QUEUE_NONE;
+    queue->fifo_tail = TINY_FD_QUEUE_NONE;
+    memset(__queue_index(queue, 0, 0), TINY_FD_QUEUE_NONE, queue->rings * (queue->ring_mask + 1));
 }
 
-void tiny_fd_queue_reset_for(tiny_fd_queue_t *queue, uint8_t address)
+void tiny_fd_queue_reset_for(tiny_fd_queue_t *queue, uint8_t ring)
 {
-    for (int i=0; i < queue->size; i++)
+    for (int ns=0; ns <= queue->ring_mask; ns++)
     {
-        if ( ( queue->frames[i]->header.address & 0xFC ) == (address & 0xFC) )
+        uint8_t number = *__queue_index(queue, ring, (uint8_t)ns);
+        if ( number != TINY_FD_QUEUE_NONE )
         {
-            queue->frames[i]->type = TINY_FD_QUEUE_FREE;
+            tiny_fd_queue_free(queue, __queue_slot(queue, number));
         }
     }
 }
 
 tiny_fd_frame_info_t *tiny_fd_queue_allocate(tiny_fd_queue_t *queue, uint8_t type, const uint8_t *data, int len)
 {
-    tiny_fd_frame_info_t *ptr = len <= queue->mtu ?  tiny_fd_queue_get_next(queue, TINY_FD_QUEUE_FREE, 0, 0) : NULL;
-    if ( ptr != NULL )
+    if ( len > queue->mtu || queue->free_head == TINY_FD_QUEUE_NONE )
+    {
+        return NULL;
+    }
+    uint8_t number = queue->free_head;
+    tiny_fd_frame_info_t *ptr = __queue_slot(queue, number);
+    queue->free_head = ptr->next;
+    if ( data != NULL )
     {
         memcpy( &ptr->payload[0], data, len );
-        ptr->len = len;
-        ptr->type = type;
+    }
+    ptr->len = len;
+    ptr->type = type;
+    ptr->next = TINY_FD_QUEUE_NONE;
+    ptr->ring = TINY_FD_QUEUE_NONE;
+    if ( type != TINY_FD_QUEUE_I_FRAME )
+    {
+        if ( queue->fifo_tail == TINY_FD_QUEUE_NONE )
+        {
+            queue->fifo_head = number;
+        }
+        else
+        {
+            __queue_slot(queue, queue->fifo_tail)->next = number;
+        }
+        queue->fifo_tail = number;
     }
     return ptr;
 }
 
-tiny_fd_frame_info_t *tiny_fd_queue_get_next(tiny_fd_queue_t *queue, uint8_t type, uint8_t address, uint8_t arg)
+tiny_fd_frame_info_t *tiny_fd_queue_get_next(tiny_fd_queue_t *queue, uint8_t type, uint8_t address)
 {
-    tiny_fd_frame_info_t *ptr = NULL;
-    int index = queue->lookup_index;
-    for (int i=0; i < queue->size; i++)
+    // Usually the first frame in FIFO is the one, only primary station with several peers looks further
+    for ( uint8_t number = queue->fifo_head; number != TINY_FD_QUEUE_NONE; )
     {
-        // fprintf(stderr, "REC: type %02X address %02X, looking for type %02X addr %02X\n", queue->frames[index]->type, queue->frames[index]->header.address, type, address);
-        if ( queue->frames[index]->type & type )
-        {
-            if ( queue->frames[index]->type == TINY_FD_QUEUE_FREE )
-            {
-                ptr = queue->frames[index];
-                break;
-            }
-            // Check address for all frames
-            if ( (address & 0xFC) == (queue->frames[index]->header.address & 0xFC) )
-            {
-                // fprintf(stderr, "REC FOUND: type %02X address %02X, looking for type %02X addr %02X\n", queue->frames[index]->type, queue->frames[index]->header.address, type, address);
-                if ( queue->frames[index]->type != TINY_FD_QUEUE_I_FRAME )
-                {
-                    ptr = queue->frames[index];
-                    break;
-                }
-                // Check for I-frame for the frame number
-                if ( ( ( queue->frames[index]->header.control >> 1 ) & 0x07 )  == arg )
-                {
-                    ptr = queue->frames[index];
-                    break;
-                }
-            }
-        }
-        index++;
-        if ( index >= queue->size )
+        tiny_fd_frame_info_t *ptr = __queue_slot(queue, number);
+        if ( (ptr->type & type) && (address & 0xFC) == (ptr->header.address & 0xFC) )
         {
-            index -= queue->size;
+            return ptr;
         }
+        number = ptr->next;
     }
-    return ptr;
+    return NULL;
 }
 
-void tiny_fd_queue_free(tiny_fd_queue_t *queue, tiny_fd_frame_info_t *frame)
+void tiny_fd_queue_set_i_frame(tiny_fd_queue_t *queue, uint8_t ring, uint8_t ns, tiny_fd_frame_info_t *frame)
 {
-    tiny_fd_queue_free_by_header(queue, &frame->header);
+    frame->ring = ring;
+    *__queue_index(queue, ring, ns) = __queue_slot_number(queue, frame);
 }
 
-void tiny_fd_queue_free_by_header(tiny_fd_queue_t *queue, const void *header)
+tiny_fd_frame_info_t *tiny_fd_queue_get_i_frame(tiny_fd_queue_t *queue, uint8_t ring, uint8_t ns)
 {
-    for (int i=0; i < queue->size; i++)
+    uint8_t number = *__queue_index(queue, ring, ns);
+    if ( number == TINY_FD_QUEUE_NONE )
+    {
+        return NULL;
+    }
+    tiny_fd_frame_info_t *ptr = __queue_slot(queue, number);
+    // Ring entry can be left by the frame, which got another N(S), or the slot is reused by another peer
+    if ( ptr->type != TINY_FD_QUEUE_I_FRAME || ptr->ring != ring ||
+         ( ( ptr->header.control >> 1 ) & queue->ns_mask ) != ns )
+    {
+        return NULL;
+    }
+    return ptr;
+}
+
+void tiny_fd_queue_free(tiny_fd_queue_t *queue, tiny_fd_frame_info_t *frame)
+{
+    if ( frame->type == TINY_FD_QUEUE_FREE )
+    {
+        return;
+    }
+    uint8_t number = __queue_slot_number(queue, frame);
+    if ( frame->type == TINY_FD_QUEUE_I_FRAME )
     {
-        if ( &queue->frames[i]->header == header )
+        if ( frame->ring != TINY_FD_QUEUE_NONE )
         {
-            queue->frames[i]->type = TINY_FD_QUEUE_FREE;
-            queue->lookup_index = i + 1;
-            if ( queue->lookup_index >= queue->size )
+            uint8_t *entry = __queue_index(queue, frame->ring, ( frame->header.control >> 1 ) & queue->ns_mask);
+            if ( *entry == number )
             {
-                queue->lookup_index -= queue->size;
+                *entry = TINY_FD_QUEUE_NONE;
             }
-            break;
         }
     }
+    else
+    {
+        // S- and U- frames are freed, when they are sent, so the frame is usually the first one
+        uint8_t prev = TINY_FD_QUEUE_NONE;
+        for ( uint8_t i = queue->fifo_head; i != number && i != TINY_FD_QUEUE_NONE; i = __queue_slot(queue, i)->next )
+        {
+            prev = i;
+        }
+        if ( prev == TINY_FD_QUEUE_NONE )
+        {
+            queue->fifo_head = frame->next;
+        }
+        else
+        {
+            __queue_slot(queue, prev)->next = frame->next;
+        }
+        if ( queue->fifo_tail == number )
+        {
+            queue->fifo_tail = prev;
+        }
+    }
+    frame->type = TINY_FD_QUEUE_FREE;
+    frame->next = queue->free_head;
+    queue->free_head = number;
+}
+
+void tiny_fd_queue_free_by_header(tiny_fd_queue_t *queue, const void *header)
+{
+    const uint8_t *ptr = (const uint8_t *)header - offsetof(tiny_fd_frame_info_t, header);
+    if ( ptr < queue->slots || ptr >= queue->slots + queue->size * queue->slot_size ||
+         (ptr - queue->slots) % queue->slot_size )
+    {
+        return;
+    }
+    tiny_fd_queue_free(queue, (tiny_fd_frame_info_t *)ptr);
 }
 
 int tiny_fd_queue_get_mtu(tiny_fd_queue_t *queue)
@@ -171,5 +254,5 @@ int tiny_fd_queue_get_mtu(tiny_fd_queue_t *queue)
 
 bool tiny_fd_queue_has_free_slots(tiny_fd_queue_t *queue)
 {
-    return tiny_fd_queue_get_next(queue, TINY_FD_QUEUE_FREE, 0, 0) != NULL;
+    return queue->free_head != TINY_FD_QUEUE_NONE;
 }
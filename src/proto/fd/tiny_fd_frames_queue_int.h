@@ -40,14 +40,33 @@ extern "C"
 #include <stdint.h>
 #include <stdbool.h>
 
+/// Slot number, which means that there is no slot
+#define TINY_FD_QUEUE_NONE 0xFF
+
+    /**
+     * Frames queue. Free slots are linked to the list, S- and U- frames are linked to FIFO
+     * in order of allocation. I-frames are found via index, which has a ring of slot numbers
+     * for each peer, indexed by N(S). Ring size is power of 2, not less than number of slots,
+     * so N(S) values of unconfirmed frames never share ring entry.
+     */
     typedef struct
     {
-        tiny_fd_frame_info_t **frames;  ///< pointer to the frame table
-        int size;                       ///< number of elements in the table
-        int lookup_index;               ///< First index to start search from
+        uint8_t *slots;                 ///< frame slots, followed by the index
+        int slot_size;                  ///< size of single slot in bytes
+        int size;                       ///< number of slots
         int mtu;                        ///< Maximum supported payload size
+        uint8_t rings;                  ///< number of N(S) rings in the index
+        uint8_t ring_mask;              ///< ring size - 1
+        uint8_t free_head;              ///< first free slot
+        uint8_t fifo_head;              ///< first S- or U- frame
+        uint8_t fifo_tail;              ///< last S- or U- frame
+        uint8_t ns_mask;                ///< Mask of N(S) field of I-frames, 0x07 by default
     } tiny_fd_queue_t;
 
+    /**
+     * Returns size of N(S) ring in the queue index for specified number of slots.
+     */
+    int tiny_fd_queue_get_ring_size(int max_frames);
 
     /**
      * Initializes the queue, and returns number of bytes allocated in the provided buffer
@@ -56,11 +75,12 @@ extern "C"
      * @param queue pointer to queue structure
      * @param buffer buffer to store queue data
      * @param max_size maximum size of the provided buffer
-     * @param max_frames maximum number of frames to store
+     * @param max_frames maximum number of frames to store, up to 254
      * @param mtu maximum size of user payload
+     * @param rings number of N(S) rings for I-frames, 0 if the queue stores only S- and U- frames
      */
     int tiny_fd_queue_init(tiny_fd_queue_t *queue, uint8_t *buffer,
-                           int max_size, int max_frames, int mtu);
+                           int max_size, int max_frames, int mtu, uint8_t rings);
 
     /**
      * Resets the queue to its default state, flushes all stored frames
@@ -68,9 +88,9 @@ extern "C"
     void tiny_fd_queue_reset(tiny_fd_queue_t *queue);
 
     /**
-     * Reset the queue only for specific address
+     * Frees all I-frames of specified N(S) ring
      */
-    void tiny_fd_queue_reset_for(tiny_fd_queue_t *queue, uint8_t address);
+    void tiny_fd_queue_reset_for(tiny_fd_queue_t *queue, uint8_t ring);
 
     /**
      * Returns true if the queue has free slots
@@ -84,20 +104,39 @@ extern "C"
 
     /**
      * Allocates free slot in the queue and copies user data to the queue.
+     * If data is NULL, the caller fills the payload of len bytes.
+     * S- and U- frames are added to the end of FIFO, I-frame must be added to the index by the caller.
      * If there are no space returns NULL, otherwise returns pointer to allocated frame info structure.
      */
     tiny_fd_frame_info_t *tiny_fd_queue_allocate(tiny_fd_queue_t *queue, uint8_t type, const uint8_t *data, int len);
 
     /**
-     * Returns pointer to the next element with speciifed type and arg or NULL.
+     * Returns pointer to the first S- or U- frame in FIFO with specified type and address or NULL.
      *
      * @param queue pointer to queue structure
      * @param type type of the record to search for: tiny_fd_queue_type_t
-     * @param arg arg used as the address field only for I-frame and must contain frame number to search for.
+     * @param address address field of the frame
+     */
+    tiny_fd_frame_info_t *tiny_fd_queue_get_next(tiny_fd_queue_t *queue, uint8_t type, uint8_t address);
+
+    /**
+     * Puts I-frame to the index. N(S) of the frame must be updated by the caller.
      *
-     * @important Remember that S-Frames and U-Frames can be reordered by the queue.
+     * @param queue pointer to queue structure
+     * @param ring N(S) ring, usually peer index
+     * @param ns N(S) of the frame
+     * @param frame pointer to the frame information
+     */
+    void tiny_fd_queue_set_i_frame(tiny_fd_queue_t *queue, uint8_t ring, uint8_t ns, tiny_fd_frame_info_t *frame);
+
+    /**
+     * Returns pointer to I-frame with specified N(S) or NULL.
+     *
+     * @param queue pointer to queue structure
+     * @param ring N(S) ring, usually peer index
+     * @param ns N(S) of the frame
      */
-    tiny_fd_frame_info_t *tiny_fd_queue_get_next(tiny_fd_queue_t *queue, uint8_t type, uint8_t address, uint8_t arg);
+    tiny_fd_frame_info_t *tiny_fd_queue_get_i_frame(tiny_fd_queue_t *queue, uint8_t ring, uint8_t ns);
 
     /**
      * Marks frame slot as free
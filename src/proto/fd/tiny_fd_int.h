@@ -32,6 +32,17 @@
 
 #define TINY_FD_U_QUEUE_MAX_SIZE 4
 
+/// Maximum size of information field in S- and U- frames: capabilities byte and 32-bit accm,
+/// rounded up to keep service queue slots aligned
+#define TINY_FD_U_FRAME_MAX_INFO 6
+
+/// Size of S- or U- frame slot in the service queue
+#define TINY_FD_U_FRAME_SLOT_SIZE                                                                                      \
+    ( sizeof(tiny_fd_frame_info_t) - sizeof(((tiny_fd_frame_info_t *)0)->payload) + TINY_FD_U_FRAME_MAX_INFO )
+
+/// Upper estimate of N(S) index size of I-frames queue for the peer: ring size is power of 2, less than 2 * window
+#define TINY_FD_I_QUEUE_INDEX_SIZE(window) ( 2 * (window) )
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -47,19 +58,19 @@ extern "C"
 
 #define FD_MIN_BUF_SIZE(mtu, window)                                                                                   \
     (sizeof(tiny_fd_data_t) + TINY_ALIGN_STRUCT_VALUE - 1 + \
-     HDLC_MIN_BUF_SIZE(mtu + sizeof(tiny_frame_header_t), HDLC_CRC_16) +                     \
+     HDLC_MIN_BUF_SIZE(mtu + sizeof(tiny_frame_header_t) + 1, HDLC_CRC_16) +                 \
       ( 1 * FD_PEER_BUF_SIZE() ) + \
-      (sizeof(tiny_fd_frame_info_t *) + sizeof(tiny_fd_frame_info_t) + mtu \
+      (sizeof(tiny_fd_frame_info_t) + mtu \
                                       - sizeof(((tiny_fd_frame_info_t *)0)->payload) ) * window + \
-          ( sizeof(tiny_fd_frame_info_t) + sizeof(tiny_fd_frame_info_t *) ) * TINY_FD_U_QUEUE_MAX_SIZE )
+          TINY_FD_I_QUEUE_INDEX_SIZE(window) + TINY_FD_U_FRAME_SLOT_SIZE * TINY_FD_U_QUEUE_MAX_SIZE )
 
 #define FD_BUF_SIZE_EX(mtu, tx_window, crc, rx_window)                                                                      \
     (sizeof(tiny_fd_data_t) + TINY_ALIGN_STRUCT_VALUE - 1 + \
-     HDLC_BUF_SIZE_EX(mtu + sizeof(tiny_frame_header_t), crc, rx_window) +           \
+     HDLC_BUF_SIZE_EX(mtu + sizeof(tiny_frame_header_t) + 1, crc, rx_window) +       \
       ( 1 * FD_PEER_BUF_SIZE() ) + \
-      (sizeof(tiny_fd_frame_info_t *) + sizeof(tiny_i_frame_info_t) + mtu \
+      (sizeof(tiny_i_frame_info_t) + mtu \
                                       - sizeof(((tiny_fd_frame_info_t *)0)->payload)) * tx_window + \
-       ( sizeof(tiny_fd_frame_info_t) + sizeof(tiny_fd_frame_info_t *) ) * TINY_FD_U_QUEUE_MAX_SIZE)
+       TINY_FD_I_QUEUE_INDEX_SIZE(tx_window) + TINY_FD_U_FRAME_SLOT_SIZE * TINY_FD_U_QUEUE_MAX_SIZE)
 
     typedef enum
     {
@@ -75,8 +86,26 @@ extern "C"
         tiny_frame_header_t header;
         uint8_t data1;
         uint8_t data2;
+        uint8_t data3;
     } tiny_fd_u_frame_t;
 
+    /// SABM, SNRM or UA frame with capabilities of the station in information field
+    typedef struct
+    {
+        tiny_frame_header_t header;
+        uint8_t caps;     // TINY_FD_CAP_xxx bits
+        uint8_t accm[4];  // async control character map, LSB first
+    } tiny_fd_u_caps_frame_t;
+
+    /// Out-of-order I-frame, kept in the receive buffer until missing frames arrive
+    typedef struct
+    {
+        int len;         // length of I-frame information field
+        uint8_t ns;      // N(S) of the frame
+        uint8_t used;    // Non-zero if the slot holds the frame
+        uint8_t payload[2]; // this byte and all bytes after are information field
+    } tiny_fd_rx_slot_t;
+
     typedef struct
     {
         /// state of hdlc protocol according to ISO & RFC
@@ -89,12 +118,21 @@ extern "C"
         uint8_t next_ns;     // next frame to be sent
         uint8_t confirm_ns;  // next frame to be confirmed
         uint8_t last_ns;     // next free frame in cycle buffer
+        uint8_t unsent_ns;   // first frame, which was never sent
+        uint8_t urgent_count; // urgent frames, which are queued from unsent_ns
+        uint8_t srej_ns;     // frame to resend, requested by SREJ
+        uint8_t srej_pending; // Non-zero if srej_ns frame must be resent
+        uint8_t reserved;    // I-frame slots, reserved by the application, but not queued yet
 
         uint32_t last_sent_i_ts;           // last sent I-frame timestamp
         uint32_t last_sent_frame_ts;       // last sent keep alive timestamp
         uint32_t last_received_frame_ts;   // last keep alive timestamp
         uint8_t ka_confirmed;
         uint8_t retries;     // Number of retries to perform before timeout takes place
+        uint8_t compression; // Non-zero if I-frames of the link carry compression flag
+        uint8_t srej;        // Non-zero if selective reject is negotiated for the link
+        uint8_t local_busy;  // Non-zero if the application cannot accept I-frames, 2 if I-frames were dropped
+        uint8_t remote_busy; // Non-zero if RNR is received from the remote station
 
         tiny_events_t events;
 
@@ -145,6 +183,34 @@ extern "C"
         uint32_t last_marker_ts;
         /// HDLC mode;
         uint8_t mode;
+        /// Non-zero if extended mode (modulo-128 sequence numbers) is used
+        uint8_t extended;
+        /// TINY_FD_SEQ_BITS_MASK or TINY_FD_EXT_SEQ_BITS_MASK
+        uint8_t seq_bits_mask;
+        /// Async control character map, requested by local station
+        uint32_t accm;
+        /// Async control character map, requested by remote stations
+        uint32_t peer_accm;
+        /// Non-zero if remote station sent its capabilities on connection
+        uint8_t accm_negotiated;
+        /// Non-zero if remote station is known to escape negotiated map
+        uint8_t accm_confirmed;
+        /// Non-zero if compression of I-frames is enabled by local station
+        uint8_t compression;
+        /// Match table for the compressor
+        uint16_t *lz_table;
+        /// Buffer for decompressed I-frames, mtu bytes
+        uint8_t *lz_buf;
+        /// Non-zero if hdlc level sends I-frame for the first time
+        uint8_t tx_new_i_frame;
+        /// Non-zero if hdlc level sends urgent I-frame, followed by preempted one
+        uint8_t preempted;
+        /// Non-zero if selective reject is enabled by local station
+        uint8_t srej;
+        /// Number of receive buffer slots for out-of-order I-frames per peer
+        uint8_t rx_slots;
+        /// Size of single receive buffer slot, aligned. The slots follow information on peers.
+        uint16_t rx_slot_size;
         /// Global events for HDLC protocol
         tiny_events_t events;
         /// user specific data
@@ -157,6 +223,9 @@ extern "C"
                        const uint8_t *data,
                        int len);
 
+    /// Logs outgoing frame, stored in the queue
+    extern void __tiny_fd_log_out_frame(tiny_fd_handle_t handle, const tiny_fd_frame_info_t *frame);
+
 #ifdef __cplusplus
 }
 #endif
@@ -35,14 +35,111 @@
 #include "tiny_fd_defines_int.h"
 #include "tiny_fd_peers_int.h"
 #include "tiny_fd_service_queue_int.h"
+#include "tiny_fd_control_int.h"
 #include <stdint.h>
+#include <string.h>
 
 static void __switch_to_connected_state(tiny_fd_handle_t handle, uint8_t peer);
 static void __switch_to_disconnected_state(tiny_fd_handle_t handle, uint8_t peer);
+static tiny_fd_frame_info_t *__put_u_frame_with_caps(tiny_fd_handle_t handle, int type, uint8_t address,
+                                                     uint8_t control, bool caps);
+static bool __on_peer_caps(tiny_fd_handle_t handle, uint8_t peer, const uint8_t *data, int len, bool confirmed);
+static inline bool __needs_caps(tiny_fd_handle_t handle);
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static int __check_received_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t ns)
+/**
+ * Returns type of S-frame, which reports state of the local receiver: RNR if the application
+ * cannot accept I-frames, and RR otherwise.
+ */
+static inline uint8_t __rx_state_frame_type(tiny_fd_handle_t handle, uint8_t peer)
+{
+    return handle->peers[peer].local_busy ? HDLC_S_FRAME_TYPE_RNR : HDLC_S_FRAME_TYPE_RR;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns receive buffer slot of the peer for out-of-order I-frames.
+ */
+static inline tiny_fd_rx_slot_t *__get_rx_slot(tiny_fd_handle_t handle, uint8_t peer, uint8_t index)
+{
+    uint8_t *rx_buf = TINY_ALIGN_BUFFER(&handle->peers[handle->peers_count]);
+    return (tiny_fd_rx_slot_t *)(rx_buf + (peer * handle->rx_slots + index) * handle->rx_slot_size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void __reset_rx_slots(tiny_fd_handle_t handle, uint8_t peer)
+{
+    for ( uint8_t i = 0; i < handle->rx_slots; i++ )
+    {
+        __get_rx_slot(handle, peer, i)->used = 0;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns kept out-of-order I-frame N(S)=ns, or NULL if there is no such frame.
+ */
+static tiny_fd_rx_slot_t *__find_rx_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t ns)
+{
+    for ( uint8_t i = 0; i < handle->rx_slots; i++ )
+    {
+        tiny_fd_rx_slot_t *slot = __get_rx_slot(handle, peer, i);
+        if ( slot->used && slot->ns == ns )
+        {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static bool __has_rx_frames(tiny_fd_handle_t handle, uint8_t peer)
+{
+    for ( uint8_t i = 0; i < handle->rx_slots; i++ )
+    {
+        if ( __get_rx_slot(handle, peer, i)->used )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Keeps out-of-order I-frame until missing frames arrive.
+ * Already kept frames and frames, which do not fit the receive buffer, are dropped.
+ */
+static void __keep_rx_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t ns, const uint8_t *payload, int len)
+{
+    if ( __find_rx_frame(handle, peer, ns) != NULL )
+    {
+        return;
+    }
+    for ( uint8_t i = 0; i < handle->rx_slots; i++ )
+    {
+        tiny_fd_rx_slot_t *slot = __get_rx_slot(handle, peer, i);
+        if ( !slot->used )
+        {
+            memcpy(slot->payload, payload, len);
+            slot->len = len;
+            slot->ns = ns;
+            slot->used = 1;
+            return;
+        }
+    }
+    LOG(TINY_LOG_WRN, "[%p] No space for out of order I-Frame N(s)=%d\n", handle, ns);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static int __check_received_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t ns, const uint8_t *payload, int len)
 {
     int result = TINY_SUCCESS;
     if ( ns == handle->peers[peer].next_nr )
@@ -52,9 +149,35 @@ static int __check_received_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t
         // and we clear sent reject flag to 0 in order to allow REJ frame to be sent again.
 
         // LOG("[%p] Confirming received frame <= %d\n", handle, ns);
-        handle->peers[peer].next_nr = (handle->peers[peer].next_nr + 1) & seq_bits_mask;
+        handle->peers[peer].next_nr = (handle->peers[peer].next_nr + 1) & handle->seq_bits_mask;
         handle->peers[peer].sent_reject = 0;
     }
+    else if ( handle->peers[peer].srej )
+    {
+        // Remote station uses not more than half of N(S) values, so the frame either follows
+        // the missing one, or it is resent after timeout, and was already received.
+        uint8_t distance = (ns - handle->peers[peer].next_nr) & handle->seq_bits_mask;
+        if ( distance < (handle->seq_bits_mask + 1) / 2 )
+        {
+            LOG(TINY_LOG_WRN, "[%p] Out of order I-Frame N(s)=%d is kept\n", handle, ns);
+            __keep_rx_frame(handle, peer, ns, payload, len);
+            if ( !handle->peers[peer].sent_reject )
+            {
+                handle->peers[peer].sent_reject = 1;
+                __put_s_frame_to_tx_queue(handle, __peer_to_address_field( handle, peer ) | HDLC_CR_BIT,
+                                          HDLC_S_FRAME_TYPE_SREJ, handle->peers[peer].next_nr);
+            }
+        }
+        else
+        {
+            // Confirmation was lost, so inform remote station about the frame we want to see
+            LOG(TINY_LOG_WRN, "[%p] Repeated I-Frame N(s)=%d\n", handle, ns);
+            bool gap = __has_rx_frames(handle, peer);
+            __put_s_frame_to_tx_queue(handle, __peer_to_address_field( handle, peer ) | (gap ? HDLC_CR_BIT : 0),
+                                      gap ? HDLC_S_FRAME_TYPE_SREJ : HDLC_S_FRAME_TYPE_RR, handle->peers[peer].next_nr);
+        }
+        result = TINY_ERR_FAILED;
+    }
     else
     {
         // The frame we received is not the one we expected.
@@ -63,12 +186,9 @@ static int __check_received_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t
         LOG(TINY_LOG_WRN, "[%p] Out of order I-Frame N(s)=%d\n", handle, ns);
         if ( !handle->peers[peer].sent_reject )
         {
-            tiny_frame_header_t frame = {
-                .address = __peer_to_address_field( handle, peer ) | HDLC_CR_BIT,
-                .control = HDLC_S_FRAME_BITS | HDLC_S_FRAME_TYPE_REJ | (handle->peers[peer].next_nr << 5),
-            };
             handle->peers[peer].sent_reject = 1;
-            __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, &frame, sizeof(tiny_frame_header_t));
+            __put_s_frame_to_tx_queue(handle, __peer_to_address_field( handle, peer ) | HDLC_CR_BIT, HDLC_S_FRAME_TYPE_REJ,
+                                      handle->peers[peer].next_nr);
         }
         result = TINY_ERR_FAILED;
     }
@@ -77,36 +197,92 @@ static int __check_received_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Passes information field of I-frame to the user.
+ */
+static void __deliver_i_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t ns, uint8_t *payload, int payload_len)
+{
+    // N(S) is used in logs only
+    (void)ns;
+    if ( handle->peers[peer].compression )
+    {
+        payload_len = __decompress_i_frame(handle, &payload, payload_len);
+        if ( payload_len < 0 )
+        {
+            // crc is valid, so the remote station sent wrong frame. It is confirmed, but dropped.
+            LOG(TINY_LOG_ERR, "[%p] Failed to decompress I-Frame N(S)=%02X\n", handle, ns);
+        }
+    }
+    if ( handle->on_read_cb && payload_len >= 0 )
+    {
+        tiny_mutex_unlock(&handle->frames.mutex);
+        handle->on_read_cb(handle->user_data,
+                           __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR,
+                           payload, payload_len);
+        tiny_mutex_lock(&handle->frames.mutex);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static int __on_i_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data, int len)
 {
     uint8_t control = ((uint8_t *)data)[1];
-    uint8_t nr = control >> 5;
-    uint8_t ns = (control >> 1) & 0x07;
+    uint8_t nr = __frame_nr(handle, control, handle->extended ? ((uint8_t *)data)[2] : 0);
+    uint8_t ns = __frame_ns(handle, control);
+    int header_len = __header_len(handle, control);
+    uint8_t *payload = (uint8_t *)data + header_len;
+    int payload_len = len - header_len;
     LOG(TINY_LOG_INFO, "[%p] Receiving I-Frame N(R-sender awaits)=%02X,N(S-seq received)=%02X with address [%02X]\n", handle, nr, ns, ((uint8_t *)data)[0]);
-    int result = __check_received_frame(handle, peer, ns);
+    if ( handle->peers[peer].local_busy )
+    {
+        // The application cannot accept the frame, so it is dropped, and requested again with REJ,
+        // when the application is ready. Remote station must stop sending until then.
+        LOG(TINY_LOG_WRN, "[%p] Receiver is busy, I-Frame N(s)=%d is dropped\n", handle, ns);
+        handle->peers[peer].local_busy = 2;
+        __confirm_sent_frames(handle, peer, nr);
+        __put_s_frame_to_tx_queue(handle, __peer_to_address_field( handle, peer ), HDLC_S_FRAME_TYPE_RNR,
+                                  handle->peers[peer].next_nr);
+        return TINY_ERR_FAILED;
+    }
+    int result = __check_received_frame(handle, peer, ns, payload, payload_len);
     // Confirm all previously sent frames up to received N(R)
     __confirm_sent_frames(handle, peer, nr);
     // Provide data to user only if we expect this frame
     if ( result == TINY_SUCCESS )
     {
-        if ( handle->on_read_cb )
+        __deliver_i_frame(handle, peer, ns, payload, payload_len);
+        // Kept out-of-order frames, which follow the received one, are passed to the user in order.
+        // The slot is freed before the callback, its data are overwritten only in rx context.
+        tiny_fd_rx_slot_t *slot;
+        // The application can become busy in the callback, then kept frames wait until it is ready
+        while ( !handle->peers[peer].local_busy &&
+                (slot = __find_rx_frame(handle, peer, handle->peers[peer].next_nr)) != NULL )
+        {
+            slot->used = 0;
+            handle->peers[peer].next_nr = (handle->peers[peer].next_nr + 1) & handle->seq_bits_mask;
+            __deliver_i_frame(handle, peer, slot->ns, slot->payload, slot->len);
+        }
+        if ( handle->peers[peer].local_busy && __has_rx_frames(handle, peer) )
+        {
+            // Kept frames are dropped, and requested again with REJ, when the application is ready
+            __reset_rx_slots(handle, peer);
+            handle->peers[peer].local_busy = 2;
+        }
+        if ( !handle->peers[peer].local_busy && __has_rx_frames(handle, peer) )
         {
-            tiny_mutex_unlock(&handle->frames.mutex);
-            handle->on_read_cb(handle->user_data,
-                               __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR,
-                               (uint8_t *)data + 2, len - 2);
-            tiny_mutex_lock(&handle->frames.mutex);
+            // There is one more missing frame before kept ones
+            handle->peers[peer].sent_reject = 1;
+            __put_s_frame_to_tx_queue(handle, __peer_to_address_field( handle, peer ) | HDLC_CR_BIT,
+                                      HDLC_S_FRAME_TYPE_SREJ, handle->peers[peer].next_nr);
         }
         // Decide whenever we need to send RR after user callback
         // Check if we need to send confirmations separately. If we have something to send, just skip RR S-frame.
         // Also at this point, since we received expected frame, sent_reject will be cleared to 0.
-        if ( __all_frames_are_sent(handle, peer) && handle->peers[peer].sent_nr != handle->peers[peer].next_nr )
+        else if ( __all_frames_are_sent(handle, peer) && handle->peers[peer].sent_nr != handle->peers[peer].next_nr )
         {
-            tiny_frame_header_t frame = {
-                .address = __peer_to_address_field( handle, peer ),
-                .control = HDLC_S_FRAME_BITS | HDLC_S_FRAME_TYPE_RR | (handle->peers[peer].next_nr << 5),
-            };
-            __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, &frame, 2);
+            __put_s_frame_to_tx_queue(handle, __peer_to_address_field( handle, peer ), __rx_state_frame_type(handle, peer),
+                                      handle->peers[peer].next_nr);
         }
     }
     return result;
@@ -118,32 +294,54 @@ static int __on_s_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data,
 {
     uint8_t address = ((uint8_t *)data)[0];
     uint8_t control = ((uint8_t *)data)[1];
-    uint8_t nr = control >> 5;
+    uint8_t nr = __frame_nr(handle, control, handle->extended ? ((uint8_t *)data)[2] : 0);
     int result = TINY_ERR_FAILED;
     LOG(TINY_LOG_INFO, "[%p] Receiving S-Frame N(R)=%02X, type=%s with address [%02X]\n", handle, nr,
-        ((control >> 2) & 0x03) == 0x00 ? "RR" : "REJ", ((uint8_t *)data)[0]);
+        __s_frame_type_str(control), ((uint8_t *)data)[0]);
+    if ( (control & HDLC_S_FRAME_TYPE_MASK) == HDLC_S_FRAME_TYPE_RNR )
+    {
+        // Remote station confirms frames up to N(R), and drops the rest until it is ready
+        __confirm_sent_frames(handle, peer, nr);
+        if ( !handle->peers[peer].remote_busy )
+        {
+            LOG(TINY_LOG_WRN, "[%p] Remote receiver is busy\n", handle);
+            handle->peers[peer].remote_busy = 1;
+            // Remote station is polled after retry timeout, if it doesn't report ready state itself
+            handle->peers[peer].last_sent_i_ts = tiny_millis();
+        }
+        // Busy station is alive, so waiting for it doesn't use retries
+        handle->peers[peer].retries = handle->retries;
+    }
+    else if ( handle->peers[peer].remote_busy )
+    {
+        // Any other S-frame means that remote receiver is ready
+        LOG(TINY_LOG_WRN, "[%p] Remote receiver is ready\n", handle);
+        handle->peers[peer].remote_busy = 0;
+        tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
+    }
     if ( (control & HDLC_S_FRAME_TYPE_MASK) == HDLC_S_FRAME_TYPE_REJ )
     {
         // Confirm all previously sent frames up to received N(R)
         __confirm_sent_frames(handle, peer, nr);
         __resend_all_unconfirmed_frames(handle, peer, control, nr);
     }
+    else if ( (control & HDLC_S_FRAME_TYPE_MASK) == HDLC_S_FRAME_TYPE_SREJ )
+    {
+        // All frames before N(R) are received, the remote station waits for N(R) frame only
+        __confirm_sent_frames(handle, peer, nr);
+        __resend_unconfirmed_frame(handle, peer, control, nr);
+    }
     else if ( (control & HDLC_S_FRAME_TYPE_MASK) == HDLC_S_FRAME_TYPE_RR )
     {
         // Confirm all previously sent frames up to received N(R)
         __confirm_sent_frames(handle, peer, nr);
-        if ( address & HDLC_CR_BIT )
-        {
-            // Send answer if we don't have frames to send
-            if ( handle->peers[peer].next_ns == handle->peers[peer].last_ns )
-            {
-                tiny_frame_header_t frame = {
-                    .address = __peer_to_address_field( handle, peer ),
-                    .control = HDLC_S_FRAME_BITS | HDLC_S_FRAME_TYPE_RR | (handle->peers[peer].next_nr << 5),
-                };
-                __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, &frame, 2);
-            }
-        }
+    }
+    if ( ((control & HDLC_S_FRAME_TYPE_MASK) == HDLC_S_FRAME_TYPE_RR ||
+          (control & HDLC_S_FRAME_TYPE_MASK) == HDLC_S_FRAME_TYPE_RNR) && (address & HDLC_CR_BIT) )
+    {
+        // Poll is always answered, since I-frames do not carry state of the receiver
+        __put_s_frame_to_tx_queue(handle, __peer_to_address_field( handle, peer ), __rx_state_frame_type(handle, peer),
+                                  handle->peers[peer].next_nr);
     }
     return result;
 }
@@ -156,17 +354,25 @@ static int __on_u_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data,
     uint8_t type = control & HDLC_U_FRAME_TYPE_MASK;
     int result = TINY_ERR_FAILED;
     LOG(TINY_LOG_INFO, "[%p] Receiving U-Frame type=%02X with address [%02X]\n", handle, type, ((uint8_t *)data)[0]);
-    if ( type == HDLC_U_FRAME_TYPE_SABM || type == HDLC_U_FRAME_TYPE_SNRM )
+    if ( type == HDLC_U_FRAME_TYPE_SABM || type == HDLC_U_FRAME_TYPE_SNRM || type == HDLC_U_FRAME_TYPE_SABME ||
+         type == HDLC_U_FRAME_TYPE_SNRME )
     {
-        tiny_frame_header_t frame = {
-            .address = __peer_to_address_field( handle, peer ),
-            .control = HDLC_U_FRAME_TYPE_UA | HDLC_U_FRAME_BITS,
-        };
-        __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_U_FRAME, &frame, 2);
+        bool extended = type == HDLC_U_FRAME_TYPE_SABME || type == HDLC_U_FRAME_TYPE_SNRME;
+        if ( extended != !!handle->extended )
+        {
+            // Both stations must use the same format of control field, the remote station keeps trying
+            LOG(TINY_LOG_ERR, "[%p] Remote station requests %s mode, which is not configured\n", handle,
+                extended ? "extended" : "basic");
+            return result;
+        }
         if ( handle->peers[peer].state != TINY_FD_STATE_DISCONNECTED && handle->peers[peer].state != TINY_FD_STATE_CONNECTING )
         {
             __switch_to_disconnected_state(handle, peer);
         }
+        // Capabilities are sent back only to the stations, which support them, or if local station needs them
+        bool caps = __on_peer_caps(handle, peer, (const uint8_t *)data, len, false);
+        __put_u_frame_with_caps(handle, TINY_FD_QUEUE_U_FRAME, __peer_to_address_field( handle, peer ),
+                                HDLC_U_FRAME_TYPE_UA | HDLC_U_FRAME_BITS, caps || __needs_caps(handle));
         __switch_to_connected_state(handle, peer);
     }
     else if ( type == HDLC_U_FRAME_TYPE_DISC )
@@ -192,7 +398,8 @@ static int __on_u_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data,
     {
         if ( handle->peers[peer].state == TINY_FD_STATE_CONNECTING )
         {
-            // confirmation received
+            // confirmation received, the remote station already uses local capabilities
+            __on_peer_caps(handle, peer, (const uint8_t *)data, len, true);
             __switch_to_connected_state(handle, peer);
         }
         else if ( handle->peers[peer].state == TINY_FD_STATE_DISCONNECTING )
@@ -30,6 +30,7 @@
 #include "hal/tiny_debug.h"
 #include "tiny_fd_int.h"
 #include "tiny_fd_defines_int.h"
+#include "tiny_fd_control_int.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -63,12 +64,12 @@ static tiny_fd_frame_subtype_t __get_frame_subtype(uint8_t control)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static uint8_t __get_frame_sequence(uint8_t control)
+static uint8_t __get_frame_sequence(tiny_fd_handle_t handle, uint8_t control)
 {
     tiny_fd_frame_type_t type = __get_frame_type(control);
     switch (type)
     {
-        case TINY_FD_FRAME_TYPE_I: return (control >> 1) & 0x07;
+        case TINY_FD_FRAME_TYPE_I: return __frame_ns(handle, control);
         case TINY_FD_FRAME_TYPE_S:
         case TINY_FD_FRAME_TYPE_U:
         default: return 0;
@@ -77,13 +78,13 @@ static uint8_t __get_frame_sequence(uint8_t control)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static uint8_t __get_awaiting_sequence(uint8_t control)
+static uint8_t __get_awaiting_sequence(tiny_fd_handle_t handle, uint8_t control, uint8_t control_ext)
 {
     tiny_fd_frame_type_t type = __get_frame_type(control);
     switch (type)
     {
-        case TINY_FD_FRAME_TYPE_I: return control >> 5;
-        case TINY_FD_FRAME_TYPE_S: return control >> 5;
+        case TINY_FD_FRAME_TYPE_I: return __frame_nr(handle, control, control_ext);
+        case TINY_FD_FRAME_TYPE_S: return __frame_nr(handle, control, control_ext);
         case TINY_FD_FRAME_TYPE_U:
         default: return 0;
     }
@@ -116,7 +117,9 @@ static const char *__get_frame_subtype_str(uint8_t control)
         switch (control & HDLC_S_FRAME_TYPE_MASK)
         {
             case HDLC_S_FRAME_TYPE_RR:  return "  RR";
+            case HDLC_S_FRAME_TYPE_RNR: return " RNR";
             case HDLC_S_FRAME_TYPE_REJ: return " REJ";
+            case HDLC_S_FRAME_TYPE_SREJ: return "SREJ";
             default:                    return " UNK";
         }
     }
@@ -127,6 +130,8 @@ static const char *__get_frame_subtype_str(uint8_t control)
         case HDLC_U_FRAME_TYPE_RSET: return "RSET";
         case HDLC_U_FRAME_TYPE_SABM: return "SABM";
         case HDLC_U_FRAME_TYPE_SNRM: return "SNRM";
+        case HDLC_U_FRAME_TYPE_SABME: return "SABE";
+        case HDLC_U_FRAME_TYPE_SNRME: return "SNRE";
         case HDLC_U_FRAME_TYPE_DISC: return "DISC";
         default:                     return " UNK";
     }
@@ -134,29 +139,51 @@ static const char *__get_frame_subtype_str(uint8_t control)
 
 #endif // TINY_FD_DEBUG && TINY_FILE_LOGGING
 
-void __tiny_fd_log_frame(tiny_fd_handle_t handle,
-                       tiny_fd_frame_direction_t direction,
-                       const uint8_t *data,
-                       int len)
+static void __log_frame(tiny_fd_handle_t handle,
+                        tiny_fd_frame_direction_t direction,
+                        uint8_t control,
+                        uint8_t control_ext,
+                        const uint8_t *data,
+                        int len)
 {
-    if (handle == NULL || data == NULL || len < 2) {
-        return;
-    }
     if (handle->log_frame_cb) {
         handle->log_frame_cb(handle->user_data,
                              handle,
                              direction,
-                             __get_frame_type(data[1]),
-                             __get_frame_subtype(data[1]),
-                             __get_frame_sequence(data[1]),
-                             __get_awaiting_sequence(data[1]), data, len);
+                             __get_frame_type(control),
+                             __get_frame_subtype(control),
+                             __get_frame_sequence(handle, control),
+                             __get_awaiting_sequence(handle, control, control_ext), data, len);
     }
     FILE_LOG((uintptr_t)handle,
         direction == TINY_FD_FRAME_DIRECTION_IN ? " IN" : "OUT",
         data[0],
-        __get_frame_type_str(data[1]),
-        __get_frame_subtype_str(data[1]),
-        __get_frame_sequence(data[1]),
-        __get_awaiting_sequence(data[1]));
+        __get_frame_type_str(control),
+        __get_frame_subtype_str(control),
+        __get_frame_sequence(handle, control),
+        __get_awaiting_sequence(handle, control, control_ext));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void __tiny_fd_log_frame(tiny_fd_handle_t handle,
+                       tiny_fd_frame_direction_t direction,
+                       const uint8_t *data,
+                       int len)
+{
+    if (handle == NULL || data == NULL || len < 2 || len < __header_len(handle, data[1])) {
+        return;
+    }
+    __log_frame(handle, direction, data[1], handle->extended ? data[2] : 0, data, len);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void __tiny_fd_log_out_frame(tiny_fd_handle_t handle, const tiny_fd_frame_info_t *frame)
+{
+    // Second byte of extended control field is not stored next to the header, so data
+    // passed to the callback are address, first byte of control field and information field
+    __log_frame(handle, TINY_FD_FRAME_DIRECTION_OUT, frame->header.control, frame->control_ext,
+                (const uint8_t *)&frame->header, frame->len + (int)sizeof(tiny_frame_header_t));
 }
 
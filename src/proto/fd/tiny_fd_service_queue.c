@@ -32,6 +32,7 @@
 #include "tiny_fd_int.h"
 #include "tiny_fd_defines_int.h"
 #include "tiny_fd_peers_int.h"
+#include "tiny_fd_control_int.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -43,6 +44,7 @@ tiny_fd_frame_info_t *__put_u_s_frame_to_tx_queue(tiny_fd_handle_t handle, int t
     {
         slot->header.address = ((const uint8_t *)data)[0];
         slot->header.control = ((const uint8_t *)data)[1];
+        slot->control_ext = 0;
         LOG(TINY_LOG_DEB, "[%p] QUEUE SU-PUT: [%02X] [%02X]\n", handle, slot->header.address, slot->header.control);
         tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
         return slot;
@@ -57,34 +59,49 @@ tiny_fd_frame_info_t *__put_u_s_frame_to_tx_queue(tiny_fd_handle_t handle, int t
 
 ///////////////////////////////////////////////////////////////////////////////
 
-uint8_t *tiny_fd_get_next_s_u_frame_to_send(tiny_fd_handle_t handle, int *len, uint8_t peer, uint8_t address)
+tiny_fd_frame_info_t *__put_s_frame_to_tx_queue(tiny_fd_handle_t handle, uint8_t address, uint8_t type, uint8_t nr)
+{
+    tiny_frame_header_t frame = {
+        .address = address,
+        .control = HDLC_S_FRAME_BITS | type,
+    };
+    tiny_fd_frame_info_t *slot = __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, &frame, sizeof(frame));
+    if ( slot != NULL )
+    {
+        __set_frame_nr(handle, slot, nr);
+    }
+    return slot;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+tiny_fd_frame_info_t *tiny_fd_get_next_s_u_frame_to_send(tiny_fd_handle_t handle, uint8_t peer, uint8_t address)
 {
-    uint8_t *data = NULL;
     // LOG(TINY_LOG_DEB, "[%p] QUEUE SEARCH: [%02X] [%02X]\n", handle, address, TINY_FD_QUEUE_S_FRAME | TINY_FD_QUEUE_U_FRAME);
-    tiny_fd_frame_info_t *ptr = tiny_fd_queue_get_next( &handle->frames.s_queue, TINY_FD_QUEUE_S_FRAME | TINY_FD_QUEUE_U_FRAME, address, 0 );
+    tiny_fd_frame_info_t *ptr = tiny_fd_queue_get_next( &handle->frames.s_queue, TINY_FD_QUEUE_S_FRAME | TINY_FD_QUEUE_U_FRAME, address );
+    // clear queue only, when send is done, so for now, use pointer data for sending only
     if ( ptr != NULL )
     {
-        // clear queue only, when send is done, so for now, use pointer data for sending only
-        data = (uint8_t *)&ptr->header;
-        *len = ptr->len + sizeof(tiny_frame_header_t);
-        if ( (data[1] & HDLC_S_FRAME_MASK) == HDLC_S_FRAME_BITS )
+        uint8_t control = ptr->header.control;
+        if ( (control & HDLC_S_FRAME_MASK) == HDLC_S_FRAME_BITS )
         {
-            handle->peers[peer].sent_nr = ptr->header.control >> 5;
+            handle->peers[peer].sent_nr = __frame_nr(handle, control, ptr->control_ext);
         }
 #if TINY_FD_DEBUG
-        if ( (data[1] & HDLC_U_FRAME_MASK) == HDLC_U_FRAME_BITS )
+        if ( __is_u_frame(control) )
         {
-            LOG(TINY_LOG_INFO, "[%p] Sending U-Frame type=%02X with address [%02X] to %s\n", handle, data[1] & HDLC_U_FRAME_TYPE_MASK, data[0],
-                      __is_primary_station( handle ) ? "secondary" : "primary");
+            LOG(TINY_LOG_INFO, "[%p] Sending U-Frame type=%02X with address [%02X] to %s\n", handle, control & HDLC_U_FRAME_TYPE_MASK,
+                ptr->header.address, __is_primary_station( handle ) ? "secondary" : "primary");
         }
-        else if ( (data[1] & HDLC_S_FRAME_MASK) == HDLC_S_FRAME_BITS )
+        else if ( (control & HDLC_S_FRAME_MASK) == HDLC_S_FRAME_BITS )
         {
-            LOG(TINY_LOG_INFO, "[%p] Sending S-Frame N(R)=%02X, type=%s with address [%02X] to %s\n", handle, data[1] >> 5,
-                ((data[1] >> 2) & 0x03) == 0x00 ? "RR" : "REJ", data[0],  __is_primary_station( handle ) ? "secondary" : "primary");
+            LOG(TINY_LOG_INFO, "[%p] Sending S-Frame N(R)=%02X, type=%s with address [%02X] to %s\n", handle,
+                __frame_nr(handle, control, ptr->control_ext), __s_frame_type_str(control),
+                ptr->header.address, __is_primary_station( handle ) ? "secondary" : "primary");
         }
 #endif
     }
-    return data;
+    return ptr;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -38,6 +38,14 @@ tiny_fd_frame_info_t *__put_u_s_frame_to_tx_queue(tiny_fd_handle_t handle, int t
 
 ///////////////////////////////////////////////////////////////////////////////
 
-uint8_t* tiny_fd_get_next_s_u_frame_to_send(tiny_fd_handle_t handle, int *len, uint8_t peer, uint8_t address);
+/**
+ * Puts S-frame of specified type (HDLC_S_FRAME_TYPE_RR, HDLC_S_FRAME_TYPE_REJ) with N(R) to the queue.
+ * The control field is formatted according to the mode of the link.
+ */
+tiny_fd_frame_info_t *__put_s_frame_to_tx_queue(tiny_fd_handle_t handle, uint8_t address, uint8_t type, uint8_t nr);
+
+///////////////////////////////////////////////////////////////////////////////
+
+tiny_fd_frame_info_t *tiny_fd_get_next_s_u_frame_to_send(tiny_fd_handle_t handle, uint8_t peer, uint8_t address);
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -53,18 +53,24 @@ void __confirm_sent_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t nr)
             LOG(TINY_LOG_CRIT, "[%p] Confirmation contains wrong N(r). Remote side is out of sync\n", handle);
             break;
         }
-        uint8_t address = __peer_to_address_field( handle, peer );
         // LOG("[%p] Confirming sent frames %d\n", handle, handle->peers[peer].confirm_ns);
         // Call on_send_cb to inform application that frame was sent
-        tiny_fd_frame_info_t *slot = tiny_fd_queue_get_next( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, address, handle->peers[peer].confirm_ns );
+        tiny_fd_frame_info_t *slot = tiny_fd_queue_get_i_frame( &handle->frames.i_queue, peer, handle->peers[peer].confirm_ns );
         if ( slot != NULL )
         {
-            if ( handle->on_send_cb )
+            uint8_t *payload = &slot->payload[0];
+            int len = slot->len;
+            if ( handle->peers[peer].compression )
+            {
+                // The application gets the data it sent, not the compressed frame
+                len = __decompress_i_frame(handle, &payload, len);
+            }
+            if ( handle->on_send_cb && len >= 0 )
             {
                 tiny_mutex_unlock(&handle->frames.mutex);
                 handle->on_send_cb(handle->user_data,
                                    __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR,
-                                   &slot->payload[0], slot->len);
+                                   payload, len);
                 tiny_mutex_lock(&handle->frames.mutex);
             }
             tiny_fd_queue_free( &handle->frames.i_queue, slot );
@@ -80,7 +86,7 @@ void __confirm_sent_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t nr)
             // TODO: Add error processing
             LOG(TINY_LOG_ERR, "[%p] The frame cannot be confirmed: %02X\n", handle, handle->peers[peer].confirm_ns);
         }
-        handle->peers[peer].confirm_ns = (handle->peers[peer].confirm_ns + 1) & seq_bits_mask;
+        handle->peers[peer].confirm_ns = (handle->peers[peer].confirm_ns + 1) & handle->seq_bits_mask;
         handle->peers[peer].retries = handle->retries;
     }
     // Check if we can accept new frames from the application.
@@ -110,13 +116,36 @@ void __resend_all_unconfirmed_frames(tiny_fd_handle_t handle, uint8_t peer, uint
                 .data1 = control,
                 .data2 = (handle->peers[peer].next_nr << 5) | (handle->peers[peer].next_ns << 1),
             };
-            // Send 2-byte header + 2 extra bytes
-            __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_U_FRAME, &frame, 4);
+            if ( handle->extended )
+            {
+                // Extended mode has separate bytes for N(S) and N(R)
+                frame.data2 = handle->peers[peer].next_ns << 1;
+                frame.data3 = handle->peers[peer].next_nr << 1;
+            }
+            // Send 2-byte header + 2 or 3 extra bytes
+            __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_U_FRAME, &frame, handle->extended ? 5 : 4);
             break;
         }
-        handle->peers[peer].next_ns = (handle->peers[peer].next_ns - 1) & seq_bits_mask;
+        handle->peers[peer].next_ns = (handle->peers[peer].next_ns - 1) & handle->seq_bits_mask;
     }
     LOG(TINY_LOG_DEB, "[%p] N(s) is set to %02X\n", handle, handle->peers[peer].next_ns);
     tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+void __resend_unconfirmed_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t control, uint8_t ns)
+{
+    if ( !__is_sent_unconfirmed_frame(handle, peer, ns) )
+    {
+        // The frame was never sent or is already confirmed, so remote side is not in sync
+        __resend_all_unconfirmed_frames(handle, peer, control, ns);
+        return;
+    }
+    // Remote station waits for this frame only, so the last request replaces previous one
+    handle->peers[peer].srej_ns = ns;
+    handle->peers[peer].srej_pending = 1;
+    LOG(TINY_LOG_DEB, "[%p] N(s)=%02X is scheduled for resending\n", handle, ns);
+    tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
+}
+
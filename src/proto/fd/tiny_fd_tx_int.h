@@ -35,3 +35,9 @@
 
 void __confirm_sent_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t nr);
 void __resend_all_unconfirmed_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t control, uint8_t nr);
+
+/**
+ * Schedules single unconfirmed I-frame N(S)=ns for resending, next_ns is not changed.
+ * Used if selective reject is negotiated for the link.
+ */
+void __resend_unconfirmed_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t control, uint8_t ns);
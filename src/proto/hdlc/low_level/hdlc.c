@@ -28,10 +28,12 @@
 
 #include "hdlc.h"
 #include "hdlc_int.h"
+#include "hdlc_scan_int.h"
 #include "proto/crc/tiny_crc.h"
 #include "hal/tiny_debug.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #ifndef TINY_HDLC_DEBUG
 #define TINY_HDLC_DEBUG 0
@@ -43,10 +45,22 @@
 #define LOG(...)
 #endif
 
+#ifdef CONFIG_ENABLE_STATS
+#define STATS(x) x
+#else
+#define STATS(x)
+#endif
+
 #define FLAG_SEQUENCE 0x7E
 #define FILL_BYTE 0xFF
 #define TINY_ESCAPE_CHAR 0x7D
 #define TINY_ESCAPE_BIT 0x20
+#define COBS_DELIMITER 0x00
+// Maximum number of data bytes in COBS block
+#define COBS_MAX_BLOCK 254
+
+// Number of received bytes, after which running crc is updated
+#define HDLC_RX_CRC_BLOCK 64
 
 enum
 {
@@ -59,12 +73,115 @@ enum
 static int hdlc_ll_read_start(hdlc_ll_handle_t handle, const uint8_t *data, int len);
 static int hdlc_ll_read_data(hdlc_ll_handle_t handle, const uint8_t *data, int len);
 static int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int len);
+static int hdlc_ll_read_idle(hdlc_ll_handle_t handle, const uint8_t *data, int len);
+static int hdlc_ll_read_cobs(hdlc_ll_handle_t handle, const uint8_t *data, int len);
+static int hdlc_ll_read_address(hdlc_ll_handle_t handle, const uint8_t *data, int len);
+static int hdlc_ll_read_skip(hdlc_ll_handle_t handle, const uint8_t *data, int len);
 
 static int hdlc_ll_send_start(hdlc_ll_handle_t handle);
 static int hdlc_ll_send_data(hdlc_ll_handle_t handle);
+static int hdlc_ll_send_cobs(hdlc_ll_handle_t handle);
 static int hdlc_ll_send_tx_internal(hdlc_ll_handle_t handle, const void *data, int len);
 static int hdlc_ll_send_crc(hdlc_ll_handle_t handle);
 static int hdlc_ll_send_end(hdlc_ll_handle_t handle);
+static int hdlc_ll_send_abort(hdlc_ll_handle_t handle);
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns size of crc field in bytes for the crc type, stored in the handle.
+ * hdlc_ll_init() stores HDLC_CRC_OFF as 0, so 0 means no crc field here.
+ */
+static inline int hdlc_ll_crc_size(hdlc_crc_t crc_type)
+{
+    return crc_type == HDLC_CRC_32C ? 4 : (uint8_t)crc_type / 8;
+}
+
+static inline crc_t hdlc_ll_crc_init(hdlc_crc_t crc_type)
+{
+    switch ( crc_type )
+    {
+#ifdef CONFIG_ENABLE_FCS16
+        case HDLC_CRC_16: return PPPINITFCS16;
+#endif
+#ifdef CONFIG_ENABLE_FCS32
+        case HDLC_CRC_32: return PPPINITFCS32;
+#endif
+#ifdef CONFIG_ENABLE_FCS32C
+        case HDLC_CRC_32C: return PPPINITFCS32C;
+#endif
+#ifdef CONFIG_ENABLE_CHECKSUM
+        case HDLC_CRC_8: return INITCHECKSUM;
+#endif
+        default: return 0;
+    }
+}
+
+static inline crc_t hdlc_ll_crc_update(hdlc_crc_t crc_type, crc_t crc, const uint8_t *data, int len)
+{
+    switch ( crc_type )
+    {
+#ifdef CONFIG_ENABLE_FCS16
+        case HDLC_CRC_16: return tiny_crc16_update((uint16_t)crc, data, len);
+#endif
+#ifdef CONFIG_ENABLE_FCS32
+        case HDLC_CRC_32: return tiny_crc32_update(crc, data, len);
+#endif
+#ifdef CONFIG_ENABLE_FCS32C
+        case HDLC_CRC_32C: return tiny_crc32c_update(crc, data, len);
+#endif
+#ifdef CONFIG_ENABLE_CHECKSUM
+        case HDLC_CRC_8: return tiny_chksum_update((uint16_t)crc, data, len);
+#endif
+        default: return crc;
+    }
+}
+
+static inline crc_t hdlc_ll_crc_final(hdlc_crc_t crc_type, crc_t crc)
+{
+    switch ( crc_type )
+    {
+#ifdef CONFIG_ENABLE_FCS16
+        case HDLC_CRC_16: return (uint16_t)(crc ^ 0xFFFF);
+#endif
+#ifdef CONFIG_ENABLE_FCS32
+        case HDLC_CRC_32: return crc ^ 0xFFFFFFFF;
+#endif
+#ifdef CONFIG_ENABLE_FCS32C
+        case HDLC_CRC_32C: return crc ^ 0xFFFFFFFF;
+#endif
+#ifdef CONFIG_ENABLE_CHECKSUM
+        case HDLC_CRC_8: return (uint16_t)(0xFFFF - crc);
+#endif
+        default: return crc;
+    }
+}
+
+/**
+ * Checks running crc value, calculated over the frame and its crc field.
+ * For correct frames such value is always equal to the well-known constant,
+ * so no need to calculate crc over the received frame once again.
+ */
+static inline bool hdlc_ll_crc_is_good(hdlc_crc_t crc_type, crc_t crc)
+{
+    switch ( crc_type )
+    {
+#ifdef CONFIG_ENABLE_FCS16
+        case HDLC_CRC_16: return (uint16_t)crc == PPPGOODFCS16;
+#endif
+#ifdef CONFIG_ENABLE_FCS32
+        case HDLC_CRC_32: return crc == PPPGOODFCS32;
+#endif
+#ifdef CONFIG_ENABLE_FCS32C
+        case HDLC_CRC_32C: return crc == PPPGOODFCS32C;
+#endif
+#ifdef CONFIG_ENABLE_CHECKSUM
+        // Checksum byte is inverted low byte of the sum, so the total sum of the frame is always 0xFF
+        case HDLC_CRC_8: return (crc & 0xFF) == 0xFF;
+#endif
+        default: return true;
+    }
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -93,8 +210,17 @@ int hdlc_ll_init(hdlc_ll_handle_t *handle, hdlc_ll_init_t *init)
     (*handle)->on_frame_read = init->on_frame_read;
     (*handle)->on_frame_send = init->on_frame_send;
     (*handle)->user_data = init->user_data;
+    (*handle)->address_filter = init->address_filter;
+    (*handle)->framing = init->framing == HDLC_FRAMING_COBS ? HDLC_FRAMING_COBS : HDLC_FRAMING_HDLC;
     (*handle)->phys_mtu = init->mtu ? (init->mtu + get_crc_field_size((*handle)->crc_type)): ((*handle)->rx_buf_size);
     (*handle)->rx.active_frame_buf = (*handle)->rx_buf;
+    memset((*handle)->rx.loaned, 0, sizeof((*handle)->rx.loaned));
+    STATS(memset(&(*handle)->stats, 0, sizeof((*handle)->stats)));
+    int result = hdlc_ll_set_accm(*handle, init->accm, init->accm_flags ? init->accm_flags : HDLC_ACCM_TX);
+    if ( result != TINY_SUCCESS )
+    {
+        return result;
+    }
 
     // Must be last
     hdlc_ll_reset(*handle, HDLC_LL_RESET_BOTH);
@@ -103,14 +229,60 @@ int hdlc_ll_init(hdlc_ll_handle_t *handle, hdlc_ll_init_t *init)
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Returns byte, which separates the frames on the line
+ */
+static inline uint8_t hdlc_ll_delimiter(hdlc_ll_handle_t handle)
+{
+    return handle->framing == HDLC_FRAMING_COBS ? COBS_DELIMITER : FLAG_SEQUENCE;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns byte, which fills the line between the frames. 0xFF is valid first byte of COBS frame,
+ * so COBS mode fills the gap with delimiters, which are equal to empty frames.
+ */
+static inline uint8_t hdlc_ll_fill_byte(hdlc_ll_handle_t handle)
+{
+    return handle->framing == HDLC_FRAMING_COBS ? COBS_DELIMITER : FILL_BYTE;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+uint8_t hdlc_ll_get_fill_byte(hdlc_ll_handle_t handle)
+{
+    return hdlc_ll_fill_byte(handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns index of the first non-empty segment of the queued frame.
+ * Frames of empty segments are never queued.
+ */
+static inline uint8_t hdlc_ll_first_segment(const hdlc_ll_tx_frame_t *frame)
+{
+    uint8_t segment = 0;
+    while ( frame->segments[segment].len == 0 )
+    {
+        segment++;
+    }
+    return segment;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 int hdlc_ll_close(hdlc_ll_handle_t handle)
 {
-    if ( handle && handle->tx.data )
+    if ( handle && handle->on_frame_send )
     {
-        if ( handle->on_frame_send )
+        // Return all queued frames to the user
+        for ( uint8_t i = 0; i < handle->tx.queue_count; i++ )
         {
-            handle->on_frame_send(handle->user_data, handle->tx.origin_data,
-                                  (int)(handle->tx.data - handle->tx.origin_data) + handle->tx.len);
+            const hdlc_ll_tx_frame_t *frame = &handle->tx.queue[(handle->tx.queue_head + i) % TINY_HDLC_TX_QUEUE_SIZE];
+            handle->on_frame_send(handle->user_data, frame->segments[hdlc_ll_first_segment(frame)].data,
+                                  frame->frame_len);
         }
     }
     return TINY_SUCCESS;
@@ -118,6 +290,99 @@ int hdlc_ll_close(hdlc_ll_handle_t handle)
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+int hdlc_ll_set_accm(hdlc_ll_handle_t handle, const uint8_t *accm, uint8_t flags)
+{
+    if ( !handle )
+    {
+        return TINY_ERR_INVALID_DATA;
+    }
+    uint8_t map[HDLC_ACCM_SIZE] = {0};
+    if ( accm )
+    {
+        memcpy(map, accm, sizeof(map));
+    }
+    // 0x7E and 0x7D are always escaped. 0x5E and 0x5D cannot be escaped, since their escape pairs
+    // would be 0x7D 0x7E and 0x7D 0x7D
+    static const uint8_t reserved[] = {FLAG_SEQUENCE, TINY_ESCAPE_CHAR, FLAG_SEQUENCE ^ TINY_ESCAPE_BIT,
+                                       TINY_ESCAPE_CHAR ^ TINY_ESCAPE_BIT};
+    for ( unsigned i = 0; i < sizeof(reserved); i++ )
+    {
+        map[reserved[i] >> 3] &= (uint8_t)~(1 << (reserved[i] & 0x07));
+    }
+    bool extended = false;
+    for ( int i = 0; i < HDLC_ACCM_SIZE; i++ )
+    {
+        // Byte X is sent as 0x7D X^0x20, so X^0x20 cannot be discarded by the receiver as inserted one
+        if ( !(i & (TINY_ESCAPE_BIT >> 3)) && (map[i] & map[i + (TINY_ESCAPE_BIT >> 3)]) )
+        {
+            LOG(TINY_LOG_ERR, "[HDLC:%p] accm contains both byte and its escaped pair\n", handle);
+            return TINY_ERR_INVALID_DATA;
+        }
+        extended = extended || map[i];
+    }
+#ifdef CONFIG_ENABLE_ACCM
+    HDLC_ACCM_ADD(map, FLAG_SEQUENCE);
+    HDLC_ACCM_ADD(map, TINY_ESCAPE_CHAR);
+    // Without extra bytes the map is not used at all, and fast scanning for 0x7E and 0x7D works
+    handle->accm_flags = 0;
+    memcpy(handle->accm, map, sizeof(map));
+    handle->accm_flags = extended ? (flags & (HDLC_ACCM_TX | HDLC_ACCM_RX)) : 0;
+    return TINY_SUCCESS;
+#else
+    (void)flags;
+    if ( extended )
+    {
+        LOG(TINY_LOG_ERR, "[HDLC:%p] accm support is disabled, define CONFIG_ENABLE_ACCM\n", handle);
+        return TINY_ERR_FAILED;
+    }
+    return TINY_SUCCESS;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the map of bytes to escape on TX, or NULL if only 0x7E and 0x7D are escaped.
+ */
+static inline const uint8_t *hdlc_ll_tx_map(hdlc_ll_handle_t handle)
+{
+#ifdef CONFIG_ENABLE_ACCM
+    return (handle->accm_flags & HDLC_ACCM_TX) ? handle->accm : NULL;
+#else
+    (void)handle;
+    return NULL;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the map of bytes, which are always escaped by the remote side, if they must be discarded.
+ */
+static inline const uint8_t *hdlc_ll_rx_map(hdlc_ll_handle_t handle)
+{
+#ifdef CONFIG_ENABLE_ACCM
+    return (handle->accm_flags & HDLC_ACCM_RX) ? handle->accm : NULL;
+#else
+    (void)handle;
+    return NULL;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void hdlc_ll_get_stats(hdlc_ll_handle_t handle, hdlc_ll_stats_t *stats)
+{
+#ifdef CONFIG_ENABLE_STATS
+    *stats = handle->stats;
+#else
+    (void)handle;
+    memset(stats, 0, sizeof(*stats));
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void hdlc_ll_reset(hdlc_ll_handle_t handle, uint8_t flags)
 {
     if ( flags != HDLC_LL_RESET_TX_ONLY )
@@ -129,12 +394,72 @@ void hdlc_ll_reset(hdlc_ll_handle_t handle, uint8_t flags)
         handle->tx.data = NULL;
         handle->tx.origin_data = NULL;
         handle->tx.escape = 0;
+        handle->tx.queue_head = 0;
+        handle->tx.queue_count = 0;
         handle->tx.state = hdlc_ll_send_start;
     }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Makes the frame at the head of tx queue current for sending.
+ */
+static void hdlc_ll_load_frame(hdlc_ll_handle_t handle)
+{
+    const hdlc_ll_tx_frame_t *frame = &handle->tx.queue[handle->tx.queue_head];
+    handle->tx.segment = hdlc_ll_first_segment(frame);
+    handle->tx.data = (const uint8_t *)frame->segments[handle->tx.segment].data;
+    handle->tx.len = frame->segments[handle->tx.segment].len;
+    // Must be last, since non-NULL origin_data marks the frame as ready for sending
+    handle->tx.origin_data = handle->tx.data;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Checks if the byte must be sent as escape pair.
+ */
+static inline bool hdlc_ll_tx_escaped(hdlc_ll_handle_t handle, uint8_t byte)
+{
+    const uint8_t *tx_map = hdlc_ll_tx_map(handle);
+    return byte == FLAG_SEQUENCE || byte == TINY_ESCAPE_CHAR || (tx_map && hdlc_scan_in_map(tx_map, byte));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Switches tx to sending data of the current frame, the opening delimiter is already sent.
+ */
+static void hdlc_ll_begin_frame(hdlc_ll_handle_t handle)
+{
+    // crc is calculated while the frame is being sent, so the first bytes go to the wire immediately
+    handle->tx.crc = hdlc_ll_crc_init(handle->crc_type);
+    handle->tx.escape = 0;
+    if ( handle->framing != HDLC_FRAMING_COBS )
+    {
+        handle->tx.state = hdlc_ll_send_data;
+        return;
+    }
+    // COBS code byte depends on the bytes ahead, including crc field, so crc is calculated in advance
+    const hdlc_ll_tx_frame_t *frame = &handle->tx.queue[handle->tx.queue_head];
+    for ( uint8_t i = 0; i < frame->segment_count; i++ )
+    {
+        handle->tx.crc = hdlc_ll_crc_update(handle->crc_type, handle->tx.crc, (const uint8_t *)frame->segments[i].data,
+                                            frame->segments[i].len);
+    }
+    handle->tx.crc = hdlc_ll_crc_final(handle->crc_type, handle->tx.crc);
+    for ( uint8_t i = 0; i < sizeof(handle->tx.crc_field); i++ )
+    {
+        handle->tx.crc_field[i] = (uint8_t)(handle->tx.crc >> (i * 8));
+    }
+    handle->tx.cobs_left = 0;
+    handle->tx.cobs_zero = 0;
+    handle->tx.state = hdlc_ll_send_cobs;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+
 static int hdlc_ll_send_start(hdlc_ll_handle_t handle)
 {
     // Do not clear data ready bit here in case if 0x7F is failed to be sent
@@ -144,34 +469,39 @@ static int hdlc_ll_send_start(hdlc_ll_handle_t handle)
         return 0;
     }
     LOG(TINY_LOG_INFO, "[HDLC:%p] Starting send op for HDLC frame\n", handle);
-    switch ( handle->crc_type )
-    {
-#ifdef CONFIG_ENABLE_FCS16
-        case HDLC_CRC_16: handle->tx.crc = tiny_crc16(PPPINITFCS16, handle->tx.data, handle->tx.len); break;
-#endif
-#ifdef CONFIG_ENABLE_FCS32
-        case HDLC_CRC_32: handle->tx.crc = tiny_crc32(PPPINITFCS32, handle->tx.data, handle->tx.len); break;
-#endif
-#ifdef CONFIG_ENABLE_CHECKSUM
-        case HDLC_CRC_8: handle->tx.crc = tiny_chksum(INITCHECKSUM, handle->tx.data, handle->tx.len); break;
-#endif
-        default: break;
-    }
-
-    uint8_t buf[1] = {FLAG_SEQUENCE};
+    uint8_t buf[1] = {hdlc_ll_delimiter(handle)};
     int result = hdlc_ll_send_tx_internal(handle, buf, sizeof(buf));
     if ( result == 1 )
     {
         LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_ll_send_data\n", handle);
         LOG(TINY_LOG_DEB, "[HDLC:%p] TX: %02X\n", handle, buf[0]);
-        handle->tx.state = hdlc_ll_send_data;
-        handle->tx.escape = 0;
+        hdlc_ll_begin_frame(handle);
     }
     return result;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Switches tx to the next non-empty segment of the frame.
+ * Returns false if there are no more segments.
+ */
+static inline bool hdlc_ll_next_segment(hdlc_ll_handle_t handle)
+{
+    const hdlc_ll_tx_frame_t *frame = &handle->tx.queue[handle->tx.queue_head];
+    while ( handle->tx.segment + 1 < frame->segment_count )
+    {
+        const hdlc_ll_segment_t *segment = &frame->segments[++handle->tx.segment];
+        if ( segment->len > 0 )
+        {
+            handle->tx.data = (const uint8_t *)segment->data;
+            handle->tx.len = segment->len;
+            return true;
+        }
+    }
+    return false;
+}
+
 static int hdlc_ll_send_data(hdlc_ll_handle_t handle)
 {
     // This commented out code is never reachable because of implementation of hdlc_ll_put() - it check for zero length
@@ -181,43 +511,74 @@ static int hdlc_ll_send_data(hdlc_ll_handle_t handle)
     //    handle->tx.state = hdlc_ll_send_crc;
     //    return 0;
     //}
-    int pos = 0;
-    while ( handle->tx.data[pos] != FLAG_SEQUENCE && handle->tx.data[pos] != TINY_ESCAPE_CHAR && pos < handle->tx.len )
-    {
-        pos++;
-    }
+    const uint8_t *crc_ptr = handle->tx.data;
     int result = 0;
-    if ( pos )
+    while ( handle->tx.out_buffer_len > 0 )
     {
-        result = hdlc_ll_send_tx_internal(handle, handle->tx.data, pos);
-        if ( result > 0 )
+        if ( handle->tx.len == 0 )
+        {
+            // Segment is sent, crc is updated over its tail before switching to the next one
+            handle->tx.crc =
+                hdlc_ll_crc_update(handle->crc_type, handle->tx.crc, crc_ptr, (int)(handle->tx.data - crc_ptr));
+            bool has_next = hdlc_ll_next_segment(handle);
+            crc_ptr = handle->tx.data;
+            if ( !has_next )
+            {
+                break;
+            }
+            continue;
+        }
+        if ( handle->tx.escape )
         {
+            uint8_t byte = handle->tx.data[0] ^ TINY_ESCAPE_BIT;
+            hdlc_ll_send_tx_internal(handle, &byte, sizeof(byte));
+            LOG(TINY_LOG_DEB, "[HDLC:%p] TX: %02X\n", handle, byte);
+            handle->tx.escape = 0;
+            handle->tx.data++;
+            handle->tx.len--;
+            result++;
+            continue;
+        }
+        // Do not scan further than the output buffer can accept, the rest will be scanned on next call
+        int chunk = handle->tx.len < handle->tx.out_buffer_len ? handle->tx.len : handle->tx.out_buffer_len;
+        const uint8_t *tx_map = hdlc_ll_tx_map(handle);
+        int pos = tx_map ? hdlc_scan_map(handle->tx.data, chunk, tx_map) : hdlc_scan_special(handle->tx.data, chunk);
+        if ( pos )
+        {
+            hdlc_ll_send_tx_internal(handle, handle->tx.data, pos);
 #if TINY_HDLC_DEBUG
-            for ( int i = 0; i < result; i++ )
+            for ( int i = 0; i < pos; i++ )
                 LOG(TINY_LOG_DEB, "[HDLC:%p] TX: %02X\n", handle, handle->tx.data[i]);
 #endif
-            handle->tx.data += result;
-            handle->tx.len -= result;
+            handle->tx.data += pos;
+            handle->tx.len -= pos;
+            result += pos;
         }
-    }
-    else
-    {
-        uint8_t buf[1] = {handle->tx.escape ? (handle->tx.data[0] ^ TINY_ESCAPE_BIT) : TINY_ESCAPE_CHAR};
-        result = hdlc_ll_send_tx_internal(handle, buf, sizeof(buf));
-        if ( result > 0 )
+        else
         {
+            // Put escape pair at once if possible, otherwise the second byte will be sent on next iteration
+            uint8_t buf[2] = {TINY_ESCAPE_CHAR, handle->tx.data[0] ^ TINY_ESCAPE_BIT};
+            int sent = hdlc_ll_send_tx_internal(handle, buf, sizeof(buf));
             LOG(TINY_LOG_DEB, "[HDLC:%p] TX: %02X\n", handle, buf[0]);
-            handle->tx.escape = !handle->tx.escape;
-            if ( !handle->tx.escape )
+            if ( sent == sizeof(buf) )
             {
+                LOG(TINY_LOG_DEB, "[HDLC:%p] TX: %02X\n", handle, buf[1]);
                 handle->tx.data++;
                 handle->tx.len--;
             }
+            else
+            {
+                handle->tx.escape = 1;
+            }
+            result += sent;
         }
     }
-    if ( handle->tx.len == 0 )
+    // Update crc over the bytes, which are completely sent by this call
+    handle->tx.crc = hdlc_ll_crc_update(handle->crc_type, handle->tx.crc, crc_ptr, (int)(handle->tx.data - crc_ptr));
+    if ( handle->tx.len == 0 && handle->tx.segment + 1 >= handle->tx.queue[handle->tx.queue_head].segment_count )
     {
         LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_ll_send_crc\n", handle);
+        handle->tx.crc = hdlc_ll_crc_final(handle->crc_type, handle->tx.crc);
         handle->tx.state = hdlc_ll_send_crc;
     }
     return result;
@@ -225,17 +586,123 @@ static int hdlc_ll_send_data(hdlc_ll_handle_t handle)
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Returns pointer to and size of the part of the frame for COBS encoder: segments of the frame
+ * are followed by crc field. Returns 0 if there is no part with such index.
+ */
+static inline int hdlc_ll_cobs_part(hdlc_ll_handle_t handle, uint8_t index, const uint8_t **data)
+{
+    const hdlc_ll_tx_frame_t *frame = &handle->tx.queue[handle->tx.queue_head];
+    if ( index < frame->segment_count )
+    {
+        *data = (const uint8_t *)frame->segments[index].data;
+        return frame->segments[index].len;
+    }
+    *data = handle->tx.crc_field;
+    return index == frame->segment_count ? hdlc_ll_crc_size(handle->crc_type) : 0;
+}
+
+/**
+ * Moves COBS encoder to the next non-empty part of the frame.
+ * tx.len remains 0 at the end of the frame.
+ */
+static void hdlc_ll_cobs_next_part(hdlc_ll_handle_t handle)
+{
+    uint8_t last = handle->tx.queue[handle->tx.queue_head].segment_count;
+    while ( handle->tx.len == 0 && handle->tx.segment < last )
+    {
+        handle->tx.len = hdlc_ll_cobs_part(handle, ++handle->tx.segment, &handle->tx.data);
+    }
+}
+
+/**
+ * Returns number of non-zero bytes ahead, up to COBS_MAX_BLOCK. zero is set if these bytes
+ * are followed by zero byte.
+ */
+static int hdlc_ll_cobs_scan(hdlc_ll_handle_t handle, uint8_t *zero)
+{
+    uint8_t last = handle->tx.queue[handle->tx.queue_head].segment_count;
+    uint8_t index = handle->tx.segment;
+    const uint8_t *data = handle->tx.data;
+    int len = handle->tx.len;
+    int run = 0;
+    while ( run < COBS_MAX_BLOCK && len > 0 )
+    {
+        int size = len < COBS_MAX_BLOCK - run ? len : COBS_MAX_BLOCK - run;
+        const uint8_t *pos = (const uint8_t *)memchr(data, COBS_DELIMITER, size);
+        if ( pos )
+        {
+            *zero = 1;
+            return run + (int)(pos - data);
+        }
+        run += size;
+        len = 0;
+        while ( len == 0 && index < last )
+        {
+            len = hdlc_ll_cobs_part(handle, ++index, &data);
+        }
+    }
+    *zero = 0;
+    return run;
+}
+
+static int hdlc_ll_send_cobs(hdlc_ll_handle_t handle)
+{
+    int result = 0;
+    while ( handle->tx.out_buffer_len > 0 )
+    {
+        if ( handle->tx.cobs_left )
+        {
+            // Data bytes of the block contain no zeros and are sent as is
+            int size = handle->tx.cobs_left < handle->tx.len ? handle->tx.cobs_left : handle->tx.len;
+            size = hdlc_ll_send_tx_internal(handle, handle->tx.data, size);
+            handle->tx.data += size;
+            handle->tx.len -= size;
+            handle->tx.cobs_left -= size;
+            result += size;
+            hdlc_ll_cobs_next_part(handle);
+            continue;
+        }
+        if ( handle->tx.cobs_zero == 1 )
+        {
+            // Zero byte after the block is encoded by the code byte of the block
+            handle->tx.data++;
+            handle->tx.len--;
+            handle->tx.cobs_zero = 2;
+            hdlc_ll_cobs_next_part(handle);
+        }
+        // Zero at the end of the frame requires one more empty block
+        if ( handle->tx.len == 0 && handle->tx.cobs_zero != 2 )
+        {
+            LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_ll_send_end\n", handle);
+            handle->tx.state = hdlc_ll_send_end;
+            break;
+        }
+        uint8_t zero;
+        int run = hdlc_ll_cobs_scan(handle, &zero);
+        uint8_t code = (uint8_t)(run + 1);
+        hdlc_ll_send_tx_internal(handle, &code, sizeof(code));
+        LOG(TINY_LOG_DEB, "[HDLC:%p] TX: %02X\n", handle, code);
+        handle->tx.cobs_left = (uint8_t)run;
+        handle->tx.cobs_zero = zero;
+        result++;
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 static int hdlc_ll_send_crc(hdlc_ll_handle_t handle)
 {
     int result = 1;
-    if ( handle->tx.len == (uint8_t)handle->crc_type )
+    if ( handle->tx.len == hdlc_ll_crc_size(handle->crc_type) * 8 )
     {
         handle->tx.state = hdlc_ll_send_end;
     }
     else
     {
         uint8_t byte = handle->tx.crc >> handle->tx.len;
-        if ( byte != TINY_ESCAPE_CHAR && byte != FLAG_SEQUENCE )
+        if ( !hdlc_ll_tx_escaped(handle, byte) )
         {
             result = hdlc_ll_send_tx_internal(handle, &byte, sizeof(byte));
             if ( result == 1 )
@@ -267,7 +734,7 @@ static int hdlc_ll_send_crc(hdlc_ll_handle_t handle)
 static int hdlc_ll_send_end(hdlc_ll_handle_t handle)
 {
     LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_ll_send_end\n", handle);
-    uint8_t buf[1] = {FLAG_SEQUENCE};
+    uint8_t buf[1] = {hdlc_ll_delimiter(handle)};
     int result = hdlc_ll_send_tx_internal(handle, buf, sizeof(buf));
     if ( result == 1 )
     {
@@ -275,10 +742,27 @@ static int hdlc_ll_send_end(hdlc_ll_handle_t handle)
         LOG(TINY_LOG_INFO, "[HDLC:%p] hdlc_ll_send_end HDLC send op successful\n", handle);
         handle->tx.state = hdlc_ll_send_start;
         handle->tx.escape = 0;
-        int len = (int)(handle->tx.data - handle->tx.origin_data);
+        int len = handle->tx.queue[handle->tx.queue_head].frame_len;
         const void *ptr = handle->tx.origin_data;
-        handle->tx.origin_data = NULL;
-        handle->tx.data = NULL;
+        handle->tx.queue_head = (handle->tx.queue_head + 1) % TINY_HDLC_TX_QUEUE_SIZE;
+        handle->tx.queue_count--;
+        if ( handle->tx.queue_count )
+        {
+            hdlc_ll_load_frame(handle);
+            // The closing flag is also the opening flag of the next frame (RFC 1662). The receiver
+            // skips fill bytes between the frames, so such frames still get their own opening flag.
+            // COBS frames never start with zero byte, so the delimiter is always shared.
+            if ( handle->framing == HDLC_FRAMING_COBS || handle->tx.data[0] != FILL_BYTE )
+            {
+                LOG(TINY_LOG_INFO, "[HDLC:%p] Starting send op for HDLC frame\n", handle);
+                hdlc_ll_begin_frame(handle);
+            }
+        }
+        else
+        {
+            handle->tx.origin_data = NULL;
+            handle->tx.data = NULL;
+        }
         if ( handle->on_frame_send )
         {
             handle->on_frame_send(handle->user_data, ptr, len);
@@ -289,18 +773,51 @@ static int hdlc_ll_send_end(hdlc_ll_handle_t handle)
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-static int hdlc_ll_send_tx_internal(hdlc_ll_handle_t handle, const void *data, int len)
+/**
+ * Aborts the frame being sent. HDLC abort sequence is escape followed by the flag. COBS has no
+ * abort sequence, so the delimiter is sent inside of the block: the receiver drops such frame
+ * as broken one. The delimiter is also the opening flag of the next frame in the queue.
+ */
+static int hdlc_ll_send_abort(hdlc_ll_handle_t handle)
 {
-    const uint8_t *ptr = (const uint8_t *)data;
-    int sent = 0;
-    while ( len-- && handle->tx.out_buffer_len )
+    uint8_t byte = hdlc_ll_delimiter(handle);
+    if ( handle->framing == HDLC_FRAMING_COBS && !handle->tx.cobs_left )
     {
-        handle->tx.out_buffer[0] = ptr[0];
-        handle->tx.out_buffer_len--;
-        handle->tx.out_buffer++;
-        ptr++;
-        sent++;
+        // Code byte promises the data, which never come
+        byte = 0xFF;
+    }
+    else if ( handle->framing != HDLC_FRAMING_COBS && !handle->tx.escape )
+    {
+        // If the frame is stopped in the middle of escape pair, its escape is reused
+        byte = TINY_ESCAPE_CHAR;
+    }
+    int result = hdlc_ll_send_tx_internal(handle, &byte, sizeof(byte));
+    if ( result == 1 )
+    {
+        LOG(TINY_LOG_DEB, "[HDLC:%p] TX: %02X\n", handle, byte);
+        if ( byte != hdlc_ll_delimiter(handle) )
+        {
+            // The delimiter goes next
+            handle->tx.escape = 1;
+            handle->tx.cobs_left = 1;
+        }
+        else
+        {
+            LOG(TINY_LOG_INFO, "[HDLC:%p] TX: frame is aborted\n", handle);
+            hdlc_ll_begin_frame(handle);
+        }
     }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static int hdlc_ll_send_tx_internal(hdlc_ll_handle_t handle, const void *data, int len)
+{
+    int sent = len < handle->tx.out_buffer_len ? len : handle->tx.out_buffer_len;
+    memcpy(handle->tx.out_buffer, data, sent);
+    handle->tx.out_buffer += sent;
+    handle->tx.out_buffer_len -= sent;
     return sent;
 }
 
@@ -356,108 +873,309 @@ int hdlc_ll_put(hdlc_ll_handle_t handle, const void *data, int len)
 
 int hdlc_ll_put_frame(hdlc_ll_handle_t handle, const void *data, int len)
 {
-    if ( !handle )
+    // NULL data is accepted as empty frame, nothing is sent in this case
+    hdlc_ll_segment_t segment = {data, data ? len : 0};
+    return hdlc_ll_put_frame_v(handle, &segment, 1);
+}
+
+/**
+ * Validates segments of the frame for tx queue. Returns size of the frame or TINY_ERR_INVALID_DATA.
+ */
+static int hdlc_ll_frame_len(hdlc_ll_handle_t handle, const hdlc_ll_segment_t *segments, int count)
+{
+    if ( !handle || count < 0 || count > TINY_HDLC_MAX_SEGMENTS || (count && !segments) )
     {
-        LOG(TINY_LOG_ERR, "[HDLC:%p] hdlc_ll_put invalid handle passed \n", handle);
+        LOG(TINY_LOG_ERR, "[HDLC:%p] hdlc_ll_put invalid arguments passed \n", handle);
         return TINY_ERR_INVALID_DATA;
     }
-    // Check if TX thread is ready to accept new data
-    if ( handle->tx.origin_data )
+    int frame_len = 0;
+    for ( int i = 0; i < count; i++ )
+    {
+        if ( segments[i].len < 0 || (segments[i].len && !segments[i].data) )
+        {
+            return TINY_ERR_INVALID_DATA;
+        }
+        frame_len += segments[i].len;
+    }
+    return frame_len;
+}
+
+/**
+ * Inserts the frame to tx queue at specified position from the queue head
+ */
+static void hdlc_ll_queue_insert(hdlc_ll_handle_t handle, uint8_t position, const hdlc_ll_segment_t *segments,
+                                 int count, int frame_len)
+{
+    for ( uint8_t i = handle->tx.queue_count; i > position; i-- )
+    {
+        handle->tx.queue[(handle->tx.queue_head + i) % TINY_HDLC_TX_QUEUE_SIZE] =
+            handle->tx.queue[(handle->tx.queue_head + i - 1) % TINY_HDLC_TX_QUEUE_SIZE];
+    }
+    hdlc_ll_tx_frame_t *frame = &handle->tx.queue[(handle->tx.queue_head + position) % TINY_HDLC_TX_QUEUE_SIZE];
+    memcpy(frame->segments, segments, count * sizeof(hdlc_ll_segment_t));
+    frame->segment_count = (uint8_t)count;
+    frame->frame_len = frame_len;
+    handle->tx.queue_count++;
+}
+
+int hdlc_ll_put_frame_v(hdlc_ll_handle_t handle, const hdlc_ll_segment_t *segments, int count)
+{
+    int frame_len = hdlc_ll_frame_len(handle, segments, count);
+    if ( frame_len < 0 )
+    {
+        return frame_len;
+    }
+    // Check if TX queue is ready to accept new data
+    if ( handle->tx.queue_count >= TINY_HDLC_TX_QUEUE_SIZE )
     {
         LOG(TINY_LOG_WRN, "[HDLC:%p] hdlc_ll_put FAILED\n", handle);
         return TINY_ERR_BUSY;
     }
-    if ( !len || !data )
+    if ( !frame_len )
     {
         return TINY_SUCCESS;
     }
     LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_ll_put SUCCESS\n", handle);
-    handle->tx.origin_data = data;
-    handle->tx.data = data;
-    handle->tx.len = len;
+    hdlc_ll_queue_insert(handle, handle->tx.queue_count, segments, count, frame_len);
+    if ( handle->tx.queue_count == 1 )
+    {
+        // TX is idle, the frame becomes current immediately
+        hdlc_ll_load_frame(handle);
+    }
+    return TINY_SUCCESS;
+}
+
+int hdlc_ll_preempt(hdlc_ll_handle_t handle, const hdlc_ll_segment_t *segments, int count)
+{
+    int frame_len = hdlc_ll_frame_len(handle, segments, count);
+    if ( frame_len < 0 )
+    {
+        return frame_len;
+    }
+    // The frame, which is sent except closing flag, cannot be preempted
+    if ( handle->tx.queue_count >= TINY_HDLC_TX_QUEUE_SIZE || handle->tx.state == hdlc_ll_send_end )
+    {
+        LOG(TINY_LOG_WRN, "[HDLC:%p] hdlc_ll_preempt FAILED\n", handle);
+        return TINY_ERR_BUSY;
+    }
+    if ( !frame_len )
+    {
+        return TINY_SUCCESS;
+    }
+    // Current frame remains in the queue and will be sent again from the beginning
+    bool abort = handle->tx.state != hdlc_ll_send_start && handle->tx.state != hdlc_ll_send_abort;
+    hdlc_ll_queue_insert(handle, 0, segments, count, frame_len);
+    hdlc_ll_load_frame(handle);
+    if ( abort )
+    {
+        LOG(TINY_LOG_INFO, "[HDLC:%p] Preempting current frame\n", handle);
+        handle->tx.state = hdlc_ll_send_abort;
+    }
     return TINY_SUCCESS;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Prepares rx for receiving new frame to the active frame buffer
+ */
+static inline void hdlc_ll_rx_begin_frame(hdlc_ll_handle_t handle)
+{
+    handle->rx.escape = 0;
+    handle->rx.cobs_left = 0;
+    handle->rx.cobs_zero = 0;
+    handle->rx.ptr = handle->rx.active_frame_buf;
+    handle->rx.crc = hdlc_ll_crc_init(handle->crc_type);
+    if ( handle->address_filter )
+    {
+        handle->rx.state = hdlc_ll_read_address;
+    }
+    else
+    {
+        handle->rx.state = handle->framing == HDLC_FRAMING_COBS ? hdlc_ll_read_cobs : hdlc_ll_read_data;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 static int hdlc_ll_read_start(hdlc_ll_handle_t handle, const uint8_t *data, int len)
 {
     if ( !len )
     {
         return 0;
     }
-    if ( data[0] != FLAG_SEQUENCE )
+    // All bytes before the delimiter are skipped at once, instead of one byte per state call
+    const uint8_t *delimiter = (const uint8_t *)memchr(data, hdlc_ll_delimiter(handle), len);
+    if ( !delimiter )
     {
-        if ( data[0] != FILL_BYTE )
-        {
-            // TODO: Skip byte, but we received some wrong data
-        }
-        return 1;
+        STATS(handle->stats.discarded_bytes += len);
+        return len;
     }
-    LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, data[0]);
-    handle->rx.escape = 0;
-    handle->rx.ptr = handle->rx.active_frame_buf;
-    handle->rx.state = hdlc_ll_read_data;
-    return 1;
+    int skipped = (int)(delimiter - data);
+    if ( skipped )
+    {
+        LOG(TINY_LOG_WRN, "[HDLC:%p] RX: skipped %i bytes before frame start\n", handle, skipped);
+        STATS(handle->stats.discarded_bytes += skipped);
+    }
+    LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, *delimiter);
+    hdlc_ll_rx_begin_frame(handle);
+    return skipped + 1;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 static int hdlc_ll_read_data(hdlc_ll_handle_t handle, const uint8_t *data, int len)
 {
+    // Local copies are used since the compiler cannot keep handle fields in registers while writing bytes
+    uint8_t *ptr = handle->rx.ptr;
+    uint8_t *end = handle->rx.active_frame_buf + handle->phys_mtu;
+    uint8_t escape = handle->rx.escape;
+    // Map of bytes, which are always escaped by the remote side, if they must be discarded
+    const uint8_t *rx_map = hdlc_ll_rx_map(handle);
+    // crc is updated over just stored bytes, while they are still in cache
+    uint8_t *crc_ptr = ptr;
     int result = 0;
-    while ( len > 0 )
+    while ( result < len )
     {
-        uint8_t byte = data[0];
-        LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, byte);
+        uint8_t byte = data[result];
         if ( byte == FLAG_SEQUENCE )
         {
-            handle->rx.state = hdlc_ll_read_end;
+            LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, byte);
             result++;
+            if ( escape )
+            {
+                // Abort sequence: the frame is dropped, and the flag opens the next frame
+                LOG(TINY_LOG_INFO, "[HDLC:%p] RX: frame is aborted by remote side\n", handle);
+                STATS(handle->stats.aborted_frames++);
+                hdlc_ll_rx_begin_frame(handle);
+                return result;
+            }
+            handle->rx.state = hdlc_ll_read_end;
             break;
         }
-        if ( byte == TINY_ESCAPE_CHAR )
+        if ( rx_map && byte != TINY_ESCAPE_CHAR && hdlc_scan_in_map(rx_map, byte) )
         {
-            handle->rx.escape = 1;
+            // The byte is not escaped by the remote side, so it is inserted by the line
+            LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X discarded\n", handle, byte);
+            result++;
+            continue;
         }
-        else if ( handle->rx.ptr - handle->rx.active_frame_buf < handle->phys_mtu )
+        if ( byte == TINY_ESCAPE_CHAR || escape )
         {
-            if ( handle->rx.escape )
+            // Only escape sequences go byte by byte
+            LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, byte);
+            if ( byte == TINY_ESCAPE_CHAR && result + 1 < len && data[result + 1] != FLAG_SEQUENCE &&
+                 data[result + 1] != TINY_ESCAPE_CHAR && !(rx_map && hdlc_scan_in_map(rx_map, data[result + 1])) &&
+                 ptr < end )
+            {
+                // Complete escape pair is available
+                LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, data[result + 1]);
+                *ptr++ = data[result + 1] ^ TINY_ESCAPE_BIT;
+                escape = 0;
+                result += 2;
+                continue;
+            }
+            if ( byte == TINY_ESCAPE_CHAR )
             {
-                *handle->rx.ptr = byte ^ TINY_ESCAPE_BIT;
-                handle->rx.escape = 0;
+                escape = 1;
+            }
+            else if ( ptr < end )
+            {
+                *ptr++ = byte ^ TINY_ESCAPE_BIT;
+                escape = 0;
             }
             else
             {
-                *handle->rx.ptr = byte;
+                LOG(TINY_LOG_WRN, "[HDLC:%p] No space for incoming byte: len=%i (mtu = %i)\n", handle,
+                    (int)(ptr - handle->rx.active_frame_buf), handle->phys_mtu);
             }
-            handle->rx.ptr++;
+            result++;
+            continue;
         }
-        else
+        // All clean bytes up to the next special character are copied at once
+        int run = rx_map ? hdlc_scan_map(data + result, len - result, rx_map)
+                         : hdlc_scan_special(data + result, len - result);
+        int size = run < (int)(end - ptr) ? run : (int)(end - ptr);
+        if ( size > 0 )
         {
-            LOG(TINY_LOG_WRN, "[HDLC:%p] No space for incoming byte: len=%i (mtu = %i)\n",
-                              handle, (int)(handle->rx.ptr - handle->rx.active_frame_buf), handle->phys_mtu);
+#if TINY_HDLC_DEBUG
+            for ( int i = 0; i < size; i++ )
+                LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, data[result + i]);
+#endif
+            memcpy(ptr, data + result, size);
+            ptr += size;
+            if ( ptr - crc_ptr >= HDLC_RX_CRC_BLOCK )
+            {
+                handle->rx.crc = hdlc_ll_crc_update(handle->crc_type, handle->rx.crc, crc_ptr, (int)(ptr - crc_ptr));
+                crc_ptr = ptr;
+            }
         }
-        result++;
-        data++;
-        len--;
+        if ( size < run )
+        {
+            LOG(TINY_LOG_WRN, "[HDLC:%p] No space for incoming byte: len=%i (mtu = %i)\n", handle,
+                (int)(ptr - handle->rx.active_frame_buf), handle->phys_mtu);
+        }
+        result += run;
     }
+    handle->rx.crc = hdlc_ll_crc_update(handle->crc_type, handle->rx.crc, crc_ptr, (int)(ptr - crc_ptr));
+    handle->rx.ptr = ptr;
+    handle->rx.escape = escape;
     return result;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Returns index of RX slot, containing the byte, or -1 if the byte is out of RX slots.
+ */
+static inline int hdlc_ll_rx_slot(hdlc_ll_handle_t handle, const uint8_t *ptr)
+{
+    if ( ptr < handle->rx_buf || ptr >= handle->rx_buf + handle->rx_buf_size - handle->rx_buf_size % handle->phys_mtu )
+    {
+        return -1;
+    }
+    return (int)(ptr - handle->rx_buf) / handle->phys_mtu;
+}
+
+static inline bool hdlc_ll_rx_slot_loaned(hdlc_ll_handle_t handle, int slot)
+{
+    return slot >= 0 && slot < TINY_HDLC_RX_LOAN_SLOTS && handle->rx.loaned[slot];
+}
+
+/**
+ * Moves active frame buffer to the next RX slot, which is not on loan.
+ * hdlc_ll_loan_frame() never loans the last free slot, so such slot always exists.
+ */
+static void hdlc_ll_next_rx_slot(hdlc_ll_handle_t handle)
+{
+    do
+    {
+        handle->rx.active_frame_buf += handle->phys_mtu;
+        if ( handle->rx.active_frame_buf - handle->rx_buf + handle->phys_mtu > handle->rx_buf_size )
+        {
+            handle->rx.active_frame_buf = handle->rx_buf;
+        }
+    } while ( hdlc_ll_rx_slot_loaned(handle, hdlc_ll_rx_slot(handle, handle->rx.active_frame_buf)) );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 static int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int len_bytes)
 {
     if ( handle->rx.ptr == handle->rx.active_frame_buf )
     {
         // Impossible, maybe frame alignment is wrong, go to read data again
         LOG(TINY_LOG_WRN, "[HDLC:%p] RX: error in frame alignment, recovering...\n", handle);
-        handle->rx.escape = 0;
-        handle->rx.state = hdlc_ll_read_data;
+        hdlc_ll_rx_begin_frame(handle);
         return 0; // That's OK, we actually didn't process anything from user bytes
     }
-    handle->rx.state = hdlc_ll_read_start;
+    handle->rx.state = hdlc_ll_read_idle;
+    if ( handle->rx.cobs_left )
+    {
+        // COBS block is cut by the delimiter, the frame is broken like in case of wrong crc
+        LOG(TINY_LOG_ERR, "[HDLC:%p] RX: incomplete COBS block\n", handle);
+        return TINY_ERR_WRONG_CRC;
+    }
     int len = (int)(handle->rx.ptr - handle->rx.active_frame_buf);
     if ( len > handle->phys_mtu )
     {
@@ -465,42 +1183,19 @@ static int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int le
         LOG(TINY_LOG_ERR, "[HDLC:%p] RX: tool long frame\n", handle);
         return TINY_ERR_DATA_TOO_LARGE;
     }
-    if ( len < (uint8_t)handle->crc_type / 8 )
+    int crc_size = hdlc_ll_crc_size(handle->crc_type);
+    if ( len < crc_size )
     {
         // CRC size issue
         LOG(TINY_LOG_ERR, "[HDLC:%p] RX: crc field is too short\n", handle);
         return TINY_ERR_WRONG_CRC;
     }
-    crc_t calc_crc = 0;
-    crc_t read_crc = 0;
-    switch ( handle->crc_type )
-    {
-#ifdef CONFIG_ENABLE_CHECKSUM
-        case HDLC_CRC_8:
-            calc_crc = tiny_chksum(INITCHECKSUM, handle->rx.active_frame_buf, len - 1) & 0x00FF;
-            read_crc = handle->rx.ptr[-1];
-            break;
-#endif
-#ifdef CONFIG_ENABLE_FCS16
-        case HDLC_CRC_16:
-            calc_crc = tiny_crc16(PPPINITFCS16, handle->rx.active_frame_buf, len - 2);
-            read_crc = handle->rx.ptr[-2] | ((uint16_t)handle->rx.ptr[-1] << 8);
-            break;
-#endif
-#ifdef CONFIG_ENABLE_FCS32
-        case HDLC_CRC_32:
-            calc_crc = tiny_crc32(PPPINITFCS32, handle->rx.active_frame_buf, len - 4);
-            read_crc = handle->rx.ptr[-4] | ((uint32_t)handle->rx.ptr[-3] << 8) |
-                       ((uint32_t)handle->rx.ptr[-2] << 16) | ((uint32_t)handle->rx.ptr[-1] << 24);
-            break;
-#endif
-        default: break;
-    }
-    if ( calc_crc != read_crc )
+    // crc is already calculated while receiving the frame, so only the residue needs to be checked
+    if ( !hdlc_ll_crc_is_good(handle->crc_type, handle->rx.crc) )
     {
 // CRC calculate issue
 #if TINY_HDLC_DEBUG
-        LOG(TINY_LOG_ERR, "[HDLC:%p] RX: WRONG CRC (calc:%08X != %08X)\n", handle, calc_crc, read_crc);
+        LOG(TINY_LOG_ERR, "[HDLC:%p] RX: WRONG CRC (residue:%08X)\n", handle, handle->rx.crc);
         if ( TINY_LOG_DEB < g_tiny_log_level )
             for ( int i = 0; i < len; i++ )
                 fprintf(stderr, " %c ", (char)(handle->rx.active_frame_buf)[i]);
@@ -513,17 +1208,257 @@ static int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int le
         return TINY_ERR_WRONG_CRC;
     }
     // Shift back data pointer, pointing to the last byte after payload
-    len -= (uint8_t)handle->crc_type / 8;
+    len -= crc_size;
     LOG(TINY_LOG_INFO, "[HDLC:%p] RX: Frame success: %d bytes\n", handle, len);
     if ( handle->on_frame_read )
     {
         handle->on_frame_read(handle->user_data, handle->rx.active_frame_buf, len);
     }
-    handle->rx.active_frame_buf += handle->phys_mtu;
-    if ( handle->rx.active_frame_buf - handle->rx_buf + handle->phys_mtu > handle->rx_buf_size )
+    hdlc_ll_next_rx_slot(handle);
+    return TINY_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Waits for the next frame after the closing flag. The closing flag can be also the opening
+ * flag of the next frame (RFC 1662), so any byte except fill byte starts new frame here.
+ * Block transports pad each block with fill bytes, so the whole run is skipped at once.
+ */
+static int hdlc_ll_read_idle(hdlc_ll_handle_t handle, const uint8_t *data, int len)
+{
+    if ( !len )
+    {
+        return 0;
+    }
+    const uint8_t fill = hdlc_ll_fill_byte(handle);
+    if ( data[0] == fill )
+    {
+        int run = 1;
+        while ( run < len && data[run] == fill )
+        {
+            run++;
+        }
+        return run;
+    }
+    hdlc_ll_rx_begin_frame(handle);
+    if ( data[0] == hdlc_ll_delimiter(handle) )
+    {
+        LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, data[0]);
+        return 1;
+    }
+    return handle->rx.state(handle, data, len);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static int hdlc_ll_read_cobs(hdlc_ll_handle_t handle, const uint8_t *data, int len)
+{
+    uint8_t *ptr = handle->rx.ptr;
+    uint8_t *end = handle->rx.active_frame_buf + handle->phys_mtu;
+    uint8_t left = handle->rx.cobs_left;
+    // crc is updated over just stored bytes, while they are still in cache
+    uint8_t *crc_ptr = ptr;
+    int result = 0;
+    while ( result < len )
+    {
+        if ( data[result] == COBS_DELIMITER )
+        {
+            LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, data[result]);
+            handle->rx.state = hdlc_ll_read_end;
+            result++;
+            break;
+        }
+        if ( !left )
+        {
+            // Code byte. Zero after the previous block is stored only now, since the last block has no zero
+            LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, data[result]);
+            if ( handle->rx.cobs_zero )
+            {
+                if ( ptr < end )
+                {
+                    *ptr++ = 0;
+                }
+                else
+                {
+                    LOG(TINY_LOG_WRN, "[HDLC:%p] No space for incoming byte: len=%i (mtu = %i)\n", handle,
+                        (int)(ptr - handle->rx.active_frame_buf), handle->phys_mtu);
+                }
+            }
+            left = data[result] - 1;
+            handle->rx.cobs_zero = data[result] != 0xFF;
+            result++;
+            continue;
+        }
+        // Data bytes of the block are copied at once up to the next delimiter
+        int run = left < len - result ? left : len - result;
+        const uint8_t *delimiter = (const uint8_t *)memchr(data + result, COBS_DELIMITER, run);
+        if ( delimiter )
+        {
+            run = (int)(delimiter - (data + result));
+        }
+        int size = run < (int)(end - ptr) ? run : (int)(end - ptr);
+        if ( size > 0 )
+        {
+#if TINY_HDLC_DEBUG
+            for ( int i = 0; i < size; i++ )
+                LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, data[result + i]);
+#endif
+            memcpy(ptr, data + result, size);
+            ptr += size;
+            if ( ptr - crc_ptr >= HDLC_RX_CRC_BLOCK )
+            {
+                handle->rx.crc = hdlc_ll_crc_update(handle->crc_type, handle->rx.crc, crc_ptr, (int)(ptr - crc_ptr));
+                crc_ptr = ptr;
+            }
+        }
+        if ( size < run )
+        {
+            LOG(TINY_LOG_WRN, "[HDLC:%p] No space for incoming byte: len=%i (mtu = %i)\n", handle,
+                (int)(ptr - handle->rx.active_frame_buf), handle->phys_mtu);
+        }
+        left -= run;
+        result += run;
+    }
+    handle->rx.crc = hdlc_ll_crc_update(handle->crc_type, handle->rx.crc, crc_ptr, (int)(ptr - crc_ptr));
+    handle->rx.ptr = ptr;
+    handle->rx.cobs_left = left;
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Looks at the first byte of the frame and passes the frame to the decoder or skips it depending
+ * on address filter. Only the prefix of the encoded address (escape or COBS code byte) can be
+ * consumed here, and the decoder continues from the same state. If the first byte is not a valid
+ * address (empty frame, discarded byte), the frame goes to the decoder.
+ */
+static int hdlc_ll_read_address(hdlc_ll_handle_t handle, const uint8_t *data, int len)
+{
+    if ( !len )
+    {
+        return 0;
+    }
+    int address = -1;
+    if ( handle->framing == HDLC_FRAMING_COBS )
+    {
+        if ( handle->rx.cobs_left )
+        {
+            address = data[0] != COBS_DELIMITER ? data[0] : -1;
+        }
+        else if ( data[0] == 0x01 )
+        {
+            // Code byte 0x01 means that the frame starts with zero byte
+            address = 0x00;
+        }
+        else if ( data[0] != COBS_DELIMITER && len < 2 )
+        {
+            // Code byte is consumed, the address comes with the next data
+            handle->rx.cobs_left = data[0] - 1;
+            handle->rx.cobs_zero = data[0] != 0xFF;
+            return 1;
+        }
+        else if ( data[0] != COBS_DELIMITER && data[1] != COBS_DELIMITER )
+        {
+            address = data[1];
+        }
+    }
+    else
+    {
+        const uint8_t *rx_map = hdlc_ll_rx_map(handle);
+        uint8_t escape = handle->rx.escape;
+        int pos = 0;
+        if ( !escape && data[0] == TINY_ESCAPE_CHAR )
+        {
+            if ( len < 2 )
+            {
+                // Escape is consumed, the address comes with the next data
+                handle->rx.escape = 1;
+                return 1;
+            }
+            escape = 1;
+            pos = 1;
+        }
+        uint8_t byte = data[pos];
+        if ( byte != FLAG_SEQUENCE && !(escape && byte == TINY_ESCAPE_CHAR) &&
+             !(rx_map && byte != TINY_ESCAPE_CHAR && hdlc_scan_in_map(rx_map, byte)) )
+        {
+            address = escape ? byte ^ TINY_ESCAPE_BIT : byte;
+        }
+    }
+    if ( address >= 0 && !handle->address_filter(handle->user_data, (uint8_t)address) )
+    {
+        LOG(TINY_LOG_DEB, "[HDLC:%p] RX: skipping frame for address %02X\n", handle, address);
+        STATS(handle->stats.filtered_frames++);
+        handle->rx.state = hdlc_ll_read_skip;
+    }
+    else
+    {
+        handle->rx.state = handle->framing == HDLC_FRAMING_COBS ? hdlc_ll_read_cobs : hdlc_ll_read_data;
+    }
+    return handle->rx.state(handle, data, len);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Skips the frame, rejected by address filter, up to the next delimiter
+ */
+static int hdlc_ll_read_skip(hdlc_ll_handle_t handle, const uint8_t *data, int len)
+{
+    const uint8_t *delimiter = (const uint8_t *)memchr(data, hdlc_ll_delimiter(handle), len);
+    if ( !delimiter )
     {
-        handle->rx.active_frame_buf = handle->rx_buf;
+        return len;
+    }
+    // The delimiter closes skipped frame, and it can be also the opening flag of the next frame
+    handle->rx.state = hdlc_ll_read_idle;
+    return (int)(delimiter - data) + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int hdlc_ll_loan_frame(hdlc_ll_handle_t handle, const void *data)
+{
+    int slot = handle ? hdlc_ll_rx_slot(handle, (const uint8_t *)data) : -1;
+    if ( slot < 0 )
+    {
+        return TINY_ERR_INVALID_DATA;
     }
+    if ( slot >= TINY_HDLC_RX_LOAN_SLOTS )
+    {
+        return TINY_ERR_OUT_OF_MEMORY;
+    }
+    if ( handle->rx.loaned[slot] )
+    {
+        return TINY_SUCCESS;
+    }
+    // Keep at least one slot free, otherwise the decoder has no place for new frames
+    int free_slots = handle->rx_buf_size / handle->phys_mtu;
+    for ( int i = 0; i < TINY_HDLC_RX_LOAN_SLOTS; i++ )
+    {
+        free_slots -= handle->rx.loaned[i] ? 1 : 0;
+    }
+    if ( free_slots <= 1 )
+    {
+        LOG(TINY_LOG_WRN, "[HDLC:%p] RX: no free slots to loan the frame\n", handle);
+        return TINY_ERR_OUT_OF_MEMORY;
+    }
+    handle->rx.loaned[slot] = 1;
+    return TINY_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int hdlc_ll_release_frame(hdlc_ll_handle_t handle, const void *data)
+{
+    int slot = handle ? hdlc_ll_rx_slot(handle, (const uint8_t *)data) : -1;
+    if ( !hdlc_ll_rx_slot_loaned(handle, slot) )
+    {
+        return TINY_ERR_INVALID_DATA;
+    }
+    handle->rx.loaned[slot] = 0;
     return TINY_SUCCESS;
 }
 
@@ -556,6 +1491,25 @@ int hdlc_ll_run_rx(hdlc_ll_handle_t handle, const void *data, int len, int *erro
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+int hdlc_ll_run_rx_ring(hdlc_ll_handle_t handle, const void *base, int size, int head, int tail, int *error)
+{
+    if ( !base || size <= 0 || head < 0 || head >= size || tail < 0 || tail >= size )
+    {
+        if ( error )
+        {
+            *error = TINY_ERR_INVALID_DATA;
+        }
+        return tail;
+    }
+    // Wrapped data are processed as two linear parts: up to the end of the buffer, and then from its start.
+    // The second part is processed by the next call, so the error of the frame in the first part is not lost.
+    int len = (head >= tail ? head : size) - tail;
+    tail += hdlc_ll_run_rx(handle, (const uint8_t *)base + tail, len, error);
+    return tail == size ? 0 : tail;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 int hdlc_ll_get_buf_size(int mtu)
 {
     // TINY_ALIGN_STRUCT_VALUE is added to satisfy alignment requirements
@@ -40,6 +40,38 @@ extern "C"
 /** Byte to fill gap between frames */
 #define TINY_HDLC_FILL_BYTE 0xFF
 
+/** Maximum number of segments, accepted by hdlc_ll_put_frame_v() */
+#ifndef TINY_HDLC_MAX_SEGMENTS
+#define TINY_HDLC_MAX_SEGMENTS 3
+#endif
+
+/** Maximum number of RX slots, which can be loaned to the application by hdlc_ll_loan_frame() */
+#ifndef TINY_HDLC_RX_LOAN_SLOTS
+#define TINY_HDLC_RX_LOAN_SLOTS 8
+#endif
+
+/**
+ * Number of frames, which can be queued to hdlc_ll for sending. Each slot costs
+ * TINY_HDLC_MAX_SEGMENTS segment descriptors in every handle. hdlc_ll_preempt() needs at
+ * least 2 slots: hosts, which need urgent frames, should define it to 2 or more.
+ * With 2 or more slots back to back frames share single flag. Older hdlc receivers wait
+ * for new opening flag after each frame and drop every second such frame, so both ends
+ * need the new decoder.
+ */
+#ifndef TINY_HDLC_TX_QUEUE_SIZE
+#define TINY_HDLC_TX_QUEUE_SIZE 1
+#endif
+
+/**
+ * Size of async control character map in bytes: one bit for each byte value.
+ * The map is kept in hdlc handle only if CONFIG_ENABLE_ACCM is defined, otherwise hdlc level
+ * escapes 0x7E and 0x7D only.
+ */
+#define HDLC_ACCM_SIZE 32
+
+/** Adds byte value to async control character map */
+#define HDLC_ACCM_ADD(accm, byte) ((accm)[(uint8_t)(byte) >> 3] |= (uint8_t)(1 << ((uint8_t)(byte) & 0x07)))
+
     /**
      * @defgroup HDLC_LOW_LEVEL_API HDLC low level protocol API
      * @{
@@ -62,8 +94,63 @@ extern "C"
         HDLC_LL_RESET_RX_ONLY = 0x02,
     } hdlc_ll_reset_flags_t;
 
+    /**
+     * Flags for hdlc_ll_set_accm function
+     */
+    typedef enum
+    {
+        /** Bytes from the map are escaped when sent */
+        HDLC_ACCM_TX = 0x01,
+        /** Bytes from the map, received without escape char, are discarded (RFC 1662, 7.1) */
+        HDLC_ACCM_RX = 0x02,
+    } hdlc_accm_flags_t;
+
+    /**
+     * Framing types for hdlc_ll_init_t
+     */
+    typedef enum
+    {
+        /** Byte stuffing according to RFC 1662: 0x7E flags, 0x7D escape char. Up to 2x expansion. */
+        HDLC_FRAMING_HDLC = 0,
+        /** Consistent Overhead Byte Stuffing: 0x00 delimiters, 1 extra byte per up to 254 bytes. */
+        HDLC_FRAMING_COBS = 1,
+    } hdlc_framing_t;
+
+    /**
+     * Statistics of hdlc low level receiver, refer to hdlc_ll_get_stats()
+     */
+    typedef struct
+    {
+        /** Number of bytes, skipped while searching for the frame start after init or reset */
+        uint32_t discarded_bytes;
+        /** Number of frames, skipped because address filter rejected them */
+        uint32_t filtered_frames;
+        /** Number of frames, aborted by the remote side with abort sequence */
+        uint32_t aborted_frames;
+    } hdlc_ll_stats_t;
+
+    /**
+     * Address filter callback. It is called with the first byte of each received frame, and
+     * returns false if the frame is not for the local station.
+     * @param udata user data
+     * @param address first byte of the frame
+     * @return true to receive the frame, false to skip it up to the next frame
+     */
+    typedef bool (*hdlc_ll_address_filter_cb_t)(void *udata, uint8_t address);
+
     struct hdlc_ll_data_t;
 
+    /**
+     * Describes single part of the frame for hdlc_ll_put_frame_v()
+     */
+    typedef struct
+    {
+        /** pointer to segment data */
+        const void *data;
+        /** size of segment data in bytes, can be 0 */
+        int len;
+    } hdlc_ll_segment_t;
+
     /** Handle for HDLC low level protocol */
     typedef struct hdlc_ll_data_t *hdlc_ll_handle_t;
 
@@ -118,6 +205,32 @@ extern "C"
 
         /** mtu size, can be 0 */
         int mtu;
+
+        /**
+         * Async control character map (RFC 1662) of HDLC_ACCM_SIZE bytes: bit N of byte N / 8 set
+         * means that byte value N is escaped when sent. 0x7E and 0x7D are always escaped.
+         * Can be NULL, in this case only 0x7E and 0x7D are escaped. Refer to hdlc_ll_set_accm().
+         */
+        const uint8_t *accm;
+
+        /**
+         * Combination of hdlc_accm_flags_t flags for accm map. If 0, HDLC_ACCM_TX is used.
+         */
+        uint8_t accm_flags;
+
+        /**
+         * Framing to use: HDLC_FRAMING_HDLC (default) or HDLC_FRAMING_COBS. Both stations must use
+         * the same framing. Crc field, tx queue and rx window work in the same way for both.
+         * Async control character map is not used with COBS framing, which never sends 0x00 inside the frame.
+         */
+        hdlc_framing_t framing;
+
+        /**
+         * Address filter, can be NULL. Frames, rejected by the filter, are not stored, not decoded and
+         * crc of them is not calculated: the receiver just searches for the next frame delimiter.
+         * This saves CPU on multidrop buses, where most of frames are for other stations.
+         */
+        hdlc_ll_address_filter_cb_t address_filter;
     } hdlc_ll_init_t;
 
     //------------------------ GENERIC FUNCIONS ------------------------------
@@ -148,6 +261,46 @@ extern "C"
      */
     void hdlc_ll_reset(hdlc_ll_handle_t handle, uint8_t flags);
 
+    /**
+     * Sets async control character map (RFC 1662). Bytes from the map are sent as escape
+     * pairs, so they never appear on the line as is. This is required for the links, which
+     * use some control characters for their own purposes (XON/XOFF, modem commands, etc.).
+     * Bytes 0x7E and 0x7D are always escaped regardless of the map. Without extra bytes in
+     * the map hdlc level uses vectorized scanning for special characters, and a map with extra
+     * bytes is scanned byte by byte.
+     *
+     * TX map can be changed at any time: the receiver decodes both plain bytes and escape pairs.
+     * Enable HDLC_ACCM_RX only when the remote side already escapes all bytes of the map,
+     * otherwise such bytes are lost and the frames are dropped due to wrong crc.
+     *
+     * @param handle hdlc handle
+     * @param accm pointer to HDLC_ACCM_SIZE bytes of the map or NULL to escape 0x7E and 0x7D only
+     * @param flags combination of HDLC_ACCM_TX and HDLC_ACCM_RX
+     * @return TINY_SUCCESS or TINY_ERR_INVALID_DATA if handle is NULL or the map contains both
+     *         byte X and X^0x20 (escaped X cannot be told from the inserted byte),
+     *         TINY_ERR_FAILED if the map has extra bytes, but CONFIG_ENABLE_ACCM is not defined
+     */
+    int hdlc_ll_set_accm(hdlc_ll_handle_t handle, const uint8_t *accm, uint8_t flags);
+
+    /**
+     * Returns receiver statistics. Counters are collected only if the library is built with
+     * CONFIG_ENABLE_STATS, otherwise all counters are zero.
+     *
+     * @param handle hdlc handle
+     * @param stats pointer to the structure to fill
+     */
+    void hdlc_ll_get_stats(hdlc_ll_handle_t handle, hdlc_ll_stats_t *stats);
+
+    /**
+     * Returns byte, which must be used to fill the line between the frames, for example, to pad
+     * blocks of fixed-size transports. The receiver skips runs of such bytes between the frames.
+     * This is TINY_HDLC_FILL_BYTE for HDLC framing, and delimiter 0x00 for COBS framing.
+     *
+     * @param handle hdlc handle
+     * @return fill byte
+     */
+    uint8_t hdlc_ll_get_fill_byte(hdlc_ll_handle_t handle);
+
     //------------------------ RX FUNCIONS ------------------------------
 
     /**
@@ -181,6 +334,52 @@ extern "C"
      */
     int hdlc_ll_run_rx(hdlc_ll_handle_t handle, const void *data, int len, int *error);
 
+    /**
+     * Processes incoming data directly from the circular buffer, for example, the buffer of
+     * DMA in circular mode. Bytes from tail up to head are decoded in place, so no staging copy
+     * is needed. Like hdlc_ll_run_rx() the function returns after each received frame, and it
+     * also returns when tail wraps to the start of the buffer, so call it again while returned
+     * tail is not equal to head.
+     *
+     * @param handle hdlc handle
+     * @param base pointer to the circular buffer
+     * @param size size of the circular buffer in bytes
+     * @param head producer index: offset of the byte, which will be written next by the producer
+     * @param tail consumer index: offset of the first not processed byte
+     * @param error pointer to store error code, the same codes as for hdlc_ll_run_rx().
+     *        TINY_ERR_INVALID_DATA is returned if ring parameters are invalid.
+     *        This argument can be NULL.
+     * @return new tail value
+     */
+    int hdlc_ll_run_rx_ring(hdlc_ll_handle_t handle, const void *base, int size, int head, int tail, int *error);
+
+    /**
+     * Loans received frame to the application. Frame data are valid only until on_frame_read
+     * callback returns, but loaned frame remains valid until hdlc_ll_release_frame() is called:
+     * hdlc level doesn't receive new frames to the RX slot while it is on loan.
+     * The function can be called only from on_frame_read callback. At least one RX slot must
+     * remain free for receiving, so the number of frames on loan is limited by RX window size - 1
+     * and TINY_HDLC_RX_LOAN_SLOTS.
+     *
+     * @param handle hdlc handle
+     * @param data pointer to the frame data, passed to on_frame_read callback
+     * @return TINY_SUCCESS if the frame is loaned
+     *         TINY_ERR_INVALID_DATA if data doesn't point to hdlc RX buffer
+     *         TINY_ERR_OUT_OF_MEMORY if no free RX slots remain for receiving new frames
+     */
+    int hdlc_ll_loan_frame(hdlc_ll_handle_t handle, const void *data);
+
+    /**
+     * Returns loaned frame back to hdlc level. hdlc level has no locks: the function must be
+     * called from the thread, running hdlc_ll_run_rx(), or the caller must serialize the calls.
+     *
+     * @param handle hdlc handle
+     * @param data pointer to the frame data, passed to hdlc_ll_loan_frame()
+     * @return TINY_SUCCESS if the frame is released
+     *         TINY_ERR_INVALID_DATA if data doesn't point to loaned frame
+     */
+    int hdlc_ll_release_frame(hdlc_ll_handle_t handle, const void *data);
+
     //------------------------ TX FUNCIONS ------------------------------
 
     /**
@@ -206,7 +405,7 @@ extern "C"
      * @param handle hdlc handle
      * @param data pointer to new data to send
      * @param len size of data to send in bytes
-     * @return TINY_ERR_BUSY if TX queue is busy with another frame.
+     * @return TINY_ERR_BUSY if TX queue is full.
      *         TINY_ERR_INVALID_DATA if len is zero.
      *         TINY_SUCCESS if data is successfully sent
      * @warning buffer with data must be available all the time until
@@ -227,10 +426,14 @@ extern "C"
      * hdlc state machine. In this case, some other thread needs to
      * or in the same thread you need to send data using hdlc_ll_run_tx().
      *
+     * Up to TINY_HDLC_TX_QUEUE_SIZE frames can be queued. The frames are sent back to back,
+     * and the closing flag of the frame is used as opening flag of the next one (RFC 1662).
+     * Older hdlc receivers drop the frames with shared flag, see TINY_HDLC_TX_QUEUE_SIZE.
+     *
      * @param handle hdlc handle
      * @param data pointer to new data to send
      * @param len size of data to send in bytes
-     * @return TINY_ERR_BUSY if TX queue is busy with another frame.
+     * @return TINY_ERR_BUSY if TX queue is full.
      *         TINY_ERR_INVALID_DATA if len is zero.
      *         TINY_SUCCESS if data is successfully sent
      * @warning buffer with data must be available all the time until
@@ -244,6 +447,47 @@ extern "C"
      */
     int hdlc_ll_put_frame(hdlc_ll_handle_t handle, const void *data, int len);
 
+    /**
+     * Puts next frame for sending. The frame is combined from several segments,
+     * located in different memory areas, which are sent and checksummed as single frame
+     * without copying them to one buffer.
+     *
+     * The segments array is copied to hdlc handle, so it can be a local variable, but
+     * data of all segments must be available until on_frame_send callback is called.
+     * on_frame_send callback receives pointer to the first non-empty segment and total
+     * length of the frame.
+     *
+     * @param handle hdlc handle
+     * @param segments array of segments
+     * @param count number of segments, up to TINY_HDLC_MAX_SEGMENTS
+     * @return TINY_ERR_BUSY if TX queue is full.
+     *         TINY_ERR_INVALID_DATA if count exceeds TINY_HDLC_MAX_SEGMENTS or segments are invalid.
+     *         TINY_SUCCESS if data is successfully sent
+     */
+    int hdlc_ll_put_frame_v(hdlc_ll_handle_t handle, const hdlc_ll_segment_t *segments, int count);
+
+    /**
+     * Puts urgent frame to the head of TX queue. If other frame is being sent, it is aborted
+     * with abort sequence (0x7D 0x7E), and it is sent again from the beginning after the urgent
+     * frame, so latency of the urgent frame doesn't depend on the size of other frames.
+     * The receiver drops aborted frames silently. COBS framing has no abort sequence, so
+     * the aborted frame is cut by the delimiter, and the receiver drops it as broken frame.
+     * Segments must remain valid until on_frame_send callback is called for the frame.
+     * The callback is never called for aborted attempt of the frame.
+     *
+     * @param handle hdlc handle
+     * @param segments array of segments
+     * @param count number of segments, up to TINY_HDLC_MAX_SEGMENTS
+     * @note Preemption requires TINY_HDLC_TX_QUEUE_SIZE to be 2 or more. With the default
+     *       single slot queue the function returns TINY_ERR_BUSY while any frame is being sent.
+     *
+     * @return TINY_ERR_BUSY if TX queue is full, or current frame is already sent except
+     *         closing flag: put the frame with hdlc_ll_put_frame_v() in this case.
+     *         TINY_ERR_INVALID_DATA if count exceeds TINY_HDLC_MAX_SEGMENTS or segments are invalid.
+     *         TINY_SUCCESS if the frame is put before current frame
+     */
+    int hdlc_ll_preempt(hdlc_ll_handle_t handle, const hdlc_ll_segment_t *segments, int count);
+
     /**
      * Returns minimum buffer size, required to hold hdlc low level data for desired payload size.
      *
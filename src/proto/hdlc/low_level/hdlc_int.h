@@ -29,6 +29,7 @@
 
 #include "hal/tiny_types.h"
 #include "proto/crc/tiny_crc.h"
+#include "proto/hdlc/low_level/hdlc.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -57,6 +58,17 @@ extern "C"
  */
 #define HDLC_BUF_SIZE_EX(mtu, crc, window) (sizeof(hdlc_ll_data_t) + ((int)(crc) / 8 + (mtu)) * (window) + TINY_ALIGN_STRUCT_VALUE - 1)
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    /** Frame, waiting in tx queue */
+    typedef struct
+    {
+        hdlc_ll_segment_t segments[TINY_HDLC_MAX_SEGMENTS];
+        // total length of the frame
+        int frame_len;
+        uint8_t segment_count;
+    } hdlc_ll_tx_frame_t;
+#endif
+
     /**
      * Structure describes configuration of lowest HDLC level
      * Initialize this structure by 0 before passing to hdlc_ll_init()
@@ -104,17 +116,39 @@ extern "C"
         /** User data, which will be passed to user-defined callback as first argument */
         void *user_data;
 
+        /** Address filter callback, can be NULL */
+        hdlc_ll_address_filter_cb_t address_filter;
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
         /** Parameters in DOXYGEN_SHOULD_SKIP_THIS section should not be modified by a user */
         int phys_mtu;
+#ifdef CONFIG_ENABLE_ACCM
+        // async control character map, 0x7E and 0x7D are always in the map
+        uint8_t accm[HDLC_ACCM_SIZE];
+        // HDLC_ACCM_TX and HDLC_ACCM_RX flags, set only if the map has bytes except 0x7E and 0x7D
+        uint8_t accm_flags;
+#endif
+        // HDLC_FRAMING_HDLC or HDLC_FRAMING_COBS
+        uint8_t framing;
+#ifdef CONFIG_ENABLE_STATS
+        hdlc_ll_stats_t stats;
+#endif
         struct
         {
             int (*state)(hdlc_ll_handle_t handle, const uint8_t *data, int len);
             // pointer to the next byte in frame buffer
             uint8_t *ptr;
             uint8_t escape;
+            // running crc over de-stuffed bytes, including crc field itself
+            crc_t crc;
             // pointer to the start of the frame buffer
             uint8_t *active_frame_buf;
+            // non-zero for RX slots, loaned to the application
+            uint8_t loaned[TINY_HDLC_RX_LOAN_SLOTS];
+            // COBS: data bytes left in current block
+            uint8_t cobs_left;
+            // COBS: non-zero if current block is followed by zero byte
+            uint8_t cobs_zero;
         } rx;
 
         struct
@@ -122,11 +156,24 @@ extern "C"
             int (*state)(hdlc_ll_handle_t handle);
             uint8_t *out_buffer;
             int out_buffer_len;
+            // first byte of the frame being sent, NULL if tx queue is empty
             const uint8_t *origin_data;
+            // current segment position
             const uint8_t *data;
             int len;
             crc_t crc;
             uint8_t escape;
+            uint8_t segment;
+            // queue[queue_head] is the frame being sent
+            uint8_t queue_head;
+            uint8_t queue_count;
+            // COBS: data bytes left in current block
+            uint8_t cobs_left;
+            // COBS: 1 if current block is followed by zero byte, 2 if that zero byte is already skipped
+            uint8_t cobs_zero;
+            // COBS: crc field of the frame, calculated before sending
+            uint8_t crc_field[4];
+            hdlc_ll_tx_frame_t queue[TINY_HDLC_TX_QUEUE_SIZE];
         } tx;
 #endif
     } hdlc_ll_data_t;
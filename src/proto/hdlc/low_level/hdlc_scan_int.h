@@ -0,0 +1,173 @@
+/*
+    Copyright 2025 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#pragma once
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * TINY_HDLC_SIMD can be set to 0 to force plain C scanning code even if
+ * the compiler targets a cpu with vector extensions.
+ */
+#ifndef TINY_HDLC_SIMD
+#define TINY_HDLC_SIMD 1
+#endif
+
+#if TINY_HDLC_SIMD && defined(__AVX2__)
+#define HDLC_SCAN_AVX2 1
+#endif
+#if TINY_HDLC_SIMD &&                                                                                                  \
+    (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define HDLC_SCAN_SSE2 1
+#endif
+#if TINY_HDLC_SIMD && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define HDLC_SCAN_NEON 1
+#endif
+
+#if defined(HDLC_SCAN_AVX2) || defined(HDLC_SCAN_SSE2)
+#include <immintrin.h>
+#endif
+#if defined(HDLC_SCAN_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define HDLC_SCAN_FLAG 0x7E
+#define HDLC_SCAN_ESCAPE 0x7D
+
+static inline int hdlc_scan_ctz(uint32_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/**
+ * Returns index of the first 0x7E or 0x7D byte in the block, or len if block
+ * doesn't contain any of them. The bytes before returned index can be copied
+ * to the output as is.
+ */
+static inline int hdlc_scan_special(const uint8_t *data, int len)
+{
+    int pos = 0;
+#if defined(HDLC_SCAN_AVX2)
+    const __m256i flag32 = _mm256_set1_epi8((char)HDLC_SCAN_FLAG);
+    const __m256i escape32 = _mm256_set1_epi8((char)HDLC_SCAN_ESCAPE);
+    for ( ; pos + 32 <= len; pos += 32 )
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(data + pos));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, flag32), _mm256_cmpeq_epi8(block, escape32)));
+        if ( mask )
+        {
+            return pos + hdlc_scan_ctz(mask);
+        }
+    }
+#endif
+#if defined(HDLC_SCAN_SSE2)
+    const __m128i flag16 = _mm_set1_epi8((char)HDLC_SCAN_FLAG);
+    const __m128i escape16 = _mm_set1_epi8((char)HDLC_SCAN_ESCAPE);
+    for ( ; pos + 16 <= len; pos += 16 )
+    {
+        __m128i block = _mm_loadu_si128((const __m128i *)(data + pos));
+        uint32_t mask =
+            (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, flag16), _mm_cmpeq_epi8(block, escape16)));
+        if ( mask )
+        {
+            return pos + hdlc_scan_ctz(mask);
+        }
+    }
+#elif defined(HDLC_SCAN_NEON)
+    const uint8x16_t flag16 = vdupq_n_u8(HDLC_SCAN_FLAG);
+    const uint8x16_t escape16 = vdupq_n_u8(HDLC_SCAN_ESCAPE);
+    for ( ; pos + 16 <= len; pos += 16 )
+    {
+        uint8x16_t block = vld1q_u8(data + pos);
+        uint8x16_t hits = vorrq_u8(vceqq_u8(block, flag16), vceqq_u8(block, escape16));
+        // Narrow 16 compare results to 4-bit groups in a 64-bit word
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+        if ( mask )
+        {
+            return pos + (__builtin_ctzll(mask) >> 2);
+        }
+    }
+#elif !defined(__AVR__)
+    // Word-at-a-time scanning for the cpus without vector extensions
+    const uint32_t ones = 0x01010101UL;
+    const uint32_t highs = 0x80808080UL;
+    for ( ; pos + 4 <= len; pos += 4 )
+    {
+        uint32_t word;
+        memcpy(&word, data + pos, sizeof(word));
+        uint32_t flags = word ^ (ones * HDLC_SCAN_FLAG);
+        uint32_t escapes = word ^ (ones * HDLC_SCAN_ESCAPE);
+        if ( (((flags - ones) & ~flags) | ((escapes - ones) & ~escapes)) & highs )
+        {
+            break;
+        }
+    }
+#endif
+    while ( pos < len && data[pos] != HDLC_SCAN_FLAG && data[pos] != HDLC_SCAN_ESCAPE )
+    {
+        pos++;
+    }
+    return pos;
+}
+
+/**
+ * Checks if the byte is set in the map of HDLC_ACCM_SIZE bytes
+ */
+static inline int hdlc_scan_in_map(const uint8_t *map, uint8_t byte)
+{
+    return map[byte >> 3] & (1 << (byte & 0x07));
+}
+
+/**
+ * Returns index of the first byte, which is set in the map, or len if block doesn't
+ * contain any of them. This is plain C version of hdlc_scan_special() for extended maps.
+ */
+static inline int hdlc_scan_map(const uint8_t *data, int len, const uint8_t *map)
+{
+    int pos = 0;
+    while ( pos < len && !hdlc_scan_in_map(map, data[pos]) )
+    {
+        pos++;
+    }
+    return pos;
+}
+
+#endif
@@ -36,6 +36,7 @@
 #define _TINY_LIGHT_H_
 
 #include "proto/hdlc/low_level/hdlc.h"
+#include "proto/hdlc/low_level/hdlc_int.h"
 #include "hal/tiny_types.h"
 
 #ifdef __cplusplus
@@ -55,9 +56,10 @@ extern "C"
  *************************************************************/
 
 /**
- * This macro defines buffer size required for tiny light protocol
+ * This macro defines buffer size required for tiny light protocol.
+ * The buffer holds hdlc low level state only, received frames are stored directly to user buffer.
  */
-#define LIGHT_BUF_SIZE (sizeof(uintptr_t) * 18)
+#define LIGHT_BUF_SIZE (sizeof(hdlc_ll_data_t))
 
     /**
      * This structure contains information about communication channel and its state.
@@ -78,6 +80,8 @@ extern "C"
         void *user_data;
         /// CRC type to use
         hdlc_crc_t crc_type;
+        /// Framing to use: HDLC_FRAMING_HDLC or HDLC_FRAMING_COBS
+        hdlc_framing_t framing;
     } STinyLightData;
 
     /**
@@ -0,0 +1,265 @@
+/*
+    Copyright 2025 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include "tiny_lz.h"
+
+#include <string.h>
+
+// Minimum match length, shorter matches do not save space
+#define LZ_MIN_MATCH 4
+// LZ4 end of block rules: the last match starts at least 12 bytes before the end of the block,
+// and the last 5 bytes are always literals
+#define LZ_MF_LIMIT 12
+#define LZ_LAST_LITERALS 5
+// Maximum match offset
+#define LZ_MAX_OFFSET 0xFFFF
+// Length value in token, which means that extension bytes follow
+#define LZ_RUN_MASK 0x0F
+// After each 2^LZ_SKIP_TRIGGER bytes without matches compressor increases the step
+#define LZ_SKIP_TRIGGER 5
+
+static inline uint32_t lz_read32(const uint8_t *ptr)
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static inline uint16_t lz_hash(uint32_t value)
+{
+    return (uint16_t)((value * 2654435761U) >> (32 - CONFIG_TINY_LZ_HASH_BITS));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Writes token length extension bytes. Returns NULL if there is no space in the buffer.
+ */
+static uint8_t *lz_put_length(uint8_t *dst, const uint8_t *end, int len)
+{
+    for ( ; len >= 0xFF; len -= 0xFF )
+    {
+        if ( dst >= end )
+        {
+            return NULL;
+        }
+        *dst++ = 0xFF;
+    }
+    if ( dst >= end )
+    {
+        return NULL;
+    }
+    *dst++ = (uint8_t)len;
+    return dst;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Writes sequence of literals, followed by the match. match_len is 0 for the last sequence.
+ * Returns NULL if there is no space in the buffer.
+ */
+static uint8_t *lz_put_sequence(uint8_t *dst, const uint8_t *end, const uint8_t *literals, int literals_len,
+                                uint16_t offset, int match_len)
+{
+    if ( dst >= end )
+    {
+        return NULL;
+    }
+    uint8_t *token = dst++;
+    *token = (uint8_t)((literals_len < LZ_RUN_MASK ? literals_len : LZ_RUN_MASK) << 4);
+    if ( literals_len >= LZ_RUN_MASK && !(dst = lz_put_length(dst, end, literals_len - LZ_RUN_MASK)) )
+    {
+        return NULL;
+    }
+    if ( literals_len > end - dst )
+    {
+        return NULL;
+    }
+    memcpy(dst, literals, literals_len);
+    dst += literals_len;
+    if ( !match_len )
+    {
+        return dst;
+    }
+    if ( end - dst < 2 )
+    {
+        return NULL;
+    }
+    *dst++ = (uint8_t)offset;
+    *dst++ = (uint8_t)(offset >> 8);
+    match_len -= LZ_MIN_MATCH;
+    *token |= (uint8_t)(match_len < LZ_RUN_MASK ? match_len : LZ_RUN_MASK);
+    if ( match_len >= LZ_RUN_MASK && !(dst = lz_put_length(dst, end, match_len - LZ_RUN_MASK)) )
+    {
+        return NULL;
+    }
+    return dst;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int tiny_lz_compress(const uint8_t *src, int len, uint8_t *dst, int dst_size, uint16_t *table)
+{
+    if ( len < 0 || len > LZ_MAX_OFFSET )
+    {
+        return TINY_ERR_INVALID_DATA;
+    }
+    const uint8_t *end = dst + dst_size;
+    uint8_t *out = dst;
+    int anchor = 0;
+    int pos = 0;
+    // Blocks shorter than TINY_LZ_MIN_LENGTH are sent as literals only
+    const int match_start_limit = len - LZ_MF_LIMIT;
+    const int match_end_limit = len - LZ_LAST_LITERALS;
+    while ( pos <= match_start_limit )
+    {
+        uint32_t value = lz_read32(src + pos);
+        uint16_t hash = lz_hash(value);
+        int candidate = table[hash];
+        table[hash] = (uint16_t)pos;
+        // The table is not cleared between blocks: entries, left by previous blocks, and hash
+        // collisions are rejected by verifying the candidate
+        if ( candidate >= pos || lz_read32(src + candidate) != value )
+        {
+            // Incompressible data are skipped faster
+            pos += 1 + ((pos - anchor) >> LZ_SKIP_TRIGGER);
+            continue;
+        }
+        int match_len = LZ_MIN_MATCH;
+        while ( pos + match_len < match_end_limit && src[candidate + match_len] == src[pos + match_len] )
+        {
+            match_len++;
+        }
+        out = lz_put_sequence(out, end, src + anchor, pos - anchor, (uint16_t)(pos - candidate), match_len);
+        if ( !out )
+        {
+            return TINY_ERR_DATA_TOO_LARGE;
+        }
+        pos += match_len;
+        anchor = pos;
+    }
+    out = lz_put_sequence(out, end, src + anchor, len - anchor, 0, 0);
+    if ( !out )
+    {
+        return TINY_ERR_DATA_TOO_LARGE;
+    }
+    return (int)(out - dst);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Reads token length extension bytes. Returns -1 if compressed data are broken.
+ */
+static int lz_get_length(const uint8_t **src, const uint8_t *end)
+{
+    int len = 0;
+    uint8_t byte;
+    do
+    {
+        if ( *src >= end )
+        {
+            return -1;
+        }
+        byte = *(*src)++;
+        len += byte;
+    } while ( byte == 0xFF );
+    return len;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int tiny_lz_decompress(const uint8_t *src, int len, uint8_t *dst, int dst_size)
+{
+    const uint8_t *end = src + len;
+    uint8_t *out = dst;
+    uint8_t *out_end = dst + dst_size;
+    while ( src < end )
+    {
+        uint8_t token = *src++;
+        int literals_len = token >> 4;
+        if ( literals_len == LZ_RUN_MASK )
+        {
+            int ext = lz_get_length(&src, end);
+            if ( ext < 0 )
+            {
+                return TINY_ERR_INVALID_DATA;
+            }
+            literals_len += ext;
+        }
+        if ( literals_len > end - src || literals_len > out_end - out )
+        {
+            return TINY_ERR_INVALID_DATA;
+        }
+        memcpy(out, src, literals_len);
+        out += literals_len;
+        src += literals_len;
+        if ( src == end )
+        {
+            // The last sequence has literals only
+            break;
+        }
+        if ( end - src < 2 )
+        {
+            return TINY_ERR_INVALID_DATA;
+        }
+        int offset = src[0] | (src[1] << 8);
+        src += 2;
+        int match_len = token & LZ_RUN_MASK;
+        if ( match_len == LZ_RUN_MASK )
+        {
+            int ext = lz_get_length(&src, end);
+            if ( ext < 0 )
+            {
+                return TINY_ERR_INVALID_DATA;
+            }
+            match_len += ext;
+        }
+        match_len += LZ_MIN_MATCH;
+        if ( offset == 0 || offset > out - dst || match_len > out_end - out )
+        {
+            return TINY_ERR_INVALID_DATA;
+        }
+        const uint8_t *match = out - offset;
+        if ( offset >= match_len )
+        {
+            memcpy(out, match, match_len);
+            out += match_len;
+        }
+        else
+        {
+            // Overlapped match repeats last offset bytes
+            while ( match_len-- )
+            {
+                *out++ = *match++;
+            }
+        }
+    }
+    return (int)(out - dst);
+}
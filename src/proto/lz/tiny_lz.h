@@ -0,0 +1,88 @@
+/*
+    Copyright 2025 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include "hal/tiny_types.h"
+
+/**
+ * Number of bits in hash of the compressor match table. The table takes
+ * 2 << CONFIG_TINY_LZ_HASH_BITS bytes. Larger table finds more matches, the value
+ * doesn't affect compressed format, so stations may use different values.
+ * Hosted platforms default to 12.
+ */
+#ifndef CONFIG_TINY_LZ_HASH_BITS
+#define CONFIG_TINY_LZ_HASH_BITS 8
+#endif
+
+/** Size of the match table in bytes, required by tiny_lz_compress() */
+#define TINY_LZ_TABLE_SIZE (sizeof(uint16_t) << CONFIG_TINY_LZ_HASH_BITS)
+
+/** Minimum size of data, which can be compressed. Shorter blocks are stored as literals only */
+#define TINY_LZ_MIN_LENGTH 13
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * Compresses the block of data. Compressed format is LZ4 block format: sequences of
+     * literals and matches with 16-bit offsets, the last sequence has literals only.
+     * As LZ4 requires, the last 5 bytes of the block are literals, and the last match starts
+     * at least 12 bytes before the end of the block. Compressor doesn't use dynamic memory,
+     * and its speed doesn't depend much on the data.
+     *
+     * @param src data to compress
+     * @param len size of data in bytes, up to 65535
+     * @param dst buffer for compressed data
+     * @param dst_size size of the buffer
+     * @param table match table of TINY_LZ_TABLE_SIZE bytes, aligned to 2 bytes. The table
+     *        doesn't need to be initialized, and can be reused for the next blocks as is.
+     * @return size of compressed data
+     *         TINY_ERR_DATA_TOO_LARGE if compressed data do not fit the buffer
+     *         TINY_ERR_INVALID_DATA if len is out of range
+     */
+    extern int tiny_lz_compress(const uint8_t *src, int len, uint8_t *dst, int dst_size, uint16_t *table);
+
+    /**
+     * Decompresses the block, compressed by tiny_lz_compress().
+     *
+     * @param src compressed data
+     * @param len size of compressed data in bytes
+     * @param dst buffer for decompressed data
+     * @param dst_size size of the buffer
+     * @return size of decompressed data
+     *         TINY_ERR_INVALID_DATA if compressed data are broken or do not fit the buffer
+     */
+    extern int tiny_lz_decompress(const uint8_t *src, int len, uint8_t *dst, int dst_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+#
+# Generates lookup tables for src/proto/crc/tiny_crc.c
+#
+#   python3 tools/scripts/gen_crc_tables.py > src/proto/crc/tiny_crc_tables_int.h
+#
+# Table k of slicing-by-N set holds crc of byte i followed by k zero bytes.
+# Nibble tables hold crc of 4-bit values and are used on flash-constrained targets.
+# Fold constants are used by carry-less multiply kernels (tiny_crc_clmul.c): each
+# pair multiplies the low and the high 64-bit halves of 128-bit block to move
+# it 512 bits (4 parallel lanes) or 128 bits (single lane) forward.
+
+import sys
+
+SLICES = 16
+
+CRCS = [
+    # name, reflected polynomial, width, config option
+    ("32", 0xEDB88320, 32, "CONFIG_ENABLE_FCS32"),
+    ("16", 0x8408, 16, "CONFIG_ENABLE_FCS16"),
+    ("32c", 0x82F63B78, 32, "CONFIG_ENABLE_FCS32C"),
+]
+
+
+def crc_bits(value, poly, bits):
+    for _ in range(bits):
+        value = (value >> 1) ^ poly if value & 1 else value >> 1
+    return value
+
+
+def slicing_tables(poly, width):
+    mask = (1 << width) - 1
+    tables = [[crc_bits(i, poly, 8) for i in range(256)]]
+    for _ in range(1, SLICES):
+        prev = tables[-1]
+        tables.append([((v >> 8) ^ tables[0][v & 0xFF]) & mask for v in prev])
+    return tables
+
+
+def xpow_mod(exponent, poly, width):
+    full = (1 << width) | int(bin(poly)[2:].zfill(width)[::-1], 2)
+    value = 1
+    for _ in range(exponent):
+        value <<= 1
+        if value >> width & 1:
+            value ^= full
+    return value
+
+
+def reflect(value, width):
+    return int(bin(value)[2:].zfill(width)[::-1], 2)
+
+
+def fold_constants(poly, width):
+    constants = []
+    for distance in (512, 128):
+        constants.append(reflect(xpow_mod(distance + width, poly, width), width) << 1)
+        constants.append(reflect(xpow_mod(distance + width - 64, poly, width), width) << 1)
+    return constants
+
+
+def emit_values(out, values, width, indent):
+    per_line = 8 if width == 32 else 12
+    digits = width // 4
+    for i in range(0, len(values), per_line):
+        line = ", ".join("0x%0*x" % (digits, v) for v in values[i:i + per_line])
+        out.write("%s%s,\n" % (indent, line))
+
+
+def main():
+    out = sys.stdout
+    out.write("/* Generated by tools/scripts/gen_crc_tables.py, do not edit */\n\n")
+    out.write("#pragma once\n\n")
+    out.write("#ifndef DOXYGEN_SHOULD_SKIP_THIS\n\n")
+    for name, poly, width, option in CRCS:
+        ctype = "uint%d_t" % width
+        out.write("#ifdef %s\n\n" % option)
+        out.write("#if CONFIG_TINY_CRC_SLICING == 0\n\n")
+        out.write("static const %s fcstab_%s[16] = {\n" % (ctype, name))
+        emit_values(out, [crc_bits(i, poly, 4) for i in range(16)], width, "    ")
+        out.write("};\n\n")
+        out.write("#else\n\n")
+        out.write("static const %s fcstab_%s[CONFIG_TINY_CRC_SLICING][256] = {\n" % (ctype, name))
+        for k, table in enumerate(slicing_tables(poly, width)):
+            if k in (1, 4, 8):
+                if k != 1:
+                    out.write("#endif\n")
+                out.write("#if CONFIG_TINY_CRC_SLICING > %d\n" % k)
+            out.write("    {\n")
+            emit_values(out, table, width, "        ")
+            out.write("    },\n")
+        out.write("#endif\n")
+        out.write("};\n\n")
+        out.write("#endif\n\n")
+        out.write("#ifdef TINY_CRC_CLMUL\n\n")
+        out.write("static const uint64_t fcsfold_%s[4] = {\n" % name)
+        out.write("    %s,\n" % ", ".join("0x%xULL" % v for v in fold_constants(poly, width)))
+        out.write("};\n\n")
+        out.write("#endif\n\n")
+        out.write("#endif\n\n")
+    out.write("#endif\n")
+
+
+if __name__ == "__main__":
+    main()
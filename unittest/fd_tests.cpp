@@ -320,3 +320,342 @@ TEST(FD, on_connect_callback)
     }
     CHECK_EQUAL(false, connected);
 }
+
+static void on_block_frame_read(void *udata, uint8_t, uint8_t *data, int len)
+{
+    static_cast<std::vector<std::vector<uint8_t>> *>(udata)->emplace_back(data, data + len);
+}
+
+/**
+ * Two ABM stations, connected to each other in the same thread. Tests change the settings
+ * in init and buffer_size before begin(). If block_size is not 0, stations exchange the data
+ * in blocks of fixed size, otherwise all available data are passed at once.
+ */
+struct FdPair
+{
+    tiny_fd_init_t init[2]{};
+    int buffer_size;
+    int block_size = 0;
+    tiny_fd_handle_t fd[2] = {nullptr, nullptr};
+    std::vector<std::vector<uint8_t>> received[2];
+    std::vector<uint8_t> buffers[2];
+
+    FdPair(int mtu, int window)
+        : buffer_size(tiny_fd_buffer_size_by_mtu(mtu, window))
+    {
+        for ( int i = 0; i < 2; i++ )
+        {
+            init[i].pdata = &received[i];
+            init[i].on_read_cb = on_block_frame_read;
+            init[i].window_frames = window;
+            init[i].mtu = mtu;
+            init[i].send_timeout = 0;
+            init[i].retry_timeout = 100;
+            init[i].retries = 2;
+            init[i].mode = TINY_FD_MODE_ABM;
+            init[i].crc_type = HDLC_CRC_OFF;
+        }
+    }
+
+    ~FdPair()
+    {
+        for ( auto handle : fd )
+        {
+            if ( handle )
+            {
+                tiny_fd_close(handle);
+            }
+        }
+    }
+
+    int begin(int i)
+    {
+        buffers[i].resize(buffer_size);
+        init[i].buffer = buffers[i].data();
+        init[i].buffer_size = buffer_size;
+        int result = tiny_fd_init(&fd[i], &init[i]);
+        if ( result != TINY_SUCCESS )
+        {
+            fd[i] = nullptr;
+        }
+        return result;
+    }
+
+    void begin()
+    {
+        CHECK_EQUAL(TINY_SUCCESS, begin(0));
+        CHECK_EQUAL(TINY_SUCCESS, begin(1));
+    }
+
+    /**
+     * Passes the data in both directions. Returns the data, sent by the first station.
+     * Blocks are exchanged simultaneously as on full-duplex line, while the data are passed to
+     * the second station before the first station receives the answer.
+     */
+    std::vector<uint8_t> exchange()
+    {
+        std::vector<uint8_t> data[2];
+        if ( block_size )
+        {
+            for ( int i = 0; i < 2; i++ )
+            {
+                data[i].resize(block_size);
+                CHECK_EQUAL(block_size, tiny_fd_get_tx_block(fd[i], data[i].data(), block_size));
+            }
+            CHECK_EQUAL(TINY_SUCCESS, tiny_fd_on_rx_block(fd[1], data[0].data(), block_size));
+            CHECK_EQUAL(TINY_SUCCESS, tiny_fd_on_rx_block(fd[0], data[1].data(), block_size));
+            return data[0];
+        }
+        for ( int i = 0; i < 2; i++ )
+        {
+            data[i].resize(512);
+            data[i].resize(tiny_fd_get_tx_data(fd[i], data[i].data(), data[i].size(), 0));
+            CHECK_EQUAL(TINY_SUCCESS, tiny_fd_on_rx_data(fd[1 - i], data[i].data(), data[i].size()));
+        }
+        return data[0];
+    }
+
+    void connect()
+    {
+        for ( int i = 0; i < 1000 && (tiny_fd_get_status(fd[0]) != TINY_SUCCESS || tiny_fd_get_status(fd[1]) != TINY_SUCCESS); i++ )
+        {
+            exchange();
+            tiny_sleep(1);
+        }
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_get_status(fd[0]));
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_get_status(fd[1]));
+    }
+};
+
+TEST(FD, block_transport)
+{
+    for ( hdlc_framing_t framing : {HDLC_FRAMING_HDLC, HDLC_FRAMING_COBS} )
+    {
+        // Simulated full-duplex block channel: each exchange passes one block in both directions
+        FdPair pair(64, 4);
+        pair.block_size = 16;
+        for ( auto &init : pair.init )
+        {
+            init.retry_timeout = 20;
+            init.crc_type = HDLC_CRC_16;
+            init.framing = framing;
+        }
+        pair.begin();
+        pair.connect();
+        std::vector<std::vector<uint8_t>> messages = {{0x01, 0x02, 0x03}, std::vector<uint8_t>(40, 0xFF),
+                                                      std::vector<uint8_t>(20, 0x00), {0x7E, 0x7D}};
+        for ( auto &message : messages )
+        {
+            CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(pair.fd[0], message.data(), message.size(), 1000));
+        }
+        for ( int i = 0; i < 100 && pair.received[1].size() < messages.size(); i++ )
+        {
+            pair.exchange();
+        }
+        CHECK_TRUE(messages == pair.received[1]);
+        // Idle station sends blocks of fill bytes only
+        std::vector<uint8_t> block;
+        for ( int i = 0; i < 10; i++ )
+        {
+            block = pair.exchange();
+        }
+        CHECK_TRUE(std::vector<uint8_t>(pair.block_size, framing == HDLC_FRAMING_COBS ? 0x00 : 0xFF) == block);
+    }
+}
+
+TEST(FD, urgent_frame_preempts_bulk)
+{
+    for ( hdlc_framing_t framing : {HDLC_FRAMING_HDLC, HDLC_FRAMING_COBS} )
+    {
+        FdPair pair(128, 4);
+        pair.block_size = 16;
+        for ( auto &init : pair.init )
+        {
+            init.retry_timeout = 20;
+            init.crc_type = HDLC_CRC_16;
+            init.framing = framing;
+        }
+        pair.begin();
+        pair.connect();
+        std::vector<uint8_t> bulk1(120), bulk2(100, 0x55);
+        for ( size_t i = 0; i < bulk1.size(); i++ )
+        {
+            bulk1[i] = (uint8_t)(i + 1);
+        }
+        std::vector<uint8_t> urgent = {0xAA, 0x01, 0x02};
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(pair.fd[0], bulk1.data(), bulk1.size(), 1000));
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(pair.fd[0], bulk2.data(), bulk2.size(), 1000));
+        // Part of the first bulk frame is on the wire
+        for ( int i = 0; i < 3; i++ )
+        {
+            pair.exchange();
+        }
+        CHECK_EQUAL(0, pair.received[1].size());
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet_ex(pair.fd[0], TINY_FD_PRIMARY_ADDR, urgent.data(), urgent.size(),
+                                                         1000, TINY_FD_SEND_URGENT));
+        for ( int i = 0; i < 100 && pair.received[1].size() < 3; i++ )
+        {
+            pair.exchange();
+        }
+        // Without free hdlc queue slot, urgent frame can only bypass frames, waiting in the queue
+        std::vector<std::vector<uint8_t>> expected = {urgent, bulk1, bulk2};
+        if ( TINY_HDLC_TX_QUEUE_SIZE < 2 )
+        {
+            expected = {bulk1, urgent, bulk2};
+        }
+        CHECK_TRUE(expected == pair.received[1]);
+    }
+}
+
+TEST(FD, extended_mode)
+{
+    FdPair pair(16, 20);
+    for ( int i = 0; i < 2; i++ )
+    {
+        // Window of 20 frames is not supported in basic mode
+        CHECK_EQUAL(TINY_ERR_INVALID_DATA, pair.begin(i));
+        pair.init[i].extended = 1;
+    }
+    pair.begin();
+    pair.connect();
+    std::vector<std::vector<uint8_t>> messages;
+    for ( uint8_t i = 0; i < 15; i++ )
+    {
+        messages.push_back({i, i, i, i});
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(pair.fd[0], messages.back().data(), 4, 0));
+    }
+    // All frames are sent without confirmation: flag, address, 2-byte control field, payload and flag
+    uint8_t buf[512];
+    int len = tiny_fd_get_tx_data(pair.fd[0], buf, sizeof(buf), 0);
+    CHECK_EQUAL(15 * 9, len);
+    MEMCMP_EQUAL("\x7E\x01\x1C\x01\x0E\x0E\x0E\x0E\x7E", buf + 14 * 9, 9);
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_on_rx_data(pair.fd[1], buf, len));
+    for ( int i = 0; i < 10; i++ )
+    {
+        pair.exchange();
+    }
+    CHECK_TRUE(messages == pair.received[1]);
+}
+
+TEST(FD, selective_reject)
+{
+    // Second station either supports selective reject, or requests missing frames with REJ
+    for ( uint8_t peer_srej = 0; peer_srej < 2; peer_srej++ )
+    {
+        FdPair pair(16, 4);
+        pair.buffer_size += tiny_fd_srej_buffer_size(0, 16, 4);
+        pair.init[0].srej = 1;
+        pair.init[1].srej = peer_srej;
+        pair.begin();
+        pair.connect();
+        std::vector<std::vector<uint8_t>> messages;
+        for ( uint8_t i = 0; i < 4; i++ )
+        {
+            messages.push_back({i, i, i, i});
+            CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(pair.fd[0], messages.back().data(), 4, 0));
+        }
+        // Frames are flag, address, control field, payload and flag. The second frame is lost.
+        uint8_t buf[512];
+        int len = tiny_fd_get_tx_data(pair.fd[0], buf, sizeof(buf), 0);
+        CHECK_EQUAL(4 * 8, len);
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_on_rx_data(pair.fd[1], buf, 8));
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_on_rx_data(pair.fd[1], buf + 16, 16));
+        len = tiny_fd_get_tx_data(pair.fd[1], buf, sizeof(buf), 0);
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_on_rx_data(pair.fd[0], buf, len));
+        len = tiny_fd_get_tx_data(pair.fd[0], buf, sizeof(buf), 0);
+        if ( peer_srej )
+        {
+            // Only the lost frame N(S)=1 is resent
+            CHECK_EQUAL(8, len);
+            MEMCMP_EQUAL("\x7E\x01\x12\x01\x01\x01\x01\x7E", buf, 8);
+        }
+        else
+        {
+            // Go-back-N: all frames starting with the lost one are resent
+            CHECK_EQUAL(3 * 8, len);
+        }
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_on_rx_data(pair.fd[1], buf, len));
+        CHECK_TRUE(messages == pair.received[1]);
+    }
+}
+
+TEST(FD, reserve_and_commit)
+{
+    for ( uint8_t compression = 0; compression < 2; compression++ )
+    {
+        FdPair pair(16, 4);
+        pair.buffer_size += tiny_fd_compression_buffer_size(16, 4);
+        for ( auto &init : pair.init )
+        {
+            init.compression = compression;
+        }
+        pair.begin();
+        pair.connect();
+        CHECK_TRUE(tiny_fd_reserve(pair.fd[0], TINY_FD_PRIMARY_ADDR, 17, 0) == nullptr);
+        // Reserved slots take place in the window
+        uint8_t *slots[4];
+        for ( int i = 0; i < 4; i++ )
+        {
+            slots[i] = static_cast<uint8_t *>(tiny_fd_reserve(pair.fd[0], TINY_FD_PRIMARY_ADDR, 16, 0));
+            CHECK_TRUE(slots[i] != nullptr);
+        }
+        CHECK_TRUE(tiny_fd_reserve(pair.fd[0], TINY_FD_PRIMARY_ADDR, 16, 0) == nullptr);
+        CHECK_EQUAL(TINY_ERR_TIMEOUT, tiny_fd_send_packet(pair.fd[0], "A", 1, 0));
+        tiny_fd_cancel(pair.fd[0], slots[3]);
+        // Frames are sent in commit order
+        std::vector<std::vector<uint8_t>> messages = {{2, 2, 2}, {0}, {1, 1}};
+        for ( int i : {2, 0, 1} )
+        {
+            memset(slots[i], i, i + 1);
+        }
+        CHECK_EQUAL(TINY_ERR_DATA_TOO_LARGE, tiny_fd_commit(pair.fd[0], slots[2], 17));
+        CHECK_EQUAL(TINY_ERR_INVALID_DATA, tiny_fd_commit(pair.fd[0], slots[2], -1));
+        CHECK_EQUAL(TINY_ERR_INVALID_DATA, tiny_fd_commit(pair.fd[0], nullptr, 1));
+        tiny_fd_cancel(pair.fd[0], nullptr);
+        for ( int i : {2, 0, 1} )
+        {
+            CHECK_EQUAL(TINY_SUCCESS, tiny_fd_commit(pair.fd[0], slots[i], i + 1));
+        }
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(pair.fd[0], "A", 1, 0));
+        messages.push_back({'A'});
+        for ( int i = 0; i < 10; i++ )
+        {
+            pair.exchange();
+        }
+        CHECK_TRUE(messages == pair.received[1]);
+    }
+}
+
+TEST(FD, receiver_not_ready)
+{
+    FdPair pair(16, 4);
+    for ( auto &init : pair.init )
+    {
+        init.retry_timeout = 1000;
+    }
+    pair.begin();
+    pair.connect();
+    uint8_t buf[512];
+    std::vector<std::vector<uint8_t>> messages = {{1, 1, 1}, {2, 2}};
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(pair.fd[0], messages[0].data(), messages[0].size(), 0));
+    int len = tiny_fd_get_tx_data(pair.fd[0], buf, sizeof(buf), 0);
+    // Application becomes busy, while the frame is on the way, so it is dropped
+    tiny_fd_set_rx_ready(pair.fd[1], false);
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_on_rx_data(pair.fd[1], buf, len));
+    // RNR: flag, address, control field with N(R)=0, flag
+    len = tiny_fd_get_tx_data(pair.fd[1], buf, sizeof(buf), 0);
+    CHECK_TRUE(len >= 4);
+    MEMCMP_EQUAL("\x7E\x01\x15\x7E", buf, 4);
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_on_rx_data(pair.fd[0], buf, len));
+    // Sender doesn't send new frames and doesn't resend dropped one
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(pair.fd[0], messages[1].data(), messages[1].size(), 0));
+    CHECK_EQUAL(0, tiny_fd_get_tx_data(pair.fd[0], buf, sizeof(buf), 0));
+    CHECK_EQUAL(0, pair.received[1].size());
+    // Dropped frame is requested with REJ, when the application is ready
+    tiny_fd_set_rx_ready(pair.fd[1], true);
+    for ( int i = 0; i < 5; i++ )
+    {
+        pair.exchange();
+    }
+    CHECK_TRUE(messages == pair.received[1]);
+}
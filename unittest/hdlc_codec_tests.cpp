@@ -0,0 +1,184 @@
+/*
+    Copyright 2025 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+
+*/
+
+#include <algorithm>
+#include <vector>
+#include <CppUTest/TestHarness.h>
+#include "TinyHdlcCodec.h"
+#include "proto/hdlc/low_level/hdlc.h"
+
+TEST_GROUP(HdlcCodec)
+{
+    void setup() {}
+    void teardown() {}
+};
+
+typedef std::vector<std::vector<uint8_t>> frames_t;
+
+static std::vector<uint8_t> make_payload(int len, uint8_t seed)
+{
+    std::vector<uint8_t> payload(len);
+    for ( int i = 0; i < len; i++ )
+    {
+        // Includes flag, escape and fill bytes
+        payload[i] = (uint8_t)(i * 13 + seed + 0x7C);
+    }
+    return payload;
+}
+
+static void on_ll_frame(void *user_data, uint8_t *data, int len)
+{
+    static_cast<frames_t *>(user_data)->emplace_back(data, data + len);
+}
+
+/**
+ * Sends frames via hdlc_ll and via HdlcCodec, checks that both produce the same bytes,
+ * and that each side decodes the stream of the other one.
+ */
+template <hdlc_crc_t Crc> static void check_wire_compatibility()
+{
+    constexpr int mtu = 64;
+    typedef tinyproto::HdlcCodec<Crc, mtu, 2> Codec;
+    frames_t frames = {make_payload(1, 0), make_payload(mtu, 1), make_payload(17, 2), make_payload(2, 0x83)};
+
+    std::vector<uint8_t> ll_buf(hdlc_ll_get_buf_size_ex(mtu, Crc, 2));
+    frames_t ll_received;
+    hdlc_ll_init_t init{};
+    init.buf = ll_buf.data();
+    init.buf_size = ll_buf.size();
+    init.crc_type = Crc;
+    init.mtu = mtu;
+    init.on_frame_read = on_ll_frame;
+    init.user_data = &ll_received;
+    hdlc_ll_handle_t ll = nullptr;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&ll, &init));
+
+    std::vector<uint8_t> ll_stream;
+    std::vector<uint8_t> codec_stream;
+    for ( auto &frame : frames )
+    {
+        uint8_t out[Codec::MaxEncodedSize];
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(ll, frame.data(), frame.size()));
+        int len = hdlc_ll_run_tx(ll, out, sizeof(out));
+        ll_stream.insert(ll_stream.end(), out, out + len);
+        len = Codec::encode(frame.data(), frame.size(), out, sizeof(out));
+        CHECK_TRUE(len > 0);
+        codec_stream.insert(codec_stream.end(), out, out + len);
+    }
+    CHECK_EQUAL(ll_stream.size(), codec_stream.size());
+    MEMCMP_EQUAL(ll_stream.data(), codec_stream.data(), ll_stream.size());
+
+    // hdlc_ll shares flags between queued frames, codec must accept such stream too
+    frames_t expected = frames;
+    for ( auto &frame : frames )
+    {
+        uint8_t out[Codec::MaxEncodedSize * 2];
+        for ( int i = 0; i < 2 && hdlc_ll_put_frame(ll, frame.data(), frame.size()) == TINY_SUCCESS; i++ )
+        {
+            expected.push_back(frame);
+        }
+        int len = hdlc_ll_run_tx(ll, out, sizeof(out));
+        ll_stream.insert(ll_stream.end(), out, out + len);
+    }
+
+    Codec *codec = new Codec();
+    frames_t codec_received;
+    // Feed the stream in small chunks to split escape sequences and flags
+    for ( size_t pos = 0; pos < ll_stream.size(); pos += 3 )
+    {
+        int len = std::min<int>(3, ll_stream.size() - pos);
+        codec->decode(ll_stream.data() + pos, len,
+                      [&](uint8_t *data, int size) { codec_received.emplace_back(data, data + size); });
+    }
+    CHECK_EQUAL(0, codec->getRxErrors());
+    CHECK_TRUE(expected == codec_received);
+    delete codec;
+
+    for ( size_t pos = 0; pos < codec_stream.size(); )
+    {
+        int error;
+        pos += hdlc_ll_run_rx(ll, codec_stream.data() + pos, codec_stream.size() - pos, &error);
+        CHECK_EQUAL(TINY_SUCCESS, error);
+    }
+    CHECK_TRUE(frames == ll_received);
+    hdlc_ll_close(ll);
+}
+
+TEST(HdlcCodec, WireCompatibleWithHdlcLl)
+{
+    check_wire_compatibility<HDLC_CRC_OFF>();
+#ifdef CONFIG_ENABLE_CHECKSUM
+    check_wire_compatibility<HDLC_CRC_8>();
+#endif
+#ifdef CONFIG_ENABLE_FCS16
+    check_wire_compatibility<HDLC_CRC_16>();
+#endif
+#ifdef CONFIG_ENABLE_FCS32
+    check_wire_compatibility<HDLC_CRC_32>();
+#endif
+#ifdef CONFIG_ENABLE_FCS32C
+    check_wire_compatibility<HDLC_CRC_32C>();
+#endif
+}
+
+TEST(HdlcCodec, DropsBadFrames)
+{
+#ifdef CONFIG_ENABLE_FCS16
+    typedef tinyproto::HdlcCodec<HDLC_CRC_16, 8> Codec;
+    std::vector<uint8_t> payload = make_payload(8, 5);
+    uint8_t out[Codec::MaxEncodedSize];
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, Codec::encode(payload.data(), 9, out, sizeof(out)));
+    CHECK_EQUAL(TINY_ERR_DATA_TOO_LARGE, Codec::encode(payload.data(), 8, out, 8));
+    int len = Codec::encode(payload.data(), payload.size(), out, sizeof(out));
+    CHECK_TRUE(len > 0);
+
+    Codec codec;
+    int received = 0;
+    auto on_frame = [&](uint8_t *data, int size) {
+        CHECK_EQUAL(8, size);
+        MEMCMP_EQUAL(payload.data(), data, size);
+        received++;
+    };
+    // Garbage before the first flag is skipped
+    uint8_t garbage[] = {0x11, 0x7D, 0x22};
+    CHECK_EQUAL(0, codec.decode(garbage, sizeof(garbage), on_frame));
+    CHECK_EQUAL(1, codec.decode(out, len, on_frame));
+    // Corrupted frame
+    std::vector<uint8_t> corrupted(out, out + len);
+    corrupted[2] ^= 0x01;
+    CHECK_EQUAL(0, codec.decode(corrupted.data(), corrupted.size(), on_frame));
+    // Too long frame
+    std::vector<uint8_t> too_long(out, out + len);
+    too_long.insert(too_long.begin() + 2, 4, 0x55);
+    CHECK_EQUAL(0, codec.decode(too_long.data(), too_long.size(), on_frame));
+    CHECK_EQUAL(2, codec.getRxErrors());
+    CHECK_EQUAL(1, codec.decode(out, len, on_frame));
+    CHECK_EQUAL(2, received);
+#endif
+}
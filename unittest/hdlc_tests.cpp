@@ -27,6 +27,8 @@
 */
 
 #include <functional>
+#include <vector>
+#include <algorithm>
 #include <CppUTest/TestHarness.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -112,6 +114,20 @@ TEST(HDLC, crc32)
     CHECK_EQUAL(1, helper2.rx_count());
 }
 
+TEST(HDLC, crc32c)
+{
+    const char *txbuf = "This is CRC32C check";
+    FakeSetup conn;
+    TinyHdlcHelper helper1(&conn.endpoint1(), nullptr, nullptr, 1024, HDLC_CRC_32C);
+    TinyHdlcHelper helper2(
+        &conn.endpoint2(), [&txbuf](uint8_t *buf, int len) -> void { STRCMP_EQUAL(txbuf, (char *)buf); }, nullptr, 1024,
+        HDLC_CRC_32C);
+    int msg_size = strlen(txbuf) + 1;
+    helper1.send((uint8_t *)txbuf, msg_size, 100);
+    helper2.wait_until_rx_count(1, 100);
+    CHECK_EQUAL(1, helper2.rx_count());
+}
+
 TEST(HDLC, send_receive)
 {
     uint32_t bytes_sent = 0;
@@ -307,4 +323,888 @@ TEST(HDLC, check_buf_size_calculations)
     CHECK_EQUAL( sizeof(hdlc_ll_data_t) + 10 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size_ex(10, HDLC_CRC_8, 1) );
     CHECK_EQUAL( sizeof(hdlc_ll_data_t) + 11 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size_ex(10, HDLC_CRC_16, 1) );
     CHECK_EQUAL( sizeof(hdlc_ll_data_t) + 13 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size_ex(10, HDLC_CRC_32, 1) );
+    CHECK_EQUAL( sizeof(hdlc_ll_data_t) + 13 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size_ex(10, HDLC_CRC_32C, 1) );
+}
+
+static std::vector<uint8_t> reference_hdlc_encode(const std::vector<uint8_t> &payload)
+{
+    std::vector<uint8_t> out{0x7E};
+    for ( uint8_t byte : payload )
+    {
+        if ( byte == 0x7E || byte == 0x7D )
+        {
+            out.push_back(0x7D);
+            byte ^= 0x20;
+        }
+        out.push_back(byte);
+    }
+    out.push_back(0x7E);
+    return out;
+}
+
+TEST(HDLC, hdlc_ll_encoder_matches_reference)
+{
+    std::vector<uint8_t> payload(1500);
+    srand(12345);
+    for ( size_t i = 0; i < payload.size(); i++ )
+    {
+        // Make long clean runs as well as runs of special characters
+        int r = rand() % 64;
+        payload[i] = r == 0 ? 0x7E : (r == 1 ? 0x7D : (uint8_t)rand());
+        if ( i > 700 && i < 740 )
+            payload[i] = (i & 1) ? 0x7E : 0x7D;
+    }
+    std::vector<uint8_t> expected = reference_hdlc_encode(payload);
+    std::vector<uint8_t> hdlc_buf(hdlc_ll_get_buf_size_ex(payload.size(), HDLC_CRC_OFF, 1));
+    for ( int chunk : {1, 2, 3, 7, 16, 31, 64, 1000, 4096} )
+    {
+        hdlc_ll_init_t init{};
+        init.buf = hdlc_buf.data();
+        init.buf_size = hdlc_buf.size();
+        init.crc_type = HDLC_CRC_OFF;
+        init.mtu = payload.size();
+        hdlc_ll_handle_t handle = nullptr;
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&handle, &init));
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(handle, payload.data(), payload.size()));
+        std::vector<uint8_t> actual;
+        std::vector<uint8_t> out(chunk);
+        int len;
+        while ( (len = hdlc_ll_run_tx(handle, out.data(), chunk)) > 0 )
+        {
+            actual.insert(actual.end(), out.begin(), out.begin() + len);
+        }
+        CHECK_EQUAL(expected.size(), actual.size());
+        MEMCMP_EQUAL(expected.data(), actual.data(), expected.size());
+        hdlc_ll_close(handle);
+    }
+}
+
+static void on_reference_frame_read(void *user_data, uint8_t *data, int len)
+{
+    std::vector<uint8_t> *frames = static_cast<std::vector<uint8_t> *>(user_data);
+    frames->insert(frames->end(), data, data + len);
+}
+
+TEST(HDLC, hdlc_ll_decoder_matches_reference)
+{
+    std::vector<uint8_t> payload(1500);
+    srand(54321);
+    for ( size_t i = 0; i < payload.size(); i++ )
+    {
+        int r = rand() % 32;
+        payload[i] = r == 0 ? 0x7E : (r == 1 ? 0x7D : (uint8_t)rand());
+    }
+    std::vector<uint8_t> encoded = reference_hdlc_encode(payload);
+    // Put the same frame twice to check that decoder handles subsequent frames
+    encoded.insert(encoded.end(), encoded.begin(), encoded.end());
+    std::vector<uint8_t> hdlc_buf(hdlc_ll_get_buf_size_ex(payload.size(), HDLC_CRC_OFF, 2));
+    for ( int chunk : {1, 2, 5, 16, 33, 512, 4096} )
+    {
+        std::vector<uint8_t> received;
+        hdlc_ll_init_t init{};
+        init.on_frame_read = on_reference_frame_read;
+        init.user_data = &received;
+        init.buf = hdlc_buf.data();
+        init.buf_size = hdlc_buf.size();
+        init.crc_type = HDLC_CRC_OFF;
+        init.mtu = payload.size();
+        hdlc_ll_handle_t handle = nullptr;
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&handle, &init));
+        size_t pos = 0;
+        while ( pos < encoded.size() )
+        {
+            int len = std::min<int>(chunk, encoded.size() - pos);
+            pos += hdlc_ll_run_rx(handle, encoded.data() + pos, len, nullptr);
+        }
+        CHECK_EQUAL(payload.size() * 2, received.size());
+        MEMCMP_EQUAL(payload.data(), received.data(), payload.size());
+        MEMCMP_EQUAL(payload.data(), received.data() + payload.size(), payload.size());
+        hdlc_ll_close(handle);
+    }
+}
+
+TEST(HDLC, hdlc_ll_crc_checked_across_rx_chunks)
+{
+    std::vector<uint8_t> payload(300);
+    for ( size_t i = 0; i < payload.size(); i++ )
+    {
+        payload[i] = (uint8_t)(i * 7 + 0x70);
+    }
+    for ( hdlc_crc_t crc : {HDLC_CRC_8, HDLC_CRC_16, HDLC_CRC_32} )
+    {
+        std::vector<uint8_t> hdlc_buf(hdlc_ll_get_buf_size_ex(payload.size(), crc, 1));
+        std::vector<uint8_t> received;
+        hdlc_ll_init_t init{};
+        init.on_frame_read = on_reference_frame_read;
+        init.user_data = &received;
+        init.buf = hdlc_buf.data();
+        init.buf_size = hdlc_buf.size();
+        init.crc_type = crc;
+        init.mtu = payload.size();
+        hdlc_ll_handle_t handle = nullptr;
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&handle, &init));
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(handle, payload.data(), payload.size()));
+        std::vector<uint8_t> encoded(payload.size() * 2 + 16);
+        encoded.resize(hdlc_ll_run_tx(handle, encoded.data(), encoded.size()));
+        for ( int chunk : {1, 3, 64, 1000} )
+        {
+            for ( bool corrupt : {false, true} )
+            {
+                std::vector<uint8_t> data = encoded;
+                if ( corrupt )
+                {
+                    data[data.size() / 2] ^= 0x01;
+                }
+                received.clear();
+                int error = TINY_SUCCESS;
+                size_t pos = 0;
+                while ( pos < data.size() )
+                {
+                    int temp_error;
+                    int len = std::min<int>(chunk, data.size() - pos);
+                    pos += hdlc_ll_run_rx(handle, data.data() + pos, len, &temp_error);
+                    if ( temp_error != TINY_SUCCESS )
+                    {
+                        error = temp_error;
+                    }
+                }
+                if ( corrupt )
+                {
+                    CHECK_EQUAL(TINY_ERR_WRONG_CRC, error);
+                    CHECK_EQUAL(0, received.size());
+                }
+                else
+                {
+                    CHECK_EQUAL(TINY_SUCCESS, error);
+                    CHECK_EQUAL(payload.size(), received.size());
+                    MEMCMP_EQUAL(payload.data(), received.data(), payload.size());
+                }
+            }
+        }
+        hdlc_ll_close(handle);
+    }
+}
+
+TEST(HDLC, hdlc_ll_tx_crc_does_not_depend_on_chunk_size)
+{
+    std::vector<uint8_t> payload(257);
+    for ( size_t i = 0; i < payload.size(); i++ )
+    {
+        payload[i] = (uint8_t)(i * 13 + 0x7D);
+    }
+    for ( hdlc_crc_t crc : {HDLC_CRC_8, HDLC_CRC_16, HDLC_CRC_32} )
+    {
+        std::vector<uint8_t> hdlc_buf(hdlc_ll_get_buf_size_ex(payload.size(), crc, 1));
+        hdlc_ll_init_t init{};
+        init.buf = hdlc_buf.data();
+        init.buf_size = hdlc_buf.size();
+        init.crc_type = crc;
+        init.mtu = payload.size();
+        hdlc_ll_handle_t handle = nullptr;
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&handle, &init));
+        std::vector<uint8_t> expected(payload.size() * 2 + 16);
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(handle, payload.data(), payload.size()));
+        expected.resize(hdlc_ll_run_tx(handle, expected.data(), expected.size()));
+        for ( int chunk : {1, 2, 5, 100} )
+        {
+            std::vector<uint8_t> actual;
+            std::vector<uint8_t> out(chunk);
+            CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(handle, payload.data(), payload.size()));
+            int len;
+            while ( (len = hdlc_ll_run_tx(handle, out.data(), chunk)) > 0 )
+            {
+                actual.insert(actual.end(), out.begin(), out.begin() + len);
+            }
+            CHECK_EQUAL(expected.size(), actual.size());
+            MEMCMP_EQUAL(expected.data(), actual.data(), expected.size());
+        }
+        hdlc_ll_close(handle);
+    }
+}
+
+static void on_segmented_frame_sent(void *user_data, const uint8_t *data, int len)
+{
+    std::pair<const uint8_t *, int> *sent = static_cast<std::pair<const uint8_t *, int> *>(user_data);
+    *sent = {data, len};
+}
+
+TEST(HDLC, hdlc_ll_put_frame_v_matches_contiguous_frame)
+{
+    std::vector<uint8_t> payload(200);
+    for ( size_t i = 0; i < payload.size(); i++ )
+    {
+        payload[i] = (uint8_t)(i * 7 + 0x7C);
+    }
+    // Segments are copies of payload parts in separate buffers, one of them is empty
+    std::vector<uint8_t> header(payload.begin(), payload.begin() + 2);
+    std::vector<uint8_t> body(payload.begin() + 2, payload.end());
+    hdlc_ll_segment_t segments[] = {
+        {header.data(), (int)header.size()},
+        {nullptr, 0},
+        {body.data(), (int)body.size()},
+    };
+    for ( hdlc_crc_t crc : {HDLC_CRC_OFF, HDLC_CRC_8, HDLC_CRC_16, HDLC_CRC_32} )
+    {
+        std::pair<const uint8_t *, int> sent{nullptr, 0};
+        std::vector<uint8_t> hdlc_buf(hdlc_ll_get_buf_size_ex(payload.size(), crc, 1));
+        hdlc_ll_init_t init{};
+        init.buf = hdlc_buf.data();
+        init.buf_size = hdlc_buf.size();
+        init.crc_type = crc;
+        init.mtu = payload.size();
+        init.on_frame_send = on_segmented_frame_sent;
+        init.user_data = &sent;
+        hdlc_ll_handle_t handle = nullptr;
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&handle, &init));
+        std::vector<uint8_t> expected(payload.size() * 2 + 16);
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(handle, payload.data(), payload.size()));
+        expected.resize(hdlc_ll_run_tx(handle, expected.data(), expected.size()));
+        for ( int chunk : {1, 3, 64} )
+        {
+            std::vector<uint8_t> actual;
+            std::vector<uint8_t> out(chunk);
+            CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame_v(handle, segments, 3));
+            int len;
+            while ( (len = hdlc_ll_run_tx(handle, out.data(), chunk)) > 0 )
+            {
+                actual.insert(actual.end(), out.begin(), out.begin() + len);
+            }
+            CHECK_EQUAL(expected.size(), actual.size());
+            MEMCMP_EQUAL(expected.data(), actual.data(), expected.size());
+            CHECK_TRUE(sent.first == header.data());
+            CHECK_EQUAL((int)payload.size(), sent.second);
+        }
+        hdlc_ll_close(handle);
+    }
+}
+
+static void on_queued_frame_sent(void *user_data, const uint8_t *data, int len)
+{
+    static_cast<std::vector<std::vector<uint8_t>> *>(user_data)->emplace_back(data, data + len);
+}
+
+static void on_queued_frame_read(void *user_data, uint8_t *data, int len)
+{
+    static_cast<std::vector<std::vector<uint8_t>> *>(user_data)->emplace_back(data, data + len);
+}
+
+TEST(HDLC, hdlc_ll_tx_queue_shares_flags)
+{
+    std::vector<std::vector<uint8_t>> frames = {{0x01, 0x7E, 0x02}, {0x03, 0x04}, {0xFF, 0x05}};
+    std::vector<std::vector<uint8_t>> sent, received;
+    std::vector<uint8_t> tx_buf(hdlc_ll_get_buf_size_ex(16, HDLC_CRC_16, 1));
+    std::vector<uint8_t> rx_buf(hdlc_ll_get_buf_size_ex(16, HDLC_CRC_16, 2));
+    hdlc_ll_init_t init{};
+    init.buf = tx_buf.data();
+    init.buf_size = tx_buf.size();
+    init.crc_type = HDLC_CRC_16;
+    init.mtu = 16;
+    init.on_frame_send = on_queued_frame_sent;
+    init.user_data = &sent;
+    hdlc_ll_handle_t tx = nullptr;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &init));
+    init.buf = rx_buf.data();
+    init.buf_size = rx_buf.size();
+    init.on_frame_send = nullptr;
+    init.on_frame_read = on_queued_frame_read;
+    init.user_data = &received;
+    hdlc_ll_handle_t rx = nullptr;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&rx, &init));
+    for ( int i = 0; i < TINY_HDLC_TX_QUEUE_SIZE; i++ )
+    {
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(tx, frames[i % 2].data(), frames[i % 2].size()));
+    }
+    CHECK_EQUAL(TINY_ERR_BUSY, hdlc_ll_put_frame(tx, frames[2].data(), frames[2].size()));
+    uint8_t out[128];
+    int len = hdlc_ll_run_tx(tx, out, sizeof(out));
+    // All queued frames are sent by single call, and there is single flag between them
+    CHECK_EQUAL(TINY_HDLC_TX_QUEUE_SIZE + 1, (int)std::count(out, out + len, 0x7E));
+    CHECK_EQUAL(TINY_HDLC_TX_QUEUE_SIZE, (int)sent.size());
+    // Frame, starting with fill byte, is sent with its own opening flag
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(tx, frames[0].data(), frames[0].size()));
+    if ( TINY_HDLC_TX_QUEUE_SIZE == 1 )
+    {
+        len += hdlc_ll_run_tx(tx, out + len, sizeof(out) - len);
+    }
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(tx, frames[2].data(), frames[2].size()));
+    len += hdlc_ll_run_tx(tx, out + len, sizeof(out) - len);
+    CHECK_EQUAL(TINY_HDLC_TX_QUEUE_SIZE + 5, (int)std::count(out, out + len, 0x7E));
+    CHECK_EQUAL(TINY_HDLC_TX_QUEUE_SIZE + 2, (int)sent.size());
+    // hdlc_ll_run_rx() returns after each received frame
+    for ( int pos = 0; pos < len; )
+    {
+        int error;
+        int processed = hdlc_ll_run_rx(rx, out + pos, len - pos, &error);
+        CHECK_EQUAL(TINY_SUCCESS, error);
+        CHECK_TRUE(processed > 0);
+        pos += processed;
+    }
+    CHECK_EQUAL(sent.size(), received.size());
+    for ( size_t i = 0; i < sent.size(); i++ )
+    {
+        CHECK_TRUE(sent[i] == received[i]);
+    }
+    CHECK_TRUE(received.back() == frames[2]);
+    hdlc_ll_close(tx);
+    hdlc_ll_close(rx);
+}
+
+struct LoanTestContext
+{
+    hdlc_ll_handle_t handle;
+    std::vector<std::pair<uint8_t *, int>> loaned;
+    int loan_failures;
+};
+
+static void on_frame_read_loan(void *user_data, uint8_t *data, int len)
+{
+    LoanTestContext *ctx = static_cast<LoanTestContext *>(user_data);
+    if ( hdlc_ll_loan_frame(ctx->handle, data) == TINY_SUCCESS )
+    {
+        ctx->loaned.emplace_back(data, len);
+    }
+    else
+    {
+        ctx->loan_failures++;
+    }
+}
+
+TEST(HDLC, hdlc_ll_loaned_rx_frames)
+{
+    const int window = 3;
+    LoanTestContext ctx{};
+    std::vector<uint8_t> rx_buf(hdlc_ll_get_buf_size_ex(8, HDLC_CRC_16, window));
+    hdlc_ll_init_t init{};
+    init.buf = rx_buf.data();
+    init.buf_size = rx_buf.size();
+    init.crc_type = HDLC_CRC_16;
+    init.mtu = 8;
+    init.on_frame_read = on_frame_read_loan;
+    init.user_data = &ctx;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&ctx.handle, &init));
+    // Encodes 3-byte frame with separate tx handle and passes it to the receiver
+    auto receive = [&](uint8_t first) {
+        uint8_t frame[3] = {first, 0x02, 0x03};
+        std::vector<uint8_t> wire(32);
+        std::vector<uint8_t> tx_buf(hdlc_ll_get_buf_size_ex(8, HDLC_CRC_16, 1));
+        hdlc_ll_init_t tx_init{};
+        tx_init.buf = tx_buf.data();
+        tx_init.buf_size = tx_buf.size();
+        tx_init.crc_type = HDLC_CRC_16;
+        tx_init.mtu = 8;
+        hdlc_ll_handle_t tx = nullptr;
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &tx_init));
+        hdlc_ll_put_frame(tx, frame, sizeof(frame));
+        wire.resize(hdlc_ll_run_tx(tx, wire.data(), wire.size()));
+        hdlc_ll_close(tx);
+        int error;
+        CHECK_EQUAL((int)wire.size(), hdlc_ll_run_rx(ctx.handle, wire.data(), wire.size(), &error));
+        CHECK_EQUAL(TINY_SUCCESS, error);
+    };
+    // All slots except one can be loaned
+    for ( uint8_t i = 1; i <= window; i++ )
+    {
+        receive(i);
+    }
+    CHECK_EQUAL(window - 1, (int)ctx.loaned.size());
+    CHECK_EQUAL(1, ctx.loan_failures);
+    // Loaned frames are not overwritten by new frames
+    receive(0x10);
+    receive(0x11);
+    for ( size_t i = 0; i < ctx.loaned.size(); i++ )
+    {
+        CHECK_EQUAL(3, ctx.loaned[i].second);
+        CHECK_EQUAL(i + 1, ctx.loaned[i].first[0]);
+    }
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_release_frame(ctx.handle, ctx.loaned[0].first));
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, hdlc_ll_release_frame(ctx.handle, ctx.loaned[0].first));
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, hdlc_ll_loan_frame(ctx.handle, &window));
+    // Released slot can be loaned again
+    receive(0x12);
+    CHECK_EQUAL(window, (int)ctx.loaned.size());
+    CHECK_EQUAL(0x12, ctx.loaned.back().first[0]);
+    CHECK_EQUAL(2, ctx.loaned[1].first[0]);
+    hdlc_ll_close(ctx.handle);
+}
+
+TEST(HDLC, hdlc_ll_put_frame_v_invalid_segments)
+{
+    std::vector<uint8_t> hdlc_buf(hdlc_ll_get_buf_size_ex(16, HDLC_CRC_16, 1));
+    hdlc_ll_init_t init{};
+    init.buf = hdlc_buf.data();
+    init.buf_size = hdlc_buf.size();
+    init.crc_type = HDLC_CRC_16;
+    hdlc_ll_handle_t handle = nullptr;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&handle, &init));
+    uint8_t data[4] = {1, 2, 3, 4};
+    hdlc_ll_segment_t segments[TINY_HDLC_MAX_SEGMENTS + 1];
+    for ( auto &segment : segments )
+    {
+        segment = {data, sizeof(data)};
+    }
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, hdlc_ll_put_frame_v(handle, segments, TINY_HDLC_MAX_SEGMENTS + 1));
+    hdlc_ll_segment_t no_data = {nullptr, 4};
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, hdlc_ll_put_frame_v(handle, &no_data, 1));
+    // Frame of empty segments is accepted, but nothing is sent
+    hdlc_ll_segment_t empty = {data, 0};
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame_v(handle, &empty, 1));
+    uint8_t out[16];
+    CHECK_EQUAL(0, hdlc_ll_run_tx(handle, out, sizeof(out)));
+    hdlc_ll_close(handle);
+}
+
+#ifdef CONFIG_ENABLE_ACCM
+TEST(HDLC, hdlc_ll_accm_escapes_and_discards_bytes)
+{
+    uint8_t accm[HDLC_ACCM_SIZE] = {0};
+    HDLC_ACCM_ADD(accm, 0x00);
+    HDLC_ACCM_ADD(accm, 0x11);
+    HDLC_ACCM_ADD(accm, 0x13);
+    // 0x5E cannot be escaped and is ignored
+    HDLC_ACCM_ADD(accm, 0x5E);
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<uint8_t> tx_buf(hdlc_ll_get_buf_size_ex(128, HDLC_CRC_16, 1));
+    std::vector<uint8_t> rx_buf(hdlc_ll_get_buf_size_ex(128, HDLC_CRC_16, 1));
+    hdlc_ll_init_t init{};
+    init.buf = tx_buf.data();
+    init.buf_size = tx_buf.size();
+    init.mtu = 128;
+    init.crc_type = HDLC_CRC_16;
+    init.accm = accm;
+    hdlc_ll_handle_t tx = nullptr;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &init));
+    init.buf = rx_buf.data();
+    init.buf_size = rx_buf.size();
+    init.accm_flags = HDLC_ACCM_RX;
+    init.on_frame_read = on_queued_frame_read;
+    init.user_data = &frames;
+    hdlc_ll_handle_t rx = nullptr;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&rx, &init));
+
+    std::vector<uint8_t> payload;
+    for ( int i = 0; i < 64; i++ )
+    {
+        payload.push_back((uint8_t)(i * 7 + 0x0B));
+    }
+    payload.push_back(0x11);
+    payload.push_back(0x7E);
+    payload.push_back(0x5E);
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(tx, payload.data(), payload.size()));
+    uint8_t out[256];
+    int len = hdlc_ll_run_tx(tx, out, sizeof(out));
+    std::vector<uint8_t> wire;
+    for ( int i = 1; i < len - 1; i++ )
+    {
+        CHECK_TRUE(out[i] != 0x00 && out[i] != 0x11 && out[i] != 0x13 && out[i] != 0x7E);
+        wire.push_back(out[i]);
+        // Control characters, inserted by the line, are discarded even inside escape pairs
+        if ( out[i] == 0x7D || i % 9 == 0 )
+        {
+            wire.push_back(0x13);
+        }
+    }
+    wire.insert(wire.begin(), 0x7E);
+    wire.push_back(0x7E);
+    for ( size_t pos = 0; pos < wire.size(); )
+    {
+        int error;
+        pos += hdlc_ll_run_rx(rx, wire.data() + pos, wire.size() - pos, &error);
+        CHECK_EQUAL(TINY_SUCCESS, error);
+    }
+    CHECK_EQUAL(1, (int)frames.size());
+    CHECK_TRUE(payload == frames[0]);
+
+    // Without extra bytes in the map only 0x7E and 0x7D are escaped
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_set_accm(tx, nullptr, HDLC_ACCM_TX));
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(tx, payload.data(), payload.size()));
+    len = hdlc_ll_run_tx(tx, out, sizeof(out));
+    CHECK_TRUE(std::find(out, out + len, 0x11) != out + len);
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, hdlc_ll_set_accm(nullptr, accm, HDLC_ACCM_TX));
+    hdlc_ll_close(tx);
+    hdlc_ll_close(rx);
+}
+
+TEST(HDLC, hdlc_ll_accm_rejects_byte_with_escaped_pair)
+{
+    // 0x11 is sent as 0x7D 0x31, and receiver would discard 0x31 as inserted by the line
+    uint8_t accm[HDLC_ACCM_SIZE] = {0};
+    HDLC_ACCM_ADD(accm, 0x11);
+    HDLC_ACCM_ADD(accm, 0x31);
+    std::vector<uint8_t> buf(hdlc_ll_get_buf_size_ex(128, HDLC_CRC_16, 1));
+    hdlc_ll_init_t init{};
+    init.buf = buf.data();
+    init.buf_size = buf.size();
+    init.mtu = 128;
+    init.crc_type = HDLC_CRC_16;
+    init.accm = accm;
+    init.accm_flags = HDLC_ACCM_TX | HDLC_ACCM_RX;
+    hdlc_ll_handle_t handle = nullptr;
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, hdlc_ll_init(&handle, &init));
+    init.accm = nullptr;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&handle, &init));
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, hdlc_ll_set_accm(handle, accm, HDLC_ACCM_TX | HDLC_ACCM_RX));
+    // 0x7E and 0x5E are reserved, and do not conflict with each other
+    uint8_t reserved[HDLC_ACCM_SIZE] = {0};
+    HDLC_ACCM_ADD(reserved, 0x11);
+    HDLC_ACCM_ADD(reserved, 0x5E);
+    HDLC_ACCM_ADD(reserved, 0x7E);
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_set_accm(handle, reserved, HDLC_ACCM_TX | HDLC_ACCM_RX));
+    hdlc_ll_close(handle);
+}
+#else
+TEST(HDLC, hdlc_ll_accm_not_supported)
+{
+    uint8_t accm[HDLC_ACCM_SIZE] = {0};
+    HDLC_ACCM_ADD(accm, 0x7E);
+    std::vector<uint8_t> tx_buf(hdlc_ll_get_buf_size_ex(128, HDLC_CRC_16, 1));
+    hdlc_ll_init_t init{};
+    init.buf = tx_buf.data();
+    init.buf_size = tx_buf.size();
+    init.mtu = 128;
+    init.crc_type = HDLC_CRC_16;
+    // The map with 0x7E and 0x7D only doesn't need accm support
+    init.accm = accm;
+    hdlc_ll_handle_t tx = nullptr;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &init));
+    HDLC_ACCM_ADD(accm, 0x11);
+    CHECK_EQUAL(TINY_ERR_FAILED, hdlc_ll_set_accm(tx, accm, HDLC_ACCM_TX));
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_set_accm(tx, nullptr, HDLC_ACCM_TX));
+    hdlc_ll_close(tx);
+}
+#endif
+
+static std::vector<uint8_t> reference_cobs_encode(const std::vector<uint8_t> &payload)
+{
+    std::vector<uint8_t> out{0x00};
+    size_t code_pos = out.size();
+    out.push_back(0x01);
+    for ( size_t i = 0; i < payload.size(); i++ )
+    {
+        if ( payload[i] == 0x00 )
+        {
+            code_pos = out.size();
+            out.push_back(0x01);
+            continue;
+        }
+        out.push_back(payload[i]);
+        if ( ++out[code_pos] == 0xFF && i + 1 < payload.size() )
+        {
+            code_pos = out.size();
+            out.push_back(0x01);
+        }
+    }
+    out.push_back(0x00);
+    return out;
+}
+
+TEST(HDLC, hdlc_ll_cobs_framing)
+{
+    std::vector<std::vector<uint8_t>> payloads = {
+        {0x00}, {0x11, 0x00}, {0x00, 0x00, 0x7E}, std::vector<uint8_t>(254, 0x7D), std::vector<uint8_t>(255, 0xFF),
+        std::vector<uint8_t>(600, 0x00)};
+    payloads[4].push_back(0x00);
+    std::vector<uint8_t> random(1500);
+    srand(777);
+    for ( auto &byte : random )
+    {
+        byte = rand() % 8 == 0 ? 0x00 : (uint8_t)rand();
+    }
+    payloads.push_back(random);
+    std::vector<uint8_t> tx_buf(hdlc_ll_get_buf_size_ex(1500, HDLC_CRC_32, 1));
+    std::vector<uint8_t> rx_buf(hdlc_ll_get_buf_size_ex(1500, HDLC_CRC_32, 2));
+    for ( hdlc_crc_t crc : {HDLC_CRC_OFF, HDLC_CRC_16, HDLC_CRC_32} )
+    {
+        for ( int chunk : {1, 3, 64, 4096} )
+        {
+            std::vector<std::vector<uint8_t>> received;
+            hdlc_ll_init_t init{};
+            init.buf = tx_buf.data();
+            init.buf_size = tx_buf.size();
+            init.crc_type = crc;
+            init.mtu = 1500;
+            init.framing = HDLC_FRAMING_COBS;
+            hdlc_ll_handle_t tx = nullptr;
+            CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &init));
+            init.buf = rx_buf.data();
+            init.buf_size = rx_buf.size();
+            init.on_frame_read = on_queued_frame_read;
+            init.user_data = &received;
+            hdlc_ll_handle_t rx = nullptr;
+            CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&rx, &init));
+            std::vector<uint8_t> wire;
+            for ( auto &payload : payloads )
+            {
+                // Payload is split to two segments to check blocks crossing segment boundary
+                hdlc_ll_segment_t segments[2] = {{payload.data(), (int)payload.size() / 2},
+                                                 {payload.data() + payload.size() / 2,
+                                                  (int)(payload.size() - payload.size() / 2)}};
+                CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame_v(tx, segments, 2));
+                std::vector<uint8_t> frame;
+                std::vector<uint8_t> out(chunk);
+                int len;
+                while ( (len = hdlc_ll_run_tx(tx, out.data(), chunk)) > 0 )
+                {
+                    frame.insert(frame.end(), out.begin(), out.begin() + len);
+                }
+                CHECK_TRUE(std::find(frame.begin() + 1, frame.end() - 1, 0x00) == frame.end() - 1);
+                if ( crc == HDLC_CRC_OFF )
+                {
+                    CHECK_TRUE(reference_cobs_encode(payload) == frame);
+                }
+                // Overhead doesn't depend on data
+                CHECK_TRUE(frame.size() <= payload.size() + get_crc_field_size(crc) + 2 + 1 +
+                                               (payload.size() + get_crc_field_size(crc)) / 254);
+                wire.insert(wire.end(), frame.begin(), frame.end());
+            }
+            for ( size_t pos = 0; pos < wire.size(); )
+            {
+                int error;
+                pos += hdlc_ll_run_rx(rx, wire.data() + pos, std::min<int>(chunk, wire.size() - pos), &error);
+                CHECK_EQUAL(TINY_SUCCESS, error);
+            }
+            CHECK_TRUE(payloads == received);
+            // Block, cut by the delimiter, breaks the frame
+            uint8_t broken[] = {0x05, 0x11, 0x22, 0x00};
+            int error;
+            hdlc_ll_run_rx(rx, broken, sizeof(broken), &error);
+            CHECK_EQUAL(TINY_ERR_WRONG_CRC, error);
+            hdlc_ll_close(tx);
+            hdlc_ll_close(rx);
+        }
+    }
+}
+
+TEST(HDLC, hdlc_ll_hunt_skips_garbage_at_once)
+{
+    std::vector<std::vector<uint8_t>> received;
+    std::vector<uint8_t> buf(hdlc_ll_get_buf_size_ex(16, HDLC_CRC_OFF, 1));
+    hdlc_ll_init_t init{};
+    init.buf = buf.data();
+    init.buf_size = buf.size();
+    init.crc_type = HDLC_CRC_OFF;
+    init.mtu = 16;
+    init.on_frame_read = on_queued_frame_read;
+    init.user_data = &received;
+    hdlc_ll_handle_t handle = nullptr;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&handle, &init));
+    // Attached in the middle of the frame: the whole block without the flag is consumed by one call
+    std::vector<uint8_t> garbage(1000, 0x55);
+    int error;
+    CHECK_EQUAL((int)garbage.size(), hdlc_ll_run_rx(handle, garbage.data(), garbage.size(), &error));
+    CHECK_EQUAL(TINY_SUCCESS, error);
+    uint8_t stream[] = {0x11, 0x7D, 0xFF, 0x7E, 0x01, 0x02, 0x7E};
+    CHECK_EQUAL((int)sizeof(stream), hdlc_ll_run_rx(handle, stream, sizeof(stream), &error));
+    CHECK_EQUAL(1, (int)received.size());
+    CHECK_TRUE(std::vector<uint8_t>({0x01, 0x02}) == received[0]);
+    hdlc_ll_stats_t stats;
+    hdlc_ll_get_stats(handle, &stats);
+#ifdef CONFIG_ENABLE_STATS
+    CHECK_EQUAL(1003, (int)stats.discarded_bytes);
+#else
+    CHECK_EQUAL(0, (int)stats.discarded_bytes);
+#endif
+    hdlc_ll_close(handle);
+}
+
+static bool on_address_filter(void *udata, uint8_t address)
+{
+    (void)udata;
+    return address == 0x03 || address == 0x7D || address == 0x00;
+}
+
+TEST(HDLC, hdlc_ll_address_filter_skips_foreign_frames)
+{
+    // Frames share flags, address 0x7D is escaped
+    std::vector<uint8_t> hdlc_stream = {0x7E, 0x05, 0xAA, 0x7E, 0x7D, 0x5D, 0x01, 0x7E, 0x03, 0x02, 0x7E,
+                                        0x05, 0x7D, 0x5E, 0xBB, 0x7E, 0x03, 0x04, 0x7E};
+    std::vector<std::vector<uint8_t>> payloads = {{0x05, 0xAA}, {0x7D, 0x01}, {0x03, 0x02}, {0x05, 0x7E, 0xBB},
+                                                  {0x03, 0x04}, {0x05, 0x00}, {0x00, 0x05}};
+    std::vector<uint8_t> cobs_stream;
+    for ( auto &payload : payloads )
+    {
+        auto frame = reference_cobs_encode(payload);
+        cobs_stream.insert(cobs_stream.end(), frame.begin(), frame.end());
+    }
+    std::vector<uint8_t> buf(hdlc_ll_get_buf_size_ex(16, HDLC_CRC_OFF, 1));
+    for ( hdlc_framing_t framing : {HDLC_FRAMING_HDLC, HDLC_FRAMING_COBS} )
+    {
+        auto &stream = framing == HDLC_FRAMING_COBS ? cobs_stream : hdlc_stream;
+        for ( int chunk : {1, 2, 64} )
+        {
+            std::vector<std::vector<uint8_t>> received;
+            hdlc_ll_init_t init{};
+            init.buf = buf.data();
+            init.buf_size = buf.size();
+            init.crc_type = HDLC_CRC_OFF;
+            init.mtu = 16;
+            init.framing = framing;
+            init.on_frame_read = on_queued_frame_read;
+            init.address_filter = on_address_filter;
+            init.user_data = &received;
+            hdlc_ll_handle_t handle = nullptr;
+            CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&handle, &init));
+            // hdlc_ll_run_rx() returns after each received frame
+            for ( size_t i = 0; i < stream.size(); )
+            {
+                int len = std::min<int>(chunk, stream.size() - i);
+                int error;
+                int result = hdlc_ll_run_rx(handle, stream.data() + i, len, &error);
+                CHECK_EQUAL(TINY_SUCCESS, error);
+                i += result;
+            }
+            std::vector<std::vector<uint8_t>> expected = {{0x7D, 0x01}, {0x03, 0x02}, {0x03, 0x04}};
+            if ( framing == HDLC_FRAMING_COBS )
+            {
+                expected.push_back({0x00, 0x05});
+            }
+            CHECK_TRUE(expected == received);
+            hdlc_ll_stats_t stats;
+            hdlc_ll_get_stats(handle, &stats);
+#ifdef CONFIG_ENABLE_STATS
+            CHECK_EQUAL(framing == HDLC_FRAMING_COBS ? 3 : 2, (int)stats.filtered_frames);
+#else
+            CHECK_EQUAL(0, (int)stats.filtered_frames);
+#endif
+            hdlc_ll_close(handle);
+        }
+    }
+}
+
+TEST(HDLC, hdlc_ll_run_rx_ring)
+{
+    std::vector<uint8_t> stream = {0x7E, 0x01, 0x7D, 0x5E, 0x02, 0x7E, 0x03, 0x04, 0x05, 0x7E, 0x7D, 0x5D, 0x7E};
+    std::vector<std::vector<uint8_t>> received;
+    std::vector<uint8_t> buf(hdlc_ll_get_buf_size_ex(16, HDLC_CRC_OFF, 2));
+    hdlc_ll_init_t init{};
+    init.buf = buf.data();
+    init.buf_size = buf.size();
+    init.crc_type = HDLC_CRC_OFF;
+    init.mtu = 16;
+    init.on_frame_read = on_queued_frame_read;
+    init.user_data = &received;
+    hdlc_ll_handle_t handle = nullptr;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&handle, &init));
+    // Ring size is not multiple of chunk size, so frames and escape pairs wrap at different positions
+    uint8_t ring[7];
+    int head = 0;
+    int tail = 0;
+    for ( size_t i = 0; i < stream.size(); i += 4 )
+    {
+        for ( size_t j = i; j < std::min(i + 4, stream.size()); j++ )
+        {
+            ring[head] = stream[j];
+            head = (head + 1) % sizeof(ring);
+        }
+        while ( tail != head )
+        {
+            int error;
+            tail = hdlc_ll_run_rx_ring(handle, ring, sizeof(ring), head, tail, &error);
+            CHECK_EQUAL(TINY_SUCCESS, error);
+        }
+    }
+    CHECK_TRUE(std::vector<std::vector<uint8_t>>({{0x01, 0x7E, 0x02}, {0x03, 0x04, 0x05}, {0x7D}}) == received);
+    int error;
+    CHECK_EQUAL(3, hdlc_ll_run_rx_ring(handle, ring, sizeof(ring), 7, 3, &error));
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, error);
+    hdlc_ll_close(handle);
+}
+
+#if TINY_HDLC_TX_QUEUE_SIZE >= 2
+TEST(HDLC, hdlc_ll_preempt_aborts_current_frame)
+{
+    std::vector<uint8_t> bulk(200);
+    for ( size_t i = 0; i < bulk.size(); i++ )
+    {
+        bulk[i] = (uint8_t)(i * 7);
+    }
+    std::vector<uint8_t> urgent = {0x11, 0x7E, 0x00};
+    std::vector<uint8_t> tx_buf(hdlc_ll_get_buf_size_ex(256, HDLC_CRC_16, 1));
+    std::vector<uint8_t> rx_buf(hdlc_ll_get_buf_size_ex(256, HDLC_CRC_16, 2));
+    for ( hdlc_framing_t framing : {HDLC_FRAMING_HDLC, HDLC_FRAMING_COBS} )
+    {
+        // Preemption at different positions, including the middle of escape pair and crc field
+        for ( int position : {1, 2, 13, 70, 201, 203} )
+        {
+            std::vector<std::vector<uint8_t>> sent, received;
+            hdlc_ll_init_t init{};
+            init.buf = tx_buf.data();
+            init.buf_size = tx_buf.size();
+            init.crc_type = HDLC_CRC_16;
+            init.mtu = 256;
+            init.framing = framing;
+            init.on_frame_send = on_queued_frame_sent;
+            init.user_data = &sent;
+            hdlc_ll_handle_t tx = nullptr;
+            CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &init));
+            init.buf = rx_buf.data();
+            init.buf_size = rx_buf.size();
+            init.on_frame_send = nullptr;
+            init.on_frame_read = on_queued_frame_read;
+            init.user_data = &received;
+            hdlc_ll_handle_t rx = nullptr;
+            CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&rx, &init));
+            CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(tx, bulk.data(), bulk.size()));
+            std::vector<uint8_t> wire(1024);
+            int len = hdlc_ll_run_tx(tx, wire.data(), position);
+            hdlc_ll_segment_t segment = {urgent.data(), (int)urgent.size()};
+            CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_preempt(tx, &segment, 1));
+            // The rest goes byte by byte
+            for ( int result = 1; result > 0 && len < (int)wire.size(); len += result )
+            {
+                result = hdlc_ll_run_tx(tx, wire.data() + len, 1);
+            }
+            CHECK_TRUE(std::vector<std::vector<uint8_t>>({urgent, bulk}) == sent);
+            int errors = 0;
+            for ( int pos = 0; pos < len; )
+            {
+                int error;
+                pos += hdlc_ll_run_rx(rx, wire.data() + pos, len - pos, &error);
+                errors += error != TINY_SUCCESS;
+            }
+            CHECK_TRUE(std::vector<std::vector<uint8_t>>({urgent, bulk}) == received);
+            hdlc_ll_stats_t stats;
+            hdlc_ll_get_stats(rx, &stats);
+            if ( framing == HDLC_FRAMING_COBS )
+            {
+                // COBS receiver reports aborted frame as broken one, if its data were started
+                CHECK_TRUE(errors == 1 || (errors == 0 && position <= 2));
+            }
+            else
+            {
+                CHECK_EQUAL(0, errors);
+#ifdef CONFIG_ENABLE_STATS
+                CHECK_EQUAL(1, (int)stats.aborted_frames);
+#endif
+            }
+            hdlc_ll_close(tx);
+            hdlc_ll_close(rx);
+        }
+    }
+}
+#else
+TEST(HDLC, hdlc_ll_preempt_needs_free_queue_slot)
+{
+    std::vector<uint8_t> bulk(64, 0x33);
+    std::vector<uint8_t> urgent = {0x11, 0x7E, 0x00};
+    std::vector<uint8_t> tx_buf(hdlc_ll_get_buf_size_ex(256, HDLC_CRC_16, 1));
+    std::vector<std::vector<uint8_t>> sent;
+    hdlc_ll_init_t init{};
+    init.buf = tx_buf.data();
+    init.buf_size = tx_buf.size();
+    init.crc_type = HDLC_CRC_16;
+    init.mtu = 256;
+    init.on_frame_send = on_queued_frame_sent;
+    init.user_data = &sent;
+    hdlc_ll_handle_t tx = nullptr;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&tx, &init));
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put_frame(tx, bulk.data(), bulk.size()));
+    std::vector<uint8_t> wire(1024);
+    int len = hdlc_ll_run_tx(tx, wire.data(), 10);
+    hdlc_ll_segment_t segment = {urgent.data(), (int)urgent.size()};
+    // Single slot queue is occupied by the frame on the wire
+    CHECK_EQUAL(TINY_ERR_BUSY, hdlc_ll_preempt(tx, &segment, 1));
+    len += hdlc_ll_run_tx(tx, wire.data() + len, wire.size() - len);
+    CHECK_TRUE(std::vector<std::vector<uint8_t>>({bulk}) == sent);
+    hdlc_ll_close(tx);
 }
+#endif
@@ -29,6 +29,7 @@
 
 #include <CppUTest/TestHarness.h>
 #include "proto/crc/tiny_crc.h"
+#include <string.h>
 
 TEST_GROUP(TinyCrcTests)
 {
@@ -64,4 +65,80 @@ TEST(TinyCrcTests, Crc32)
     // Just check it doesn't match the initial CRC
     CHECK_TRUE(crc != PPPINITFCS32);
 #endif
-}
\ No newline at end of file
+}
+
+TEST(TinyCrcTests, Crc16CheckValue)
+{
+#ifdef CONFIG_ENABLE_FCS16
+    const uint8_t check[] = "123456789";
+    // CRC-16/X-25 check value
+    CHECK_EQUAL((uint16_t)0x906E, tiny_crc16(PPPINITFCS16, check, 9));
+#endif
+}
+
+TEST(TinyCrcTests, Crc32CheckValue)
+{
+#ifdef CONFIG_ENABLE_FCS32
+    const uint8_t check[] = "123456789";
+    // CRC-32 (ISO-HDLC) check value
+    CHECK_EQUAL((uint32_t)0xCBF43926, tiny_crc32(PPPINITFCS32, check, 9));
+#endif
+}
+
+TEST(TinyCrcTests, Crc32cCheckValue)
+{
+#ifdef CONFIG_ENABLE_FCS32C
+    const uint8_t check[] = "123456789";
+    // CRC-32C (Castagnoli) check value
+    CHECK_EQUAL((uint32_t)0xE3069283, tiny_crc32c(PPPINITFCS32C, check, 9));
+    // Running value over data followed by its crc field is always the same
+    uint8_t frame[13];
+    memcpy(frame, check, 9);
+    uint32_t crc = tiny_crc32c(PPPINITFCS32C, check, 9);
+    for ( int i = 0; i < 4; i++ )
+    {
+        frame[9 + i] = (uint8_t)(crc >> (8 * i));
+    }
+    CHECK_EQUAL((uint32_t)PPPGOODFCS32C, tiny_crc32c_update(PPPINITFCS32C, frame, sizeof(frame)));
+#endif
+}
+
+TEST(TinyCrcTests, CrcUpdateMatchesBytewise)
+{
+    uint8_t buf[200];
+    for ( unsigned i = 0; i < sizeof(buf); i++ )
+    {
+        buf[i] = (uint8_t)(i * 37 + 11);
+    }
+    // Every length and offset pair exercises block, folding and tail paths of the kernels
+    for ( int offset = 0; offset < 4; offset++ )
+    {
+        for ( int len = 0; len <= (int)sizeof(buf) - offset; len++ )
+        {
+#ifdef CONFIG_ENABLE_FCS16
+            uint16_t crc16 = PPPINITFCS16;
+            for ( int i = 0; i < len; i++ )
+            {
+                crc16 = crc16_byte(crc16, buf[offset + i]);
+            }
+            CHECK_EQUAL(crc16, tiny_crc16_update(PPPINITFCS16, buf + offset, len));
+#endif
+#ifdef CONFIG_ENABLE_FCS32
+            uint32_t crc32 = PPPINITFCS32;
+            for ( int i = 0; i < len; i++ )
+            {
+                crc32 = crc32_byte(crc32, buf[offset + i]);
+            }
+            CHECK_EQUAL(crc32, tiny_crc32_update(PPPINITFCS32, buf + offset, len));
+#endif
+#ifdef CONFIG_ENABLE_FCS32C
+            uint32_t crc32c = PPPINITFCS32C;
+            for ( int i = 0; i < len; i++ )
+            {
+                crc32c = crc32c_byte(crc32c, buf[offset + i]);
+            }
+            CHECK_EQUAL(crc32c, tiny_crc32c_update(PPPINITFCS32C, buf + offset, len));
+#endif
+        }
+    }
+}
@@ -33,6 +33,7 @@
 #include <string.h>
 #include <thread>
 #include <array>
+#include <vector>
 
 #include "proto/fd/tiny_fd.h"
 
@@ -67,8 +68,8 @@ TEST_GROUP(TINY_FD_ABM)
     }
 
     void onConnect(uint8_t, bool status) { connected = status; }
-    void onRead(uint8_t, uint8_t *, int) { }
-    void onSend(uint8_t, const uint8_t *, int) { }
+    void onRead(uint8_t, uint8_t *buf, int len) { readData.insert(readData.end(), buf, buf + len); }
+    void onSend(uint8_t, const uint8_t *buf, int len) { sentData.insert(sentData.end(), buf, buf + len); }
 
     static void __onConnect(void *udata, uint8_t address, bool connected)
     {
@@ -105,7 +106,10 @@ TEST_GROUP(TINY_FD_ABM)
 
     tiny_fd_handle_t handle = nullptr;
     bool connected = false;
-    std::array<uint8_t, 1024> inBuffer{};
+    std::vector<uint8_t> readData;
+    std::vector<uint8_t> sentData;
+    // Protocol buffer is sized for 33-byte mtu, so auto-selected mtu doesn't depend on protocol structures
+    std::vector<uint8_t> inBuffer = std::vector<uint8_t>(tiny_fd_buffer_size_by_mtu_ex(1, 33, 7, HDLC_CRC_OFF, 1));
     std::array<uint8_t, 1024> outBuffer{};
     std::function<void(tiny_fd_handle_t, tiny_fd_frame_direction_t,
                        tiny_fd_frame_type_t, tiny_fd_frame_subtype_t, uint8_t, uint8_t,
@@ -144,6 +148,34 @@ TEST_GROUP(TINY_FD_ABM)
         CHECK_EQUAL(TINY_SUCCESS, result);
     }
 
+    void reinitializeWithCompression(int mtu)
+    {
+        tiny_fd_close(handle); // Close the previous handle
+        tiny_fd_init_t init{};
+        init.pdata = this;
+        init.on_connect_event_cb = __onConnect;
+        init.on_read_cb = onRead;
+        init.on_send_cb = onSend;
+        init.log_frame_cb = logFrame;
+        init.window_frames = 7;
+        init.send_timeout = 1000;
+        init.retry_timeout = 100;
+        init.retries = 2;
+        init.mode = TINY_FD_MODE_ABM;
+        init.peers_count = 1;
+        init.crc_type = HDLC_CRC_OFF;
+        init.mtu = mtu;
+        init.compression = 1;
+        compressionBuffer.resize(tiny_fd_buffer_size_by_mtu_ex(1, mtu, 7, HDLC_CRC_OFF, 1) +
+                                 tiny_fd_compression_buffer_size(mtu, 7));
+        init.buffer = compressionBuffer.data();
+        init.buffer_size = compressionBuffer.size();
+        auto result = tiny_fd_init(&handle, &init);
+        CHECK_EQUAL(TINY_SUCCESS, result);
+        CHECK_EQUAL(mtu, tiny_fd_get_mtu(handle));
+    }
+
+    std::vector<uint8_t> compressionBuffer;
 };
 
 
@@ -287,6 +319,125 @@ TEST(TINY_FD_ABM, ABM_RunTxAPIVerification)
     CHECK_EQUAL(TINY_SUCCESS, len);
 }
 
+TEST(TINY_FD_ABM, ABM_RxRingAPIVerification)
+{
+    // SABM frame wraps around the end of the ring
+    uint8_t ring[8] = {0x2F, 0x7E, 0x00, 0x00, 0x00, 0x00, 0x7E, 0x03};
+    CHECK_EQUAL(2, tiny_fd_on_rx_ring(handle, ring, sizeof(ring), 2, 6));
+    int len = tiny_fd_get_tx_data(handle, outBuffer.data(), outBuffer.size(), 100);
+    CHECK_EQUAL(4, len);
+    CHECK_EQUAL(0x73, outBuffer[2]); // UA packet
+    // Ring parameters are checked even if there is no data to process
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, tiny_fd_on_rx_ring(handle, ring, 0, 0, 0));
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, tiny_fd_on_rx_ring(handle, ring, sizeof(ring), 8, 8));
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, tiny_fd_on_rx_ring(handle, nullptr, sizeof(ring), 2, 2));
+}
+
+#ifdef CONFIG_ENABLE_ACCM
+TEST(TINY_FD_ABM, ABM_NegotiateAccm)
+{
+    // SABM with capabilities: remote station requests XON/XOFF characters (0x11, 0x13) to be escaped
+    auto read_result = tiny_fd_on_rx_data(handle, (uint8_t *)"\x7E\x03\x2F\x01\x00\x00\x0A\x00\x7E", 9);
+    CHECK_EQUAL(TINY_SUCCESS, read_result);
+    CHECK(connected);
+    // UA frame carries local capabilities back
+    int len = tiny_fd_get_tx_data(handle, outBuffer.data(), outBuffer.size(), 100);
+    CHECK_EQUAL(9, len);
+    MEMCMP_EQUAL("\x7E\x01\x73\x01\x00\x00\x00\x00\x7E", outBuffer.data(), len);
+    // Requested characters are escaped in outgoing frames
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle, "\x11\x13\x12", 3, 100));
+    len = tiny_fd_get_tx_data(handle, outBuffer.data(), outBuffer.size(), 100);
+    CHECK_EQUAL(9, len);
+    MEMCMP_EQUAL("\x7E\x01\x10\x7D\x31\x7D\x33\x12\x7E", outBuffer.data(), len);
+    // After the first I-frame from remote station, raw XON/XOFF characters are discarded as line noise
+    read_result = tiny_fd_on_rx_data(handle, (uint8_t *)"\x7E\x03\x20\x41\x7E", 5);
+    CHECK_EQUAL(TINY_SUCCESS, read_result);
+    read_result = tiny_fd_on_rx_data(handle, (uint8_t *)"\x7E\x03\x22\x42\x13\x7D\x31\x11\x7E", 9);
+    CHECK_EQUAL(TINY_SUCCESS, read_result);
+    CHECK_EQUAL(3, (int)readData.size());
+    MEMCMP_EQUAL("\x41\x42\x11", readData.data(), readData.size());
+}
+#endif
+
+TEST(TINY_FD_ABM, ABM_CompressIFrames)
+{
+    reinitializeWithCompression(64);
+    // SABM with capabilities: remote station supports compression
+    auto read_result = tiny_fd_on_rx_data(handle, (uint8_t *)"\x7E\x03\x2F\x03\x00\x00\x00\x00\x7E", 9);
+    CHECK_EQUAL(TINY_SUCCESS, read_result);
+    CHECK(connected);
+    int len = tiny_fd_get_tx_data(handle, outBuffer.data(), outBuffer.size(), 100);
+    CHECK_EQUAL(9, len);
+#ifdef CONFIG_ENABLE_ACCM
+    MEMCMP_EQUAL("\x7E\x01\x73\x03\x00\x00\x00\x00\x7E", outBuffer.data(), len);
+#else
+    MEMCMP_EQUAL("\x7E\x01\x73\x02\x00\x00\x00\x00\x7E", outBuffer.data(), len);
+#endif
+    // 32 equal bytes are sent as one literal, one match and 5 literals at the end of the block
+    std::vector<uint8_t> payload(32, 'A');
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle, payload.data(), payload.size(), 100));
+    len = tiny_fd_get_tx_data(handle, outBuffer.data(), outBuffer.size(), 100);
+    CHECK_EQUAL(16, len);
+    MEMCMP_EQUAL("\x01\x1F\x41\x01\x00\x07\x50\x41\x41\x41\x41\x41\x7E", outBuffer.data() + 3, len - 3);
+    // Incompressible payload is sent as is after the flag
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle, "\x11\x12\x13", 3, 100));
+    len = tiny_fd_get_tx_data(handle, outBuffer.data(), outBuffer.size(), 100);
+    CHECK_EQUAL(8, len);
+    MEMCMP_EQUAL("\x00\x11\x12\x13\x7E", outBuffer.data() + 3, len - 3);
+    // Compressed and raw frames from remote station
+    read_result = tiny_fd_on_rx_data(handle, (uint8_t *)"\x7E\x03\x20\x01\x1F\x42\x01\x00\x0C\x00\x7E", 11);
+    CHECK_EQUAL(TINY_SUCCESS, read_result);
+    read_result = tiny_fd_on_rx_data(handle, (uint8_t *)"\x7E\x03\x42\x00\x43\x44\x7E", 7);
+    CHECK_EQUAL(TINY_SUCCESS, read_result);
+    CHECK_EQUAL(34, (int)readData.size());
+    CHECK_TRUE(std::vector<uint8_t>(32, 'B') == std::vector<uint8_t>(readData.begin(), readData.begin() + 32));
+    MEMCMP_EQUAL("CD", readData.data() + 32, 2);
+    // Confirmed frames are reported to the application as they were sent, without compression
+    CHECK_EQUAL(35, (int)sentData.size());
+    CHECK_TRUE(payload == std::vector<uint8_t>(sentData.begin(), sentData.begin() + 32));
+    MEMCMP_EQUAL("\x11\x12\x13", sentData.data() + 32, 3);
+}
+
+TEST(TINY_FD_ABM, ABM_CompressionNotSupportedByPeer)
+{
+    reinitializeWithCompression(64);
+    // SABM without capabilities, local capabilities are sent back anyway
+    auto read_result = tiny_fd_on_rx_data(handle, (uint8_t *)"\x7E\x03\x2F\x7E", 4);
+    CHECK_EQUAL(TINY_SUCCESS, read_result);
+    int len = tiny_fd_get_tx_data(handle, outBuffer.data(), outBuffer.size(), 100);
+    CHECK_EQUAL(9, len);
+    // I-frames have no compression flag, and full mtu payload fits the frame
+    std::vector<uint8_t> payload(64, 'A');
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle, payload.data(), payload.size(), 100));
+    len = tiny_fd_get_tx_data(handle, outBuffer.data(), outBuffer.size(), 100);
+    CHECK_EQUAL(68, len);
+    MEMCMP_EQUAL(payload.data(), outBuffer.data() + 3, 64);
+    read_result = tiny_fd_on_rx_data(handle, (uint8_t *)"\x7E\x03\x20\x01\x02\x7E", 6);
+    CHECK_EQUAL(TINY_SUCCESS, read_result);
+    CHECK_EQUAL(2, (int)readData.size());
+    MEMCMP_EQUAL("\x01\x02", readData.data(), 2);
+}
+
+TEST(TINY_FD_ABM, ABM_SendsQueuedFramesInOneCall)
+{
+    establishConnection();
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle, "\x01\x02", 2, 100));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle, "\x03\x04", 2, 100));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle, "\x05\x06", 2, 100));
+    // All queued frames fit the buffer
+    int len = tiny_fd_get_tx_data(handle, outBuffer.data(), outBuffer.size(), 100);
+    CHECK_EQUAL(18, len);
+    MEMCMP_EQUAL("\x7E\x01\x10\x01\x02\x7E\x7E\x01\x12\x03\x04\x7E\x7E\x01\x14\x05\x06\x7E", outBuffer.data(), len);
+    // The frame, which doesn't fit the buffer, is continued in the next call
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle, "\x07\x08", 2, 100));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle, "\x09\x0A", 2, 100));
+    len = tiny_fd_get_tx_data(handle, outBuffer.data(), 8, 100);
+    CHECK_EQUAL(8, len);
+    len = tiny_fd_get_tx_data(handle, outBuffer.data() + 8, outBuffer.size() - 8, 100);
+    CHECK_EQUAL(4, len);
+    MEMCMP_EQUAL("\x7E\x01\x16\x07\x08\x7E\x7E\x01\x18\x09\x0A\x7E", outBuffer.data(), 12);
+}
+
 TEST(TINY_FD_ABM, ABM_CheckMtuAPI)
 {
     // Check MTU API
@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <thread>
+#include <chrono>
 #include <array>
 
 #include "proto/fd/tiny_fd.h"
@@ -41,6 +42,11 @@ TEST_GROUP(TINY_FD_NRM)
     void setup()
     {
         connected = 0;
+        initHandle(100);
+    }
+
+    void initHandle(uint16_t retry_timeout)
+    {
         tiny_fd_init_t init{};
         init.pdata = this;
         init.addr = TINY_FD_PRIMARY_ADDR; // Primary station address
@@ -53,7 +59,7 @@ TEST_GROUP(TINY_FD_NRM)
         init.buffer_size = inBuffer.size();
         init.window_frames = 7;
         init.send_timeout = 1000;
-        init.retry_timeout = 100;
+        init.retry_timeout = retry_timeout;
         init.retries = 2;
         init.mode = TINY_FD_MODE_NRM;
         init.crc_type = HDLC_CRC_OFF;
@@ -106,7 +112,7 @@ TEST_GROUP(TINY_FD_NRM)
 
     tiny_fd_handle_t handle = nullptr;
     int connected = 0;
-    std::array<uint8_t, 1024> inBuffer{};
+    std::array<uint8_t, 2048> inBuffer{};
     std::array<uint8_t, 1024> outBuffer{};
     std::function<void(tiny_fd_handle_t, tiny_fd_frame_direction_t,
                        tiny_fd_frame_type_t, tiny_fd_frame_subtype_t, uint8_t, uint8_t,
@@ -196,6 +202,32 @@ TEST(TINY_FD_NRM, NRM_CheckUnitTestConnectionLogicForPrimary)
     CHECK_EQUAL(2, connected); // Connection should be established
 }
 
+TEST(TINY_FD_NRM, NRM_PrimaryPollsPeersInTurn)
+{
+    // Slow sending and short retry timeout make primary station to take the marker back
+    // right after each poll, in the same tiny_fd_get_tx_data() call
+    tiny_fd_close(handle);
+    initHandle(1);
+    logFrameFunc = [](tiny_fd_handle_t, tiny_fd_frame_direction_t direction, tiny_fd_frame_type_t,
+                      tiny_fd_frame_subtype_t, uint8_t, uint8_t, const uint8_t *, int) {
+        if ( direction == TINY_FD_FRAME_DIRECTION_OUT )
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    };
+    tiny_fd_register_peer(handle, 0x01);
+    tiny_fd_register_peer(handle, 0x02);
+    for ( int i = 0; i < 4; i++ )
+    {
+        int len = tiny_fd_get_tx_data(handle, outBuffer.data(), outBuffer.size(), 0);
+        CHECK_EQUAL(4, len);
+        CHECK_EQUAL(0x7E, outBuffer[0]); // Flag
+        CHECK_EQUAL((i & 1) ? 0x0B : 0x07, outBuffer[1]); // 0x01 and 0x02 peers in turn
+        CHECK_EQUAL(0x93, outBuffer[2]); // SNRM packet
+        CHECK_EQUAL(0x7E, outBuffer[3]); // Flag
+    }
+}
+
 TEST(TINY_FD_NRM, NRM_SecondaryDisconnection)
 {
     tiny_fd_register_peer(handle, 0x01);
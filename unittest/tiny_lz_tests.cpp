@@ -0,0 +1,119 @@
+/*
+    Copyright 2025 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include <CppUTest/TestHarness.h>
+#include "proto/lz/tiny_lz.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+TEST_GROUP(TinyLzTests)
+{
+    void setup() {}
+    void teardown() {}
+
+    std::vector<uint16_t> table = std::vector<uint16_t>(TINY_LZ_TABLE_SIZE / sizeof(uint16_t));
+
+    int roundtrip(const std::vector<uint8_t> &data)
+    {
+        std::vector<uint8_t> compressed(data.size() + data.size() / 255 + 16);
+        int len = tiny_lz_compress(data.data(), data.size(), compressed.data(), compressed.size(), table.data());
+        CHECK_TRUE(len > 0);
+        std::vector<uint8_t> decompressed(data.size());
+        CHECK_EQUAL((int)data.size(), tiny_lz_decompress(compressed.data(), len, decompressed.data(), decompressed.size()));
+        CHECK_TRUE(data == decompressed);
+        return len;
+    }
+};
+
+TEST(TinyLzTests, Roundtrip)
+{
+    roundtrip({});
+    roundtrip({0x55});
+    roundtrip(std::vector<uint8_t>(1000, 0x00));
+    // Telemetry-like records: mostly repeating fields with a changing counter
+    std::vector<uint8_t> telemetry;
+    for ( int i = 0; i < 64; i++ )
+    {
+        const char record[] = "{\"t\":21.5,\"h\":40,\"n\":";
+        telemetry.insert(telemetry.end(), record, record + sizeof(record) - 1);
+        telemetry.push_back('0' + i % 10);
+        telemetry.push_back('}');
+    }
+    CHECK_TRUE(roundtrip(telemetry) * 3 < (int)telemetry.size());
+    std::vector<uint8_t> random(4096);
+    srand(1);
+    for ( auto &byte : random )
+    {
+        byte = (uint8_t)rand();
+    }
+    roundtrip(random);
+}
+
+TEST(TinyLzTests, Lz4EndOfBlockRules)
+{
+    std::vector<uint8_t> data(100, 0x33);
+    std::vector<uint8_t> compressed(data.size() + 16);
+    // The table is not cleared between blocks, so garbage in it must not break the result
+    std::fill(table.begin(), table.end(), 0xFFFF);
+    int len = tiny_lz_compress(data.data(), data.size(), compressed.data(), compressed.size(), table.data());
+    // One literal, one match of 94 bytes and 5 literals at the end
+    CHECK_EQUAL(11, len);
+    MEMCMP_EQUAL("\x1F\x33\x01\x00\x4B\x50\x33\x33\x33\x33\x33", compressed.data(), len);
+    // Short blocks are stored as literals only
+    CHECK_EQUAL(TINY_LZ_MIN_LENGTH, tiny_lz_compress(data.data(), TINY_LZ_MIN_LENGTH - 1, compressed.data(),
+                                                     compressed.size(), table.data()));
+    CHECK_EQUAL((TINY_LZ_MIN_LENGTH - 1) << 4, compressed[0]);
+    std::fill(table.begin(), table.end(), 0x0005);
+    roundtrip(std::vector<uint8_t>(TINY_LZ_MIN_LENGTH, 0x44));
+}
+
+TEST(TinyLzTests, IncompressibleData)
+{
+    std::vector<uint8_t> random(256);
+    srand(2);
+    for ( auto &byte : random )
+    {
+        byte = (uint8_t)rand();
+    }
+    std::vector<uint8_t> compressed(random.size() - 1);
+    CHECK_EQUAL(TINY_ERR_DATA_TOO_LARGE,
+                tiny_lz_compress(random.data(), random.size(), compressed.data(), compressed.size(), table.data()));
+}
+
+TEST(TinyLzTests, BrokenData)
+{
+    uint8_t out[32];
+    // Match offset points before the start of the data
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, tiny_lz_decompress((const uint8_t *)"\x10\x41\x02\x00\x00", 5, out, sizeof(out)));
+    // Literals are cut
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, tiny_lz_decompress((const uint8_t *)"\x30\x41", 2, out, sizeof(out)));
+    // Data do not fit the buffer
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, tiny_lz_decompress((const uint8_t *)"\x1F\x41\x01\x00\x0C\x00", 6, out, 16));
+    CHECK_EQUAL(32, tiny_lz_decompress((const uint8_t *)"\x1F\x41\x01\x00\x0C\x00", 6, out, sizeof(out)));
+}